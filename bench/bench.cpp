@@ -0,0 +1,1173 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <unistd.h>
+
+#include <nlohmann/json.hpp>
+#include <SDL.h>
+
+#include "Array2D.h"
+#include "ChunkedGrid.h"
+#include "EventBus.h"
+#include "Font.h"
+#include "geometry.h"
+#include "map_generator.h"
+#include "Mauzling.h"
+#include "pathfinding.h"
+#include "regions.h"
+#include "RenderSnapshot.h"
+#include "TextureAtlas.h"
+#include "UnitGrid.h"
+#include "UnitPool.h"
+#include "Vec2.h"
+#include "WallBits.h"
+#include "WorkerPool.h"
+#include "WorldMap.h"
+
+using json = nlohmann::json;
+
+// globals normally owned by main.cpp
+SDL_Window* window = nullptr;
+SDL_Renderer* renderer = nullptr;
+std::unordered_map<std::string, Font*> fonts;
+TextureAtlas* texture_atlas = nullptr;
+
+static const char* BENCH_MAP = "maps/blah.json";
+static const int BENCH_NUM_UNITS = 10000;
+static const int BENCH_NUM_TICKS = 500;
+static const int BENCH_ORDER_INTERVAL = 24; // reissue orders about once a second
+static const int BENCH_SELECTION_UNITS = 5000;
+static const int BENCH_SELECTION_QUERIES = 1000;
+static const int BENCH_RAYS_MAP_SIZE = 256;
+static const int BENCH_NUM_RAYS = 200000;
+static const int BENCH_LOS_TARGETS = 100; // per origin, for the batched line of sight
+static const int BENCH_NUM_POSITIONS = 2000000;
+static const int BENCH_NUM_ASTAR_QUERIES = 500;
+static const int BENCH_PATH_BATCH_GROUPS = 8;   // batched queries: this many destinations per tick...
+static const int BENCH_PATH_BATCH_UNITS = 64;   // ...each ordered to this many units
+static const int BENCH_NUM_DRAW_FRAMES = 300;
+static const int BENCH_CONVEYOR_MAP_SIZE = 256;
+static const int BENCH_CONVEYOR_UNITS = 20000;
+static const int BENCH_CONVEYOR_TICKS = 100;
+static const char* BENCH_CONVEYOR_MAP = "bench_conveyor_map.json";
+static const int BENCH_CONVEYOR_TILE = 2;  // conveyor_left in assets/tile_data.json
+static const vec2<float> BENCH_CONVEYOR_SCROLL = {-8.0f, 0.0f};
+static const int BENCH_GENERATED_MAP_SIZE = 128; // WorldMap load builds the pathfinding graph, which is slow on big mazes
+static const char* BENCH_GENERATED_MAP = "bench_generated_map.json";
+static const int BENCH_CHUNK_MAP_SIZE = 4096;
+static const int BENCH_CHUNK_UNITS = 2000;
+static const int BENCH_CHUNK_CLUSTERS = 8;
+static const int BENCH_REGIONS_MAP_SIZE = 4096;
+static const int BENCH_REGIONS_ROOM_SIZE = 256;  // the "rooms" map is walled off into rooms this big
+static const int BENCH_REGIONS_EDITS = 100;
+static const int BENCH_REGIONS_EDIT_TILES = 8;
+static const int BENCH_CORNERS_MAP_SIZE = 4096;
+static const int BENCH_UPDATE_MAP_SIZE = 512;
+static const int BENCH_UPDATE_ROOM_SIZE = 64;  // walled off into rooms this big, so an edit only touches one region
+static const int BENCH_UPDATE_EDITS = 10;
+static const int BENCH_CHUNK_TICKS = 200;
+static const int BENCH_CORRIDOR_WIDTHS[] = {1, 2, 3};
+static const float BENCH_UNIT_RADII[] = {8.0f, 12.0f, 20.0f, 24.0f};
+
+struct BenchMapSize {
+    const char* name;
+    int size;
+};
+static const BenchMapSize BENCH_PREPROCESS_MAPS[] = {{"small", 64}, {"medium", 256}, {"huge", 512}};
+
+static double get_seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// the game logs to stdout from inside the hot paths, so mute it while we're timing (and keep stdout clean for the json)
+class QuietStdout {
+private:
+    int saved_fd;
+
+public:
+    QuietStdout() {
+        fflush(stdout);
+        saved_fd = dup(STDOUT_FILENO);
+        if (!freopen("/dev/null", "w", stdout))
+            saved_fd = -1;
+    }
+    ~QuietStdout() {
+        fflush(stdout);
+        if (saved_fd >= 0) {
+            dup2(saved_fd, STDOUT_FILENO);
+            close(saved_fd);
+        }
+    }
+};
+
+// value at fraction q of an already sorted list
+static double get_percentile(const std::vector<double>& sorted_values, double q) {
+    if (sorted_values.empty())
+        return 0.0;
+    size_t i = std::min(static_cast<size_t>(q * sorted_values.size()), sorted_values.size() - 1);
+    return sorted_values[i];
+}
+
+//
+// synthetic test maps: a walled border with rectangular pillars scattered on a 16 tile lattice, so every size
+// has roughly the same corridor structure and corner density
+//
+static Array2D<bool> make_bench_walls(int width, int height, unsigned int seed) {
+    std::mt19937 rng(seed);
+    Array2D<bool> wall_dat(width, height, false);
+    for (int x = 0; x < width; ++x) {
+        wall_dat[x][0] = true;
+        wall_dat[x][height-1] = true;
+    }
+    for (int y = 0; y < height; ++y) {
+        wall_dat[0][y] = true;
+        wall_dat[width-1][y] = true;
+    }
+    for (int cx = 0; cx + 16 <= width; cx += 16) {
+        for (int cy = 0; cy + 16 <= height; cy += 16) {
+            int w = 2 + rng() % 8;
+            int h = 2 + rng() % 8;
+            int x0 = cx + 3 + rng() % (11 - w + 2);
+            int y0 = cy + 3 + rng() % (11 - h + 2);
+            for (int x = x0; x < x0 + w && x < width - 1; ++x) {
+                for (int y = y0; y < y0 + h && y < height - 1; ++y)
+                    wall_dat[x][y] = true;
+            }
+        }
+    }
+    return wall_dat;
+}
+
+static vec2<int> get_random_open_position(const Array2D<bool>& wall_dat, std::mt19937& rng) {
+    while (true) {
+        vec2<int> pos = {static_cast<int>(rng() % (wall_dat.width() * GRIDSIZE)), static_cast<int>(rng() % (wall_dat.height() * GRIDSIZE))};
+        if (valid_player_position(pos, wall_dat))
+            return pos;
+    }
+}
+
+//
+// raw dda line of sight between random points (grid units)
+//
+static json bench_dda_rays() {
+    Array2D<bool> wall_dat = make_bench_walls(BENCH_RAYS_MAP_SIZE, BENCH_RAYS_MAP_SIZE, 1);
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> coord(1.0f, BENCH_RAYS_MAP_SIZE - 1.0f);
+    std::vector<vec2<float>> endpoints;
+    for (int i = 0; i < 2 * BENCH_NUM_RAYS; ++i)
+        endpoints.push_back({coord(rng), coord(rng)});
+
+    int num_visible = 0;
+    double start_time = get_seconds();
+    for (int i = 0; i < BENCH_NUM_RAYS; ++i)
+        num_visible += points_are_visible_to_eachother(endpoints[2*i], endpoints[2*i+1], wall_dat);
+    double elapsed = get_seconds() - start_time;
+
+    json out;
+    out["map_size"] = BENCH_RAYS_MAP_SIZE;
+    out["rays"] = BENCH_NUM_RAYS;
+    out["visible"] = num_visible;
+    out["rays_per_second"] = BENCH_NUM_RAYS / elapsed;
+    return out;
+}
+
+//
+// one origin against many targets: visible_from against a points_are_visible_to_eachother per ray, both on the
+// same packed walls
+//
+static json bench_los_batch() {
+    Array2D<bool> wall_dat = make_bench_walls(BENCH_RAYS_MAP_SIZE, BENCH_RAYS_MAP_SIZE, 1);
+    WallBits walls(wall_dat);
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> coord(1.0f, BENCH_RAYS_MAP_SIZE - 1.0f);
+    int num_origins = BENCH_NUM_RAYS / BENCH_LOS_TARGETS;
+    std::vector<vec2<float>> origins;
+    std::vector<vec2<float>> targets;
+    for (int i = 0; i < num_origins; ++i)
+        origins.push_back({coord(rng), coord(rng)});
+    for (int i = 0; i < num_origins * BENCH_LOS_TARGETS; ++i)
+        targets.push_back({coord(rng), coord(rng)});
+
+    std::vector<uint8_t> batch_visible(targets.size());
+    double start_time = get_seconds();
+    for (int i = 0; i < num_origins; ++i)
+        visible_from(origins[i], &targets[i * BENCH_LOS_TARGETS], BENCH_LOS_TARGETS, walls, &batch_visible[i * BENCH_LOS_TARGETS]);
+    double batch_time = get_seconds() - start_time;
+    std::vector<uint8_t> scalar_visible(targets.size());
+    start_time = get_seconds();
+    for (int i = 0; i < num_origins; ++i) {
+        for (int j = 0; j < BENCH_LOS_TARGETS; ++j) {
+            int k = i * BENCH_LOS_TARGETS + j;
+            scalar_visible[k] = points_are_visible_to_eachother(origins[i], targets[k], walls);
+        }
+    }
+    double scalar_time = get_seconds() - start_time;
+    int num_visible = 0;
+    for (uint8_t visible : batch_visible)
+        num_visible += visible;
+
+    json out;
+    out["map_size"] = BENCH_RAYS_MAP_SIZE;
+    out["rays"] = targets.size();
+    out["visible"] = num_visible;
+    out["batch_rays_per_second"] = targets.size() / batch_time;
+    out["scalar_rays_per_second"] = targets.size() / scalar_time;
+    out["matches_scalar"] = batch_visible == scalar_visible;
+    return out;
+}
+
+//
+// unit-vs-wall placement checks at random pixel positions
+//
+static json bench_valid_player_position() {
+    Array2D<bool> wall_dat = make_bench_walls(BENCH_RAYS_MAP_SIZE, BENCH_RAYS_MAP_SIZE, 1);
+    std::mt19937 rng(3);
+    std::vector<vec2<int>> positions;
+    for (int i = 0; i < BENCH_NUM_POSITIONS; ++i)
+        positions.push_back({static_cast<int>(rng() % (BENCH_RAYS_MAP_SIZE * GRIDSIZE)), static_cast<int>(rng() % (BENCH_RAYS_MAP_SIZE * GRIDSIZE))});
+
+    int num_valid = 0;
+    double start_time = get_seconds();
+    for (const vec2<int>& pos : positions)
+        num_valid += valid_player_position(pos, wall_dat);
+    double elapsed = get_seconds() - start_time;
+
+    json out;
+    out["checks"] = BENCH_NUM_POSITIONS;
+    out["valid"] = num_valid;
+    out["checks_per_second"] = BENCH_NUM_POSITIONS / elapsed;
+    return out;
+}
+
+//
+// units wandering around a huge map in a few clusters (like players spread over different obstacles), checking
+// every step against the map walls. run on the full Array2D and on a ChunkedGrid with the default budget
+//
+template <typename WallGrid>
+static double run_map_chunks_walk(const WallGrid& wall_dat,
+                                  const std::vector<vec2<int>>& start_positions,
+                                  const std::vector<vec2<int>>& steps,
+                                  long long& out_valid) {
+    std::vector<vec2<int>> positions = start_positions;
+    int map_pixels = wall_dat.width() * GRIDSIZE;
+    out_valid = 0;
+    double start_time = get_seconds();
+    for (int t = 0; t < BENCH_CHUNK_TICKS; ++t) {
+        for (int i = 0; i < BENCH_CHUNK_UNITS; ++i) {
+            vec2<int> next = positions[i] + steps[t * BENCH_CHUNK_UNITS + i];
+            next = {value_clamp(next.x, 0, map_pixels - 1), value_clamp(next.y, 0, map_pixels - 1)};
+            if (valid_player_position(next, wall_dat)) {
+                positions[i] = next;
+                out_valid += 1;
+            }
+        }
+    }
+    return get_seconds() - start_time;
+}
+
+static json bench_map_chunks() {
+    Array2D<bool> wall_dat = make_bench_walls(BENCH_CHUNK_MAP_SIZE, BENCH_CHUNK_MAP_SIZE, 1);
+    std::vector<bool> wall_vector(BENCH_CHUNK_MAP_SIZE * BENCH_CHUNK_MAP_SIZE);
+    for (int x = 0; x < BENCH_CHUNK_MAP_SIZE; ++x) {
+        for (int y = 0; y < BENCH_CHUNK_MAP_SIZE; ++y)
+            wall_vector[x + y * BENCH_CHUNK_MAP_SIZE] = wall_dat[x][y];
+    }
+    double start_time = get_seconds();
+    ChunkedGrid<bool> chunked_walls(BENCH_CHUNK_MAP_SIZE, BENCH_CHUNK_MAP_SIZE, wall_vector);
+    double encode_time = get_seconds() - start_time;
+
+    std::mt19937 rng(4);
+    std::vector<vec2<int>> cluster_centers;
+    for (int c = 0; c < BENCH_CHUNK_CLUSTERS; ++c)
+        cluster_centers.push_back(get_random_open_position(wall_dat, rng));
+    std::vector<vec2<int>> positions;
+    for (int i = 0; i < BENCH_CHUNK_UNITS; ++i) {
+        vec2<int> center = cluster_centers[i % BENCH_CHUNK_CLUSTERS];
+        positions.push_back({center.x + static_cast<int>(rng() % 1024) - 512, center.y + static_cast<int>(rng() % 1024) - 512});
+    }
+    // every tick each cluster drifts a little and every unit jitters around in it
+    std::vector<vec2<int>> steps;
+    for (int t = 0; t < BENCH_CHUNK_TICKS; ++t) {
+        std::vector<vec2<int>> drift;
+        for (int c = 0; c < BENCH_CHUNK_CLUSTERS; ++c)
+            drift.push_back({8 * (static_cast<int>(rng() % 7) - 3), 8 * (static_cast<int>(rng() % 7) - 3)});
+        for (int i = 0; i < BENCH_CHUNK_UNITS; ++i)
+            steps.push_back(drift[i % BENCH_CHUNK_CLUSTERS] + vec2<int>(static_cast<int>(rng() % 9) - 4, static_cast<int>(rng() % 9) - 4));
+    }
+
+    long long full_valid = 0;
+    long long chunked_valid = 0;
+    double full_time = run_map_chunks_walk(wall_dat, positions, steps, full_valid);
+    double chunked_time = run_map_chunks_walk(chunked_walls, positions, steps, chunked_valid);
+    ChunkStats stats = chunked_walls.get_stats();
+    double num_checks = static_cast<double>(BENCH_CHUNK_TICKS) * BENCH_CHUNK_UNITS;
+
+    json out;
+    out["map_size"] = BENCH_CHUNK_MAP_SIZE;
+    out["units"] = BENCH_CHUNK_UNITS;
+    out["ticks"] = BENCH_CHUNK_TICKS;
+    out["encode_ms"] = 1000.0 * encode_time;
+    out["full_ns_per_check"] = 1e9 * full_time / num_checks;
+    out["chunked_ns_per_check"] = 1e9 * chunked_time / num_checks;
+    out["matches_full_grid"] = full_valid == chunked_valid;
+    out["resident_chunks"] = stats.resident_chunks;
+    out["num_chunks"] = stats.num_chunks;
+    out["resident_bytes"] = stats.resident_bytes;
+    out["stored_bytes"] = stats.stored_bytes;
+    out["full_bytes"] = stats.full_bytes;
+    out["page_ins"] = stats.page_ins;
+    out["page_outs"] = stats.page_outs;
+    out["mean_page_in_us"] = stats.page_ins > 0 ? 1000.0 * stats.page_in_ms / stats.page_ins : 0.0;
+    out["max_page_in_us"] = 1000.0 * stats.max_page_in_ms;
+    return out;
+}
+
+//
+// region labelling on huge maps: the scanline union-find labeller against a flood fill, and relabelling after a
+// few tiles flip. once on an open map (every edit touches the one big region) and once walled off into rooms
+//
+static int flood_fill_regions(const Array2D<bool>& wall_dat, Array2D<int>& labels) {
+    int width = wall_dat.width();
+    int height = wall_dat.height();
+    labels = Array2D<int>(width, height, -1);
+    int num_regions = 0;
+    std::vector<vec2<int>> stack;
+    for (int x = 1; x < width - 1; ++x) {
+        for (int y = 1; y < height - 1; ++y) {
+            if (wall_dat[x][y] || labels[x][y] >= 0)
+                continue;
+            labels[x][y] = num_regions;
+            stack.push_back({x, y});
+            while (!stack.empty()) {
+                vec2<int> current = stack.back();
+                stack.pop_back();
+                for (const vec2<int>& dir : MOVE_DIR) {
+                    vec2<int> next = current + dir;
+                    if (next.x >= 0 && next.x < width && next.y >= 0 && next.y < height && !wall_dat[next.x][next.y] && labels[next.x][next.y] < 0) {
+                        labels[next.x][next.y] = num_regions;
+                        stack.push_back(next);
+                    }
+                }
+            }
+            num_regions += 1;
+        }
+    }
+    return num_regions;
+}
+
+static json run_region_labels(Array2D<bool>& wall_dat) {
+    json out;
+    double start_time = get_seconds();
+    WallBits walls(wall_dat);
+    out["pack_ms"] = 1000.0 * (get_seconds() - start_time);
+
+    Array2D<int> flood_labels;
+    start_time = get_seconds();
+    int flood_regions = flood_fill_regions(wall_dat, flood_labels);
+    out["flood_fill_ms"] = 1000.0 * (get_seconds() - start_time);
+
+    ChunkedGrid<int> labels;
+    std::vector<Rect> bounds;
+    start_time = get_seconds();
+    int num_regions = label_regions(walls, labels, bounds);
+    out["scanline_ms"] = 1000.0 * (get_seconds() - start_time);
+    bool matches = num_regions == flood_regions;
+    for (int x = 0; x < wall_dat.width() && matches; ++x) {
+        for (int y = 0; y < wall_dat.height() && matches; ++y)
+            matches = labels.get(x, y) == flood_labels[x][y];
+    }
+    out["regions"] = num_regions;
+    out["matches_flood_fill"] = matches;
+
+    // flip a few tiles in a clump at a time (like an obstacle opening a door)
+    std::mt19937 rng(6);
+    std::vector<int> touched_ids;
+    double relabel_time = 0.0;
+    for (int e = 0; e < BENCH_REGIONS_EDITS; ++e) {
+        vec2<int> center = {1 + static_cast<int>(rng() % (wall_dat.width() - 2)), 1 + static_cast<int>(rng() % (wall_dat.height() - 2))};
+        std::vector<vec2<int>> changed;
+        for (int k = 0; k < BENCH_REGIONS_EDIT_TILES; ++k) {
+            vec2<int> tile = {value_clamp(center.x + static_cast<int>(rng() % 5) - 2, 0, wall_dat.width() - 1),
+                              value_clamp(center.y + static_cast<int>(rng() % 5) - 2, 0, wall_dat.height() - 1)};
+            bool is_wall = !walls.get(tile.x, tile.y);
+            walls.set(tile.x, tile.y, is_wall);
+            wall_dat[tile.x][tile.y] = is_wall;
+            changed.push_back(tile);
+        }
+        start_time = get_seconds();
+        relabel_regions(walls, changed, labels, bounds, touched_ids);
+        relabel_time += get_seconds() - start_time;
+    }
+    out["relabel_ms_per_edit"] = 1000.0 * relabel_time / BENCH_REGIONS_EDITS;
+    return out;
+}
+
+static json bench_region_labels() {
+    json out;
+    Array2D<bool> wall_dat = make_bench_walls(BENCH_REGIONS_MAP_SIZE, BENCH_REGIONS_MAP_SIZE, 7);
+    out["map_size"] = BENCH_REGIONS_MAP_SIZE;
+    out["edits"] = BENCH_REGIONS_EDITS;
+    out["open"] = run_region_labels(wall_dat);
+    for (int i = 0; i < BENCH_REGIONS_MAP_SIZE; i += BENCH_REGIONS_ROOM_SIZE) {
+        for (int j = 0; j < BENCH_REGIONS_MAP_SIZE; ++j) {
+            wall_dat[i][j] = true;
+            wall_dat[j][i] = true;
+        }
+    }
+    out["rooms"] = run_region_labels(wall_dat);
+    return out;
+}
+
+//
+// corner node detection on a huge map: packed rows against the tile by tile scan
+//
+static json bench_corner_nodes() {
+    Array2D<bool> wall_dat = make_bench_walls(BENCH_CORNERS_MAP_SIZE, BENCH_CORNERS_MAP_SIZE, 8);
+    double start_time = get_seconds();
+    WallBits walls(wall_dat);
+    double pack_time = get_seconds() - start_time;
+    start_time = get_seconds();
+    std::vector<CornerNode> packed_nodes = get_corner_nodes(walls);
+    double packed_time = get_seconds() - start_time;
+    start_time = get_seconds();
+    std::vector<CornerNode> scalar_nodes = get_corner_nodes_scalar(wall_dat);
+    double scalar_time = get_seconds() - start_time;
+    bool matches = packed_nodes.size() == scalar_nodes.size();
+    for (size_t i = 0; i < packed_nodes.size() && matches; ++i) {
+        matches = packed_nodes[i].position == scalar_nodes[i].position &&
+                  packed_nodes[i].blocked_corners == scalar_nodes[i].blocked_corners;
+    }
+
+    json out;
+    out["map_size"] = BENCH_CORNERS_MAP_SIZE;
+    out["nodes"] = packed_nodes.size();
+    out["pack_ms"] = 1000.0 * pack_time;
+    out["packed_ms"] = 1000.0 * packed_time;
+    out["scalar_ms"] = 1000.0 * scalar_time;
+    out["matches_scalar"] = matches;
+    return out;
+}
+
+//
+// full preprocessing (regions, clearance, corner graph) on increasingly large maps
+//
+static json bench_pathfinding_data() {
+    json out;
+    for (const BenchMapSize& map_size : BENCH_PREPROCESS_MAPS) {
+        Array2D<bool> wall_dat = make_bench_walls(map_size.size, map_size.size, 4);
+        PathfindingData pf_data;
+        double start_time = get_seconds();
+        {
+            QuietStdout quiet;
+            pf_data = get_pathfinding_data(WallBits(wall_dat));
+        }
+        double elapsed = get_seconds() - start_time;
+        size_t num_nodes = 0;
+        size_t num_edges = 0;
+        const PathfindingGraph& pf_graph = pf_data.radius_classes[0];
+        for (const RegionGraph& region_graph : pf_graph.regions) {
+            num_nodes += region_graph.nodes.size();
+            num_edges += region_graph.neighbours.size() / 2;
+        }
+        json entry;
+        entry["map_size"] = map_size.size;
+        entry["seconds"] = elapsed;
+        entry["regions"] = pf_graph.num_regions;
+        entry["nodes"] = num_nodes;
+        entry["edges"] = num_edges;
+        entry["graph_bytes"] = get_pathfinding_graph_bytes(pf_graph);
+        out[map_size.name] = entry;
+        fprintf(stderr, "  get_pathfinding_data %s: %.3f s\n", map_size.name, elapsed);
+    }
+    return out;
+}
+
+//
+// what the pathfinding grids of a huge map take: packed walls, chunked region ids and clearance, against the
+// full map int grids they replaced
+//
+static json bench_pathfinding_memory() {
+    Array2D<bool> wall_dat = make_bench_walls(BENCH_REGIONS_MAP_SIZE, BENCH_REGIONS_MAP_SIZE, 7);
+    double start_time = get_seconds();
+    WallBits walls(wall_dat);
+    double pack_time = get_seconds() - start_time;
+    ChunkedGrid<int> labels;
+    std::vector<Rect> bounds;
+    start_time = get_seconds();
+    label_regions(walls, labels, bounds);
+    double label_time = get_seconds() - start_time;
+    start_time = get_seconds();
+    ChunkedGrid<uint8_t> clearance = get_clearance_map(walls);
+    double clearance_time = get_seconds() - start_time;
+    ChunkStats label_stats = labels.get_stats();
+    ChunkStats clearance_stats = clearance.get_stats();
+
+    json out;
+    out["map_size"] = BENCH_REGIONS_MAP_SIZE;
+    out["pack_ms"] = 1000.0 * pack_time;
+    out["label_ms"] = 1000.0 * label_time;
+    out["clearance_ms"] = 1000.0 * clearance_time;
+    out["walls_bytes"] = walls.get_bytes();
+    out["labels_bytes"] = label_stats.stored_bytes + label_stats.resident_bytes;
+    out["clearance_bytes"] = clearance_stats.stored_bytes + clearance_stats.resident_bytes;
+    out["full_int_grid_bytes"] = static_cast<size_t>(BENCH_REGIONS_MAP_SIZE) * BENCH_REGIONS_MAP_SIZE * sizeof(int);
+    return out;
+}
+
+//
+// a tile flipping inside one room of a map walled off into rooms: update_pathfinding_data against building
+// everything again, and whether both come out the same
+//
+static json bench_pathfinding_update() {
+    Array2D<bool> wall_dat = make_bench_walls(BENCH_UPDATE_MAP_SIZE, BENCH_UPDATE_MAP_SIZE, 5);
+    for (int i = 0; i < BENCH_UPDATE_MAP_SIZE; i += BENCH_UPDATE_ROOM_SIZE) {
+        for (int j = 0; j < BENCH_UPDATE_MAP_SIZE; ++j) {
+            wall_dat[i][j] = true;
+            wall_dat[j][i] = true;
+        }
+    }
+    std::vector<float> unit_radii = {PLAYER_RADIUS, 1.5f * PLAYER_RADIUS, 2.5f * PLAYER_RADIUS};
+    PathfindingData pf_data;
+    double start_time = get_seconds();
+    {
+        QuietStdout quiet;
+        pf_data = get_pathfinding_data(WallBits(wall_dat), unit_radii);
+    }
+    double full_time = get_seconds() - start_time;
+    std::mt19937 rng(11);
+    double update_time = 0.0;
+    for (int e = 0; e < BENCH_UPDATE_EDITS; ++e) {
+        vec2<int> tile = {1 + static_cast<int>(rng() % (BENCH_UPDATE_MAP_SIZE - 2)), 1 + static_cast<int>(rng() % (BENCH_UPDATE_MAP_SIZE - 2))};
+        wall_dat[tile.x][tile.y] = !wall_dat[tile.x][tile.y];
+        start_time = get_seconds();
+        {
+            QuietStdout quiet;
+            update_pathfinding_data(pf_data, wall_dat, {tile}, unit_radii);
+        }
+        update_time += get_seconds() - start_time;
+    }
+    PathfindingData rebuilt;
+    {
+        QuietStdout quiet;
+        rebuilt = get_pathfinding_data(WallBits(wall_dat), unit_radii);
+    }
+    // the update hands out region ids its own way, so each class's regions are matched up by their tiles
+    bool matches = true;
+    for (int x = 0; x < BENCH_UPDATE_MAP_SIZE; ++x) {
+        for (int y = 0; y < BENCH_UPDATE_MAP_SIZE; ++y)
+            matches = matches && pf_data.clearance.get(x, y) == rebuilt.clearance.get(x, y);
+    }
+    for (size_t c = 0; c < unit_radii.size(); ++c) {
+        const PathfindingGraph& pf_graph = pf_data.radius_classes[c];
+        const PathfindingGraph& rebuilt_graph = rebuilt.radius_classes[c];
+        std::vector<int> rebuilt_id(pf_graph.num_regions, -1);
+        std::vector<int> updated_id(rebuilt_graph.num_regions, -1);
+        for (int x = 0; x < BENCH_UPDATE_MAP_SIZE; ++x) {
+            for (int y = 0; y < BENCH_UPDATE_MAP_SIZE; ++y) {
+                int id = pf_graph.tile_2_region_id.get(x, y);
+                int other = rebuilt_graph.tile_2_region_id.get(x, y);
+                matches = matches && (id < 0) == (other < 0);
+                if (id < 0 || other < 0)
+                    continue;
+                if (rebuilt_id[id] < 0 && updated_id[other] < 0) {
+                    rebuilt_id[id] = other;
+                    updated_id[other] = id;
+                }
+                matches = matches && rebuilt_id[id] == other;
+            }
+        }
+        for (int r = 0; r < pf_graph.num_regions; ++r) {
+            const RegionGraph& region_graph = pf_graph.regions[r];
+            if (rebuilt_id[r] < 0) {
+                matches = matches && region_graph.nodes.empty();
+                continue;
+            }
+            const RegionGraph& other = rebuilt_graph.regions[rebuilt_id[r]];
+            matches = matches && region_graph.nodes == other.nodes && region_graph.positions == other.positions &&
+                      region_graph.edge_starts == other.edge_starts && region_graph.neighbours == other.neighbours &&
+                      region_graph.dists == other.dists;
+        }
+    }
+
+    json out;
+    out["map_size"] = BENCH_UPDATE_MAP_SIZE;
+    out["regions"] = pf_data.radius_classes[0].num_regions;
+    out["full_ms"] = 1000.0 * full_time;
+    out["update_ms_per_edit"] = 1000.0 * update_time / BENCH_UPDATE_EDITS;
+    out["matches_full"] = matches;
+    return out;
+}
+
+//
+// start/end attachment + a* on the medium map, latency distribution per query
+//
+static json bench_astar() {
+    Array2D<bool> wall_dat = make_bench_walls(256, 256, 4);
+    PathfindingData pf_data;
+    {
+        QuietStdout quiet;
+        pf_data = get_pathfinding_data(WallBits(wall_dat));
+    }
+    std::mt19937 rng(5);
+    std::vector<double> latencies;
+    size_t num_found = 0;
+    {
+        QuietStdout quiet;
+        for (int q = 0; q < BENCH_NUM_ASTAR_QUERIES; ++q) {
+            vec2<int> start_pos = get_random_open_position(wall_dat, rng);
+            vec2<int> end_pos = get_random_open_position(wall_dat, rng);
+            double start_time = get_seconds();
+            std::vector<vec2<int>> waypoints = get_pathfinding_waypoints(start_pos, end_pos, pf_data, wall_dat);
+            latencies.push_back(1e6 * (get_seconds() - start_time));
+            num_found += !waypoints.empty();
+        }
+    }
+    std::sort(latencies.begin(), latencies.end());
+    json out;
+    out["map_size"] = 256;
+    out["queries"] = BENCH_NUM_ASTAR_QUERIES;
+    out["paths_found"] = num_found;
+    out["p50_us"] = get_percentile(latencies, 0.50);
+    out["p90_us"] = get_percentile(latencies, 0.90);
+    out["p99_us"] = get_percentile(latencies, 0.99);
+    out["max_us"] = latencies.back();
+    return out;
+}
+
+//
+// one tick's worth of orders on the medium map (a few group orders, every unit from somewhere else): the
+// queries one at a time, then as a single batch on one thread and on every core
+//
+static json bench_path_batch() {
+    Array2D<bool> wall_dat = make_bench_walls(256, 256, 4);
+    PathfindingData pf_data;
+    {
+        QuietStdout quiet;
+        pf_data = get_pathfinding_data(WallBits(wall_dat));
+    }
+    std::mt19937 rng(6);
+    PathBatch batch;
+    for (int g = 0; g < BENCH_PATH_BATCH_GROUPS; ++g) {
+        vec2<int> end_pos = get_random_open_position(wall_dat, rng);
+        for (int u = 0; u < BENCH_PATH_BATCH_UNITS; ++u)
+            batch.requests.push_back({get_random_open_position(wall_dat, rng), end_pos, PLAYER_RADIUS});
+    }
+
+    std::vector<vec2<int>> single_waypoints;
+    std::vector<int> single_starts;
+    double start_time = get_seconds();
+    {
+        QuietStdout quiet;
+        for (const PathRequest& request : batch.requests) {
+            std::vector<vec2<int>> waypoints = get_pathfinding_waypoints(request.start_pos, request.end_pos, pf_data, wall_dat, request.radius);
+            single_starts.push_back(single_waypoints.size());
+            single_waypoints.insert(single_waypoints.end(), waypoints.begin(), waypoints.end());
+        }
+        single_starts.push_back(single_waypoints.size());
+    }
+    double single_time = get_seconds() - start_time;
+    WorkerPool pool;
+    double batch_times[2];
+    bool matches = true;
+    for (int k = 0; k < 2; ++k) {
+        start_time = get_seconds();
+        {
+            QuietStdout quiet;
+            get_pathfinding_waypoints(batch, pf_data, wall_dat, k == 0 ? nullptr : &pool);
+        }
+        batch_times[k] = get_seconds() - start_time;
+        matches = matches && batch.waypoints == single_waypoints && batch.starts == single_starts;
+    }
+
+    json out;
+    out["map_size"] = 256;
+    out["queries"] = batch.requests.size();
+    out["destinations"] = BENCH_PATH_BATCH_GROUPS;
+    out["searches"] = batch.num_searches;
+    out["target_visibility_sets"] = batch.num_targets;
+    out["single_ms"] = 1000.0 * single_time;
+    out["batch_one_thread_ms"] = 1000.0 * batch_times[0];
+    out["batch_ms"] = 1000.0 * batch_times[1];
+    out["threads"] = pool.get_num_threads();
+    out["matches_single"] = matches;
+    return out;
+}
+
+//
+// two rooms joined by a corridor BENCH_CORRIDOR_WIDTHS tiles wide, one unit of every size in BENCH_UNIT_RADII
+// pathing across: whether it gets to the other room exactly when it fits through (otherwise the path stops as close
+// as it can), and whether the unit fits everywhere along it (every waypoint a valid position, every leg clear on the real walls)
+//
+static json bench_unit_sizes() {
+    json out;
+    bool matches = true;
+    for (int width : BENCH_CORRIDOR_WIDTHS) {
+        Array2D<bool> wall_dat(40, 24, false);
+        for (int x = 0; x < wall_dat.width(); ++x) {
+            for (int y = 0; y < wall_dat.height(); ++y) {
+                bool is_border = x == 0 || y == 0 || x == wall_dat.width() - 1 || y == wall_dat.height() - 1;
+                bool is_corridor = y >= 11 && y < 11 + width;
+                wall_dat[x][y] = is_border || (x >= 15 && x <= 25 && !is_corridor);
+            }
+        }
+        std::vector<float> unit_radii(std::begin(BENCH_UNIT_RADII), std::end(BENCH_UNIT_RADII));
+        PathfindingData pf_data;
+        {
+            QuietStdout quiet;
+            pf_data = get_pathfinding_data(WallBits(wall_dat), unit_radii);
+        }
+        json entry;
+        for (float radius : unit_radii) {
+            vec2<int> end_pos = {36 * GRIDSIZE, 20 * GRIDSIZE};
+            std::vector<vec2<int>> waypoints;
+            {
+                QuietStdout quiet;
+                waypoints = get_pathfinding_waypoints(vec2<int>(4 * GRIDSIZE, 4 * GRIDSIZE), end_pos, pf_data, wall_dat, radius);
+            }
+            bool gets_there = !waypoints.empty() && waypoints.back() == end_pos;
+            bool fits = 2.0f * radius <= static_cast<float>(width * GRIDSIZE);
+            bool is_clear = true;
+            vec2<float> last = {4.0f, 4.0f};
+            for (const vec2<int>& waypoint : waypoints) {
+                vec2<float> next = {static_cast<float>(waypoint.x) / F_GRIDSIZE, static_cast<float>(waypoint.y) / F_GRIDSIZE};
+                is_clear = is_clear && valid_player_position(waypoint, wall_dat, radius) &&
+                           line_of_sight_unit(last, next, wall_dat, radius / F_GRIDSIZE);
+                last = next;
+            }
+            matches = matches && gets_there == fits && is_clear;
+            json result;
+            result["fits"] = fits;
+            result["gets_there"] = gets_there;
+            result["waypoints"] = waypoints.size();
+            result["clear"] = is_clear;
+            entry["radius_" + std::to_string(static_cast<int>(radius))] = result;
+        }
+        out["corridor_" + std::to_string(width)] = entry;
+    }
+    out["matches_fit"] = matches;
+    return out;
+}
+
+//
+// splicing a path into a unit's order ring however full it is (the front order plus up to a full ring of queued
+// ones behind it) and wherever the ring wraps: the path has to go in whole if it fits, otherwise as much as fits
+// (at least one waypoint) with an order to pathfind to the goal again right behind, and the queued orders after
+// that untouched (all but the last one, when the ring was completely full)
+//
+static json bench_order_ring() {
+    std::vector<vec2<int>> waypoints;
+    for (int w = 0; w < 2 * ORDER_RING_CAPACITY; ++w)
+        waypoints.push_back({w, -w});
+    const vec2<int> goal = {1000, 1000};
+    int num_cases = 0;
+    int num_truncated = 0;
+    bool matches = true;
+    for (int num_orders = 1; num_orders <= ORDER_RING_CAPACITY; ++num_orders) {
+        for (int start : {0, ORDER_RING_CAPACITY / 2, ORDER_RING_CAPACITY - 1}) {
+            for (int num_waypoints : {1, 2, MAX_PATH_WAYPOINTS, ORDER_RING_CAPACITY - num_orders + 1, ORDER_RING_CAPACITY - num_orders + 2, 2 * ORDER_RING_CAPACITY}) {
+                AcceptedOrder ring[ORDER_RING_CAPACITY];
+                int head = start;
+                int count = num_orders;
+                ring[head] = {goal, -1, true, NO_CLICKPOS};
+                for (int k = 1; k < num_orders; ++k)
+                    ring[(head + k) & (ORDER_RING_CAPACITY - 1)] = {{k, k}, 0, true, NO_CLICKPOS};
+                int num_spliced = splice_path_orders(ring, head, count, waypoints.data(), num_waypoints);
+                auto at = [&](int k) -> const AcceptedOrder& { return ring[(head + k) & (ORDER_RING_CAPACITY - 1)]; };
+                bool fits = num_waypoints <= ORDER_RING_CAPACITY - num_orders + 1;
+                bool ok = count <= ORDER_RING_CAPACITY && num_spliced >= 1 && (num_spliced == num_waypoints) == fits;
+                for (int k = 0; k < num_spliced && ok; ++k)
+                    ok = at(k).goal_coordinates == waypoints[k] && !at(k).request_new_paths && at(k).clicked_coordinates == goal;
+                int next = num_spliced;
+                if (ok && !fits) {
+                    ok = at(next).goal_coordinates == goal && at(next).request_new_paths;
+                    next += 1;
+                }
+                int num_kept = std::min(num_orders - 1, ORDER_RING_CAPACITY - next);
+                ok = ok && count == next + num_kept && (num_kept == num_orders - 1 || num_orders == ORDER_RING_CAPACITY);
+                for (int k = 0; k < num_kept && ok; ++k)
+                    ok = at(next + k).goal_coordinates == vec2<int>(k + 1, k + 1);
+                matches = matches && ok;
+                num_cases += 1;
+                num_truncated += !fits;
+            }
+        }
+    }
+    json out;
+    out["cases"] = num_cases;
+    out["truncated"] = num_truncated;
+    out["matches_expected"] = matches;
+    return out;
+}
+
+//
+// tick BENCH_NUM_UNITS units on a real map, with a quarter of them receiving new orders every second. the
+// per-tick state hashes are chained into one, which has to come out the same for every build in fixed point mode.
+// fixed point mode lists every tick's hash too, for make sim-hash-check to diff between the native and wasm builds
+//
+static json run_unit_tick(bool fixed_point) {
+    WorldMap* world_map = nullptr;
+    {
+        QuietStdout quiet;
+        world_map = new WorldMap(BENCH_MAP);
+    }
+    vec2<int> map_size = world_map->get_map_size();
+    std::mt19937 rng(1234);
+
+    UnitPool units(fixed_point);
+    while (units.size() < BENCH_NUM_UNITS) {
+        vec2<float> pos = {static_cast<float>(rng() % map_size.x), static_cast<float>(rng() % map_size.y)};
+        if (world_map->is_valid_position(pos))
+            units.set_selected(units.add_unit(pos), true);
+    }
+
+    double tick_time = 0.0;
+    uint64_t state_hash = 0;
+    std::vector<uint64_t> tick_hashes;
+    {
+        QuietStdout quiet;
+        for (int t = 0; t < BENCH_NUM_TICKS; ++t) {
+            if (t % BENCH_ORDER_INTERVAL == 0) {
+                for (int i = 0; i < units.size(); i += 4) {
+                    int j = i + (t / BENCH_ORDER_INTERVAL) % 4;
+                    if (j < units.size())
+                        Mauzling(&units, j).issue_new_order({static_cast<int>(rng() % map_size.x), static_cast<int>(rng() % map_size.y)}, rng() % 4 == 0);
+                }
+            }
+            double start_time = get_seconds();
+            units.tick(world_map);
+            tick_time += get_seconds() - start_time;
+            tick_hashes.push_back(units.get_state_hash());
+            state_hash = state_hash * 31 + tick_hashes.back();
+        }
+    }
+    delete world_map;
+
+    json out;
+    out["units"] = units.size();
+    out["ticks"] = BENCH_NUM_TICKS;
+    out["ms_per_tick"] = 1000.0 * tick_time / BENCH_NUM_TICKS;
+    out["unit_ticks_per_second"] = units.size() * BENCH_NUM_TICKS / tick_time;
+    char hash_text[17];
+    snprintf(hash_text, sizeof(hash_text), "%016llx", static_cast<unsigned long long>(state_hash));
+    out["state_hash"] = hash_text;
+    if (fixed_point) {
+        out["tick_hashes"] = json::array();
+        for (uint64_t hash : tick_hashes) {
+            snprintf(hash_text, sizeof(hash_text), "%016llx", static_cast<unsigned long long>(hash));
+            out["tick_hashes"].push_back(hash_text);
+        }
+    }
+    return out;
+}
+
+static json bench_unit_tick() {
+    return run_unit_tick(false);
+}
+
+static json bench_unit_tick_fixed() {
+    return run_unit_tick(true);
+}
+
+//
+// conveyor nudge for lots of units on a map that's all conveyor between the walls: WorldMap::apply_scroll's flow
+// field pass against stepping every unit's scroll towards the walls (what the per-unit lookup used to do)
+//
+static json bench_conveyor_scroll() {
+    Array2D<bool> wall_dat = make_bench_walls(BENCH_CONVEYOR_MAP_SIZE, BENCH_CONVEYOR_MAP_SIZE, 1);
+    json map;
+    map["map_name"] = "bench conveyors";
+    map["map_width"] = BENCH_CONVEYOR_MAP_SIZE;
+    map["map_height"] = BENCH_CONVEYOR_MAP_SIZE;
+    map["tileset"] = "assets/tile_data.json";
+    map["start_pos"] = {GRIDSIZE, GRIDSIZE};
+    map["init_lives"] = 1;
+    std::vector<int> tiles;
+    for (int y = 0; y < BENCH_CONVEYOR_MAP_SIZE; ++y) {
+        for (int x = 0; x < BENCH_CONVEYOR_MAP_SIZE; ++x)
+            tiles.push_back(wall_dat[x][y] ? 1 : BENCH_CONVEYOR_TILE);
+    }
+    map["tile_dat"] = tiles;
+    {
+        std::ofstream out(BENCH_CONVEYOR_MAP);
+        out << map.dump();
+    }
+    WorldMap* world_map = nullptr;
+    {
+        QuietStdout quiet;
+        world_map = new WorldMap(BENCH_CONVEYOR_MAP);
+    }
+    std::remove(BENCH_CONVEYOR_MAP);
+
+    std::mt19937 rng(5);
+    std::vector<float> pos_x;
+    std::vector<float> pos_y;
+    for (int i = 0; i < BENCH_CONVEYOR_UNITS; ++i) {
+        vec2<int> pos = get_random_open_position(wall_dat, rng);
+        pos_x.push_back(pos.x);
+        pos_y.push_back(pos.y);
+    }
+    std::vector<float> radii(BENCH_CONVEYOR_UNITS, PLAYER_RADIUS);
+    std::vector<uint8_t> active(BENCH_CONVEYOR_UNITS, 1);
+    std::vector<uint8_t> scrolled(BENCH_CONVEYOR_UNITS, 0);
+
+    std::vector<vec2<float>> stepped;
+    for (int i = 0; i < BENCH_CONVEYOR_UNITS; ++i)
+        stepped.push_back({pos_x[i], pos_y[i]});
+    double start_time = get_seconds();
+    for (int t = 0; t < BENCH_CONVEYOR_TICKS; ++t) {
+        for (vec2<float>& position : stepped) {
+            vec2<float> out_pos = position;
+            for (int step = 1; step <= MOVE_POS_STEPS; ++step) {
+                vec2<float> test_pos = (static_cast<float>(step) / MOVE_POS_STEPS * BENCH_CONVEYOR_SCROLL) + position;
+                if (!world_map->is_valid_position(test_pos))
+                    break;
+                out_pos = test_pos;
+            }
+            position = out_pos;
+        }
+    }
+    double stepped_time = get_seconds() - start_time;
+
+    long long num_scrolled = 0;
+    start_time = get_seconds();
+    for (int t = 0; t < BENCH_CONVEYOR_TICKS; ++t) {
+        world_map->apply_scroll(BENCH_CONVEYOR_UNITS, pos_x.data(), pos_y.data(), radii.data(), active.data(), scrolled.data());
+        num_scrolled += std::count(scrolled.begin(), scrolled.end(), 1);
+    }
+    double flow_time = get_seconds() - start_time;
+    bool matches = true;
+    for (int i = 0; i < BENCH_CONVEYOR_UNITS; ++i)
+        matches = matches && stepped[i].x == pos_x[i] && stepped[i].y == pos_y[i];
+    delete world_map;
+
+    json out;
+    out["map_size"] = BENCH_CONVEYOR_MAP_SIZE;
+    out["units"] = BENCH_CONVEYOR_UNITS;
+    out["ticks"] = BENCH_CONVEYOR_TICKS;
+    out["scrolled"] = num_scrolled;
+    out["stepped_ms_per_tick"] = 1000.0 * stepped_time / BENCH_CONVEYOR_TICKS;
+    out["flow_field_ms_per_tick"] = 1000.0 * flow_time / BENCH_CONVEYOR_TICKS;
+    out["matches_stepped"] = matches;
+    return out;
+}
+
+//
+// grid rebuild + box/click selection over BENCH_SELECTION_UNITS units, checked against a linear scan
+//
+static json bench_selection() {
+    WorldMap* world_map = nullptr;
+    {
+        QuietStdout quiet;
+        world_map = new WorldMap(BENCH_MAP);
+    }
+    vec2<int> map_size = world_map->get_map_size();
+    std::mt19937 rng(5678);
+
+    UnitPool units;
+    while (units.size() < BENCH_SELECTION_UNITS) {
+        vec2<float> pos = {static_cast<float>(rng() % map_size.x), static_cast<float>(rng() % map_size.y)};
+        if (world_map->is_valid_position(pos))
+            units.add_unit(pos);
+    }
+
+    UnitGrid grid;
+    double start_time = get_seconds();
+    for (int q = 0; q < BENCH_SELECTION_QUERIES; ++q)
+        grid.rebuild(units);
+    double rebuild_time = (get_seconds() - start_time) / BENCH_SELECTION_QUERIES;
+
+    std::vector<vec2<float>> corners;
+    for (int q = 0; q < 2 * BENCH_SELECTION_QUERIES; ++q)
+        corners.push_back({static_cast<float>(rng() % map_size.x), static_cast<float>(rng() % map_size.y)});
+
+    std::vector<int> hits;
+    size_t total_hits = 0;
+    start_time = get_seconds();
+    for (int q = 0; q < BENCH_SELECTION_QUERIES; ++q) {
+        grid.query_rect(corners[2*q], corners[2*q+1], hits);
+        total_hits += hits.size();
+    }
+    double box_time = (get_seconds() - start_time) / BENCH_SELECTION_QUERIES;
+    start_time = get_seconds();
+    for (int q = 0; q < BENCH_SELECTION_QUERIES; ++q) {
+        grid.query_point(corners[q], CLICKSELECTION_VEC2, hits);
+        total_hits += hits.size();
+    }
+    double click_time = (get_seconds() - start_time) / BENCH_SELECTION_QUERIES;
+
+    // same answers as the brute force loop?
+    size_t brute_hits = 0;
+    for (int q = 0; q < BENCH_SELECTION_QUERIES; ++q) {
+        vec2<float> p1 = corners[2*q];
+        vec2<float> p2 = corners[2*q+1];
+        for (int i = 0; i < units.size(); ++i) {
+            vec2<float> pos = units.get_position(i);
+            if (pos.x >= std::min(p1.x, p2.x) && pos.x <= std::max(p1.x, p2.x) &&
+                pos.y >= std::min(p1.y, p2.y) && pos.y <= std::max(p1.y, p2.y))
+                brute_hits += 1;
+        }
+    }
+    for (int q = 0; q < BENCH_SELECTION_QUERIES; ++q) {
+        vec2<float> p = corners[q];
+        for (int i = 0; i < units.size(); ++i) {
+            vec2<float> pos = units.get_position(i);
+            if (std::abs(pos.x - p.x) <= CLICKSELECTION_VEC2.x && std::abs(pos.y - p.y) <= CLICKSELECTION_VEC2.y)
+                brute_hits += 1;
+        }
+    }
+    delete world_map;
+
+    json out;
+    out["units"] = units.size();
+    out["rebuild_ms"] = 1000.0 * rebuild_time;
+    out["box_query_ms"] = 1000.0 * box_time;
+    out["click_query_ms"] = 1000.0 * click_time;
+    out["matches_linear_scan"] = total_hits == brute_hits;
+    return out;
+}
+
+//
+// WorldMap::draw into an offscreen surface with sdl's software renderer (dummy video driver, no window needed)
+//
+static json run_worldmap_draw(const char* map_filename) {
+    json out;
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        out["error"] = SDL_GetError();
+        return out;
+    }
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, RESOLUTION.x, RESOLUTION.y, 32, SDL_PIXELFORMAT_ARGB8888);
+    renderer = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+    if (renderer == nullptr) {
+        out["error"] = SDL_GetError();
+        if (target)
+            SDL_FreeSurface(target);
+        SDL_Quit();
+        return out;
+    }
+
+    WorldMap* world_map = nullptr;
+    {
+        QuietStdout quiet;
+        world_map = new WorldMap(map_filename);
+        world_map->set_current_obstacle(0);
+    }
+    vec2<int> map_size = world_map->get_map_size();
+    texture_atlas = new TextureAtlas();
+    fonts["tiny_black"] = new Font("assets/small_font.png", {0, 0, 0, 255}, 1);
+
+    std::vector<double> frame_times;
+    {
+        QuietStdout quiet;
+        EventBus events;
+        RenderSnapshot snapshot;
+        for (int f = 0; f < BENCH_NUM_DRAW_FRAMES; ++f) {
+            // pan back and forth across the map
+            int pan_x = std::max(map_size.x - RESOLUTION.x, 0);
+            int pan_y = std::max(map_size.y - RESOLUTION.y, 0);
+            float t = 0.5f - 0.5f * std::cos(2.0f * 3.14159265f * f / BENCH_NUM_DRAW_FRAMES);
+            vec2<int> offset = {static_cast<int>(t * pan_x), static_cast<int>(t * pan_y)};
+            events.clear();
+            world_map->tick(events);
+            world_map->fill_snapshot(snapshot);
+            double start_time = get_seconds();
+            SDL_RenderClear(renderer);
+            world_map->draw(snapshot, offset);
+            SDL_RenderPresent(renderer);
+            frame_times.push_back(1000.0 * (get_seconds() - start_time));
+        }
+    }
+    std::sort(frame_times.begin(), frame_times.end());
+    double total_ms = 0.0;
+    for (double ms : frame_times)
+        total_ms += ms;
+
+    out["frames"] = BENCH_NUM_DRAW_FRAMES;
+    out["resolution"] = {RESOLUTION.x, RESOLUTION.y};
+    out["mean_ms"] = total_ms / BENCH_NUM_DRAW_FRAMES;
+    out["p50_ms"] = get_percentile(frame_times, 0.50);
+    out["p99_ms"] = get_percentile(frame_times, 0.99);
+    out["frames_per_second"] = 1000.0 * BENCH_NUM_DRAW_FRAMES / total_ms;
+
+    delete world_map;
+    delete fonts["tiny_black"];
+    fonts.clear();
+    delete texture_atlas;
+    texture_atlas = nullptr;
+    SDL_DestroyRenderer(renderer);
+    renderer = nullptr;
+    SDL_FreeSurface(target);
+    SDL_Quit();
+    return out;
+}
+
+// the bundled map plus a big generated one (tools/mapgen), which actually scrolls and has busy obstacles
+static json bench_worldmap_draw() {
+    json out;
+    out["bundled"] = run_worldmap_draw(BENCH_MAP);
+
+    MapGenParams params;
+    params.name = "bench";
+    params.width = BENCH_GENERATED_MAP_SIZE;
+    params.height = BENCH_GENERATED_MAP_SIZE;
+    params.num_obstacles = 1;
+    params.locs_per_obstacle = 64;
+    params.exps_per_obstacle = 16;
+    double start_time = get_seconds();
+    write_map_json(generate_map(params), params, BENCH_GENERATED_MAP);
+    double generate_seconds = get_seconds() - start_time;
+    out["generated"] = run_worldmap_draw(BENCH_GENERATED_MAP);
+    out["generated"]["map_size"] = {params.width, params.height};
+    out["generated"]["generate_seconds"] = generate_seconds;
+    std::remove(BENCH_GENERATED_MAP);
+    return out;
+}
+
+//
+// usage: openbound_bench [benchmark names...]   (runs everything by default, results go to stdout as json)
+//
+int main(int argc, char* argv[]) {
+    typedef json (*BenchFunction)();
+    const std::vector<std::pair<std::string, BenchFunction>> all_benchmarks = {
+        {"dda_rays", bench_dda_rays},
+        {"los_batch", bench_los_batch},
+        {"valid_player_position", bench_valid_player_position},
+        {"map_chunks", bench_map_chunks},
+        {"region_labels", bench_region_labels},
+        {"corner_nodes", bench_corner_nodes},
+        {"get_pathfinding_data", bench_pathfinding_data},
+        {"pathfinding_memory", bench_pathfinding_memory},
+        {"pathfinding_update", bench_pathfinding_update},
+        {"astar", bench_astar},
+        {"path_batch", bench_path_batch},
+        {"unit_sizes", bench_unit_sizes},
+        {"order_ring", bench_order_ring},
+        {"unit_tick", bench_unit_tick},
+        {"unit_tick_fixed", bench_unit_tick_fixed},
+        {"conveyor_scroll", bench_conveyor_scroll},
+        {"selection", bench_selection},
+        {"worldmap_draw", bench_worldmap_draw},
+    };
+    std::vector<std::string> requested(argv + 1, argv + argc);
+
+    json results;
+    results["benchmarks"] = json::object();
+    for (const auto& bench : all_benchmarks) {
+        if (!requested.empty() && std::find(requested.begin(), requested.end(), bench.first) == requested.end())
+            continue;
+        fprintf(stderr, "running %s...\n", bench.first.c_str());
+        double start_time = get_seconds();
+        results["benchmarks"][bench.first] = bench.second();
+        fprintf(stderr, "  done in %.2f s\n", get_seconds() - start_time);
+    }
+    std::cout << results.dump(2) << std::endl;
+    return 0;
+}
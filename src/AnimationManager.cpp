@@ -2,59 +2,84 @@
 
 #include <stdexcept>
 
-#include "misc_gfx.h"
+#include "EventBus.h"
 
-AnimationManager::AnimationManager() : all_animations(), active_animations() {}
+AnimationManager::AnimationManager(TextureAtlas* atlas) : atlas(atlas), all_animations(), active_animations() {}
 
 AnimationManager::~AnimationManager() {
-    for (auto& pair : all_animations) {
-        for (size_t i = 0; i < pair.second.frames.size(); ++i)
-            SDL_DestroyTexture(pair.second.frames[i]);
-    }
+    // frames belong to the atlas
 }
 
-void AnimationManager::add_animation(const std::string& name,
-                                     const std::string& image_filename,
-                                     const vec2<int>& sprite_dimensions,
+// frames are RGBA32 surfaces (see AssetLoader), the atlas takes them over. returns the interned name, which is
+// what everything else refers to the animation by
+int AnimationManager::add_animation(const std::string& name,
+                                     const std::vector<SDL_Surface*>& frames,
                                      const std::vector<int>& frames_per_image) {
-    std::vector<SDL_Surface*> image_list = load_spritesheet(image_filename, sprite_dimensions);
-    if (frames_per_image.size() > 0 && frames_per_image.size() != image_list.size())
+    if (frames_per_image.size() > 0 && frames_per_image.size() != frames.size())
         throw std::invalid_argument("image_list size does not match frames_per_image size");
     AnimationSequence anim_dat;
-    for (size_t i = 0; i < image_list.size(); ++i) {
-        anim_dat.frames.push_back(SDL_CreateTextureFromSurface(renderer, image_list[i]));
-        anim_dat.sizes.push_back({image_list[i]->w, image_list[i]->h});
+    anim_dat.is_loaded = true;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        anim_dat.sizes.push_back({frames[i]->w, frames[i]->h});
+        anim_dat.frames.push_back(atlas->add_rgba_surface(frames[i]));
         if (frames_per_image.size() > 0)
             anim_dat.durations.push_back(frames_per_image[i]);
         else
             anim_dat.durations.push_back(1);
         anim_dat.offsets.push_back({0,0}); // TODO: add support for offsets
-        SDL_FreeSurface(image_list[i]);
     }
-    all_animations[name] = anim_dat;
-    printf("ADDED ANIMATION: %s %zu\n", name.c_str(), image_list.size());
+    int animation = intern_name(name);
+    if (animation >= static_cast<int>(all_animations.size()))
+        all_animations.resize(animation + 1);
+    all_animations[animation] = anim_dat; // (a replaced animation's frames stay in the atlas)
+    printf("ADDED ANIMATION: %s %zu\n", name.c_str(), frames.size());
+    return animation;
 }
 
-void AnimationManager::start_new_animation(const std::string& name,
-                                           const std::string& id,
+int AnimationManager::find_active_animation(int instance_id) const {
+    for (size_t i = 0; i < active_animations.size(); ++i) {
+        if (active_animations[i].instance_id == instance_id)
+            return i;
+    }
+    return -1;
+}
+
+// an animation already playing under instance_id gets replaced
+void AnimationManager::start_new_animation(int animation,
+                                           int instance_id,
                                            const vec2<int>& position,
                                            bool is_looping,
                                            bool is_centered) {
-    if (all_animations.count(name) == 0)
-        throw std::invalid_argument("all_animations does not contain image with name " + name);
-    active_animations[id] = {name, position, 0, 0, is_looping, is_centered};
+    if (animation < 0 || animation >= static_cast<int>(all_animations.size()) || !all_animations[animation].is_loaded)
+        throw std::invalid_argument("all_animations does not contain image with name " + get_interned_name(animation));
+    ActiveAnimation new_anim = {animation, instance_id, position, 0, 0, is_looping, is_centered};
+    int i = find_active_animation(instance_id);
+    if (i >= 0)
+        active_animations[i] = new_anim;
+    else
+        active_animations.push_back(new_anim);
 }
 
-SDL_Texture* AnimationManager::get_animating_texture(const std::string& id) {
-    if (active_animations.count(id) == 0)
-        return nullptr;
-    AnimationSequence* my_animdat = &all_animations[active_animations[id].name];
-    unsigned int current_frame = active_animations[id].current_frame;
-    return my_animdat->frames[current_frame];
+// -1 if there's no such frame
+int AnimationManager::get_frame_sprite(int animation, unsigned int frame) {
+    const AnimationSequence& anim_dat = all_animations[animation];
+    if (frame >= anim_dat.frames.size())
+        return -1;
+    return anim_dat.frames[frame];
 }
 
-void AnimationManager::remove_animation(const std::string& id) {
-    active_animations.erase(id);
+// 0 if nothing is playing under instance_id
+unsigned int AnimationManager::get_current_frame(int instance_id) const {
+    int i = find_active_animation(instance_id);
+    if (i < 0)
+        return 0;
+    return active_animations[i].current_frame;
+}
+
+void AnimationManager::remove_animation(int instance_id) {
+    int i = find_active_animation(instance_id);
+    if (i >= 0)
+        active_animations.erase(active_animations.begin() + i);
 }
 
 void AnimationManager::remove_all_animations() {
@@ -62,42 +87,48 @@ void AnimationManager::remove_all_animations() {
 }
 
 void AnimationManager::tick() {
-    for (auto it = active_animations.begin(); it != active_animations.end();) {
-        AnimationSequence* my_animdat = &all_animations[it->second.name];
+    size_t num_kept = 0;
+    for (size_t i = 0; i < active_animations.size(); ++i) {
+        ActiveAnimation& active = active_animations[i];
+        const AnimationSequence& my_animdat = all_animations[active.animation];
         // increment animations ticks
-        it->second.current_tick_within_frame += 1;
-        //printf("frame %i: %i / %i\n", it->second.current_frame, it->second.current_tick_within_frame, my_animdat->durations[it->second.current_frame]);
-        if (it->second.current_tick_within_frame > my_animdat->durations[it->second.current_frame]) {
-            it->second.current_frame += 1;
-            it->second.current_tick_within_frame = 0;
+        active.current_tick_within_frame += 1;
+        if (active.current_tick_within_frame > my_animdat.durations[active.current_frame]) {
+            active.current_frame += 1;
+            active.current_tick_within_frame = 0;
         }
         // animation finished: reset if looping, otherwise remove
-        if (it->second.current_frame >= my_animdat->frames.size()) {
-            if (it->second.is_looping) {
-                it->second.current_frame = 0;
-                it->second.current_tick_within_frame = 0;
-                ++it;
-            }
-            else
-                it = active_animations.erase(it);
+        if (active.current_frame >= my_animdat.frames.size()) {
+            if (!active.is_looping)
+                continue;
+            active.current_frame = 0;
+            active.current_tick_within_frame = 0;
         }
-        else
-            ++it;
+        active_animations[num_kept++] = active;
     }
+    active_animations.resize(num_kept);
+}
+
+void AnimationManager::fill_snapshot(std::vector<AnimationSnapshot>& out_animations) const {
+    out_animations.clear();
+    for (const ActiveAnimation& active : active_animations)
+        out_animations.push_back({active.animation, active.position, active.current_frame, active.is_centered});
 }
 
-void AnimationManager::draw(const vec2<int>& offset) {
-    for (const auto& pair : active_animations) {
-        AnimationSequence* my_animdat = &all_animations[pair.second.name];
-        unsigned int current_frame = pair.second.current_frame;
-        vec2<int> position = pair.second.position;
+// textures are only touched here, so this is the half that runs on the render thread
+void AnimationManager::draw(const std::vector<AnimationSnapshot>& animations, const vec2<int>& offset) {
+    for (const AnimationSnapshot& active : animations) {
+        const AnimationSequence* my_animdat = &all_animations[active.animation];
+        unsigned int current_frame = active.frame;
+        vec2<int> position = active.position;
         vec2<int> centering_adj = {0,0};
-        if (pair.second.is_centered)
+        if (active.is_centered)
             centering_adj = {my_animdat->sizes[current_frame].x / 2, my_animdat->sizes[current_frame].y / 2};
         SDL_Rect rect = {position.x + my_animdat->offsets[current_frame].x - offset.x - centering_adj.x,
                          position.y + my_animdat->offsets[current_frame].y - offset.y - centering_adj.y,
                          my_animdat->sizes[current_frame].x,
                          my_animdat->sizes[current_frame].y};
-        SDL_RenderCopy(renderer, my_animdat->frames[current_frame], nullptr, &rect);
+        atlas->queue(my_animdat->frames[current_frame], rect);
     }
+    atlas->flush();
 }
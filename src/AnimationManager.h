@@ -1,23 +1,26 @@
 #pragma once
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 #include <SDL.h>
 
+#include "RenderSnapshot.h"
+#include "TextureAtlas.h"
 #include "Vec2.h"
 
 extern SDL_Renderer* renderer;
 
 struct AnimationSequence {
-    std::vector<SDL_Texture*> frames;
+    bool is_loaded = false;
+    std::vector<int> frames;           // atlas sprites
     std::vector<vec2<int>> sizes;
     std::vector<unsigned int> durations;
     std::vector<vec2<int>> offsets;
 };
 
 struct ActiveAnimation {
-    std::string name;
+    int animation;    // interned name
+    int instance_id;  // whatever the caller wants to refer to this animation by (e.g. an interned location)
     vec2<int> position;
     unsigned int current_frame;
     unsigned int current_tick_within_frame;
@@ -27,17 +30,22 @@ struct ActiveAnimation {
 
 class AnimationManager {
 private:
-     std::unordered_map<std::string, AnimationSequence> all_animations;
-     std::unordered_map<std::string, ActiveAnimation> active_animations;
+     TextureAtlas* atlas;
+     std::vector<AnimationSequence> all_animations;      // indexed by interned name
+     std::vector<ActiveAnimation> active_animations;
+
+     int find_active_animation(int instance_id) const;
 
 public:
-    AnimationManager();
+    explicit AnimationManager(TextureAtlas* atlas);
     ~AnimationManager();
-    void add_animation(const std::string& name, const std::string& image_list, const vec2<int>& sprite_dimensions, const std::vector<int>& frames_per_image = {});
-    void start_new_animation(const std::string& name, const std::string& id, const vec2<int>& position, bool is_looping, bool is_centered = false);
-    SDL_Texture* get_animating_texture(const std::string& id);
-    void remove_animation(const std::string& id);
+    int add_animation(const std::string& name, const std::vector<SDL_Surface*>& frames, const std::vector<int>& frames_per_image = {});
+    void start_new_animation(int animation, int instance_id, const vec2<int>& position, bool is_looping, bool is_centered = false);
+    int get_frame_sprite(int animation, unsigned int frame);
+    unsigned int get_current_frame(int instance_id) const;
+    void remove_animation(int instance_id);
     void remove_all_animations();
     void tick();
-    void draw(const vec2<int>& offset);
+    void fill_snapshot(std::vector<AnimationSnapshot>& out_animations) const;
+    void draw(const std::vector<AnimationSnapshot>& animations, const vec2<int>& offset);
 };
@@ -0,0 +1,164 @@
+#include "AssetLoader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+#include <SDL_image.h>
+
+#include "globals.h"
+#include "misc_gfx.h"
+#include "Profiler.h"
+
+AssetLoader::AssetLoader(int num_threads) : start_time(get_precise_time()) {
+#ifndef __EMSCRIPTEN__
+    if (num_threads <= 0)
+        num_threads = std::min(static_cast<int>(std::thread::hardware_concurrency()), ASSET_LOADER_MAX_THREADS);
+    num_threads = std::max(num_threads, 1);
+    for (int i = 0; i < num_threads; ++i)
+        workers.push_back(std::thread(&AssetLoader::worker_loop, this));
+#else
+    (void)num_threads;
+#endif
+}
+
+AssetLoader::~AssetLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        is_stopping = true;
+        queue.clear();
+    }
+    queue_cv.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+    for (std::unique_ptr<Job>& job : jobs) {
+        for (SDL_Surface* surface : job->surfaces)
+            SDL_FreeSurface(surface);
+    }
+}
+
+// decode + process, no locking needed (nobody else touches a job until is_done)
+void AssetLoader::run_job(Job& job) {
+    PROFILE_ZONE("load asset");
+    double start = get_precise_time();
+    SDL_Surface* image = IMG_Load(job.path.c_str());
+    double decoded = get_precise_time();
+    job.decode_ms = 1000.0 * (decoded - start);
+    if (image == nullptr) {
+        job.error = "could not load image " + job.path + ": " + IMG_GetError();
+        return;
+    }
+    try {
+        job.surfaces = job.process(image);
+        for (SDL_Surface* surface : job.surfaces) {
+            if (surface == nullptr)
+                throw std::invalid_argument("could not process image " + job.path + ": " + SDL_GetError());
+        }
+    }
+    catch (const std::exception& e) {
+        job.error = e.what();
+        for (SDL_Surface* surface : job.surfaces)
+            SDL_FreeSurface(surface);
+        job.surfaces.clear();
+    }
+    SDL_FreeSurface(image);
+    job.process_ms = 1000.0 * (get_precise_time() - decoded);
+}
+
+void AssetLoader::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        queue_cv.wait(lock, [this]() { return is_stopping || !queue.empty(); });
+        if (is_stopping)
+            return;
+        Job* job = jobs[queue.front()].get();
+        queue.pop_front();
+        lock.unlock();
+        run_job(*job);
+        lock.lock();
+        job->is_done = true;
+        done_cv.notify_all();
+    }
+}
+
+int AssetLoader::load(const std::string& path, AssetProcessor process) {
+    std::unique_ptr<Job> job(new Job());
+    job->path = path;
+    job->process = process;
+    std::lock_guard<std::mutex> lock(mutex);
+    int handle = jobs.size();
+    jobs.push_back(std::move(job));
+    if (workers.empty()) {
+        run_job(*jobs[handle]);
+        jobs[handle]->is_done = true;
+    }
+    else {
+        queue.push_back(handle);
+        queue_cv.notify_one();
+    }
+    return handle;
+}
+
+int AssetLoader::load_image(const std::string& path, bool colorkey) {
+    return load(path, [colorkey](SDL_Surface* image) -> std::vector<SDL_Surface*> {
+        if (colorkey)
+            SDL_SetColorKey(image, SDL_TRUE, SDL_MapRGB(image->format, TRANS_COL.r, TRANS_COL.g, TRANS_COL.b));
+        return std::vector<SDL_Surface*>{colorkey_to_alpha(image)};
+    });
+}
+
+int AssetLoader::load_spritesheet(const std::string& path, const vec2<int>& sprite_dimensions) {
+    return load(path, [sprite_dimensions](SDL_Surface* image) -> std::vector<SDL_Surface*> {
+        std::vector<SDL_Surface*> sprites = slice_spritesheet(image, sprite_dimensions);
+        for (SDL_Surface*& sprite : sprites) {
+            SDL_Surface* converted = colorkey_to_alpha(sprite);
+            SDL_FreeSurface(sprite);
+            sprite = converted;
+        }
+        return sprites;
+    });
+}
+
+std::vector<SDL_Surface*> AssetLoader::take(int handle) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (handle < 0 || handle >= static_cast<int>(jobs.size()) || jobs[handle]->is_taken)
+        throw std::invalid_argument("AssetLoader::take got an invalid handle");
+    Job& job = *jobs[handle];
+    double start = get_precise_time();
+    done_cv.wait(lock, [&job]() { return job.is_done; });
+    job.wait_ms = 1000.0 * (get_precise_time() - start);
+    job.is_taken = true;
+    if (!job.error.empty())
+        throw std::invalid_argument(job.error);
+    std::vector<SDL_Surface*> out;
+    out.swap(job.surfaces);
+    return out;
+}
+
+int AssetLoader::get_num_threads() const {
+    return workers.size();
+}
+
+void AssetLoader::print_report() {
+    std::lock_guard<std::mutex> lock(mutex);
+    double decode_ms = 0.0;
+    double process_ms = 0.0;
+    double wait_ms = 0.0;
+    int num_jobs = 0;
+    for (std::unique_ptr<Job>& job_ptr : jobs) {
+        Job& job = *job_ptr;
+        if (!job.is_taken || job.is_reported)
+            continue;
+        job.is_reported = true;
+        printf("  %-40s decode %6.2f ms  process %6.2f ms  waited %6.2f ms\n",
+               job.path.c_str(), job.decode_ms, job.process_ms, job.wait_ms);
+        decode_ms += job.decode_ms;
+        process_ms += job.process_ms;
+        wait_ms += job.wait_ms;
+        num_jobs += 1;
+    }
+    double now = get_precise_time();
+    printf("loaded %i assets in %.2f ms on %zu threads (decode %.2f ms, process %.2f ms, waited %.2f ms)\n",
+           num_jobs, 1000.0 * (now - start_time), workers.size(), decode_ms, process_ms, wait_ms);
+    start_time = now;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <SDL.h>
+
+#include "Vec2.h"
+
+static const int ASSET_LOADER_MAX_THREADS = 8;
+
+// runs on a worker, turns a freshly decoded image into whatever surfaces the caller wants. it may modify image
+// but not free it. throwing std::invalid_argument fails the asset, take() rethrows it
+typedef std::function<std::vector<SDL_Surface*>(SDL_Surface* image)> AssetProcessor;
+
+//
+// decodes images on a pool of worker threads. queue everything up front with load*(), then take() the
+// results in whatever order, so the decoding overlaps. processors do the colorkeying/slicing on the workers
+// too, so what comes out is RGBA32 surfaces ready for TextureAtlas::add_rgba_surface, and the only thing left
+// for the render thread is the texture upload in TextureAtlas::build. on wasm everything runs inside load().
+//
+class AssetLoader {
+private:
+    struct Job {
+        std::string path;
+        AssetProcessor process;
+        std::vector<SDL_Surface*> surfaces;
+        std::string error;
+        bool is_done = false;
+        bool is_taken = false;
+        bool is_reported = false;
+        // timing, in ms
+        double decode_ms = 0.0;
+        double process_ms = 0.0;
+        double wait_ms = 0.0; // time take() spent blocked on this one
+    };
+
+    std::vector<std::unique_ptr<Job>> jobs;   // indexed by handle
+    std::deque<int> queue;
+    std::mutex mutex;
+    std::condition_variable queue_cv;
+    std::condition_variable done_cv;
+    std::vector<std::thread> workers;
+    bool is_stopping = false;
+    double start_time;  // of the current report
+
+    static void run_job(Job& job);
+    void worker_loop();
+
+public:
+    explicit AssetLoader(int num_threads = 0); // 0: one per core, up to ASSET_LOADER_MAX_THREADS
+    ~AssetLoader();
+    int load(const std::string& path, AssetProcessor process);
+    int load_image(const std::string& path, bool colorkey = true);                 // one frame
+    int load_spritesheet(const std::string& path, const vec2<int>& sprite_dimensions); // a frame per sprite
+    std::vector<SDL_Surface*> take(int handle); // waits for it, the caller owns (and frees) the surfaces
+    int get_num_threads() const;
+    void print_report();                        // per asset timings of everything taken since the last report
+};
@@ -0,0 +1,333 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "Array2D.h"
+
+static const int MAP_CHUNK_SIZE = 32;         // tiles per chunk side
+static const int MAP_RESIDENT_CHUNKS = 256;   // default budget, per grid
+
+struct ChunkStats {
+    int num_chunks = 0;
+    int resident_chunks = 0;
+    size_t resident_bytes = 0;  // decoded chunks
+    size_t stored_bytes = 0;    // rle copies of every chunk (all that's kept of paged out ones)
+    size_t full_bytes = 0;      // what the whole grid would take decoded
+    long long page_ins = 0;
+    long long page_outs = 0;
+    double page_in_ms = 0.0;    // total
+    double max_page_in_ms = 0.0;
+
+    void add(const ChunkStats& other) {
+        num_chunks += other.num_chunks;
+        resident_chunks += other.resident_chunks;
+        resident_bytes += other.resident_bytes;
+        stored_bytes += other.stored_bytes;
+        full_bytes += other.full_bytes;
+        page_ins += other.page_ins;
+        page_outs += other.page_outs;
+        page_in_ms += other.page_in_ms;
+        max_page_in_ms = std::max(max_page_in_ms, other.max_page_in_ms);
+    }
+};
+
+//
+// 2d grid stored as MAP_CHUNK_SIZE^2 chunks. every chunk is kept run length encoded, and only up to
+// max_resident of them are decoded at a time. touching a chunk that isn't resident pages it in, evicting the
+// least recently used one (re-encoding it first if it was written to). reads look like Array2D's
+// (grid[x][y], width(), height()) so the pathfinding queries work on either.
+//
+// paging happens on reads too, so this is not thread safe even for const access: every thread needs its own.
+//
+template <typename T>
+class ChunkedGrid {
+private:
+    // vector<bool> can't hand out pointers
+    typedef typename std::conditional<std::is_same<T, bool>::value, uint8_t, T>::type Cell;
+    static const int CHUNK_CELLS = MAP_CHUNK_SIZE * MAP_CHUNK_SIZE;
+
+    struct Chunk {
+        std::vector<Cell> run_values;
+        std::vector<uint16_t> run_lengths;
+        int slot = -1;          // into slot_data, -1 when paged out
+        bool is_dirty = false;  // resident copy differs from the runs
+        int lru_prev = -1;      // towards more recently used
+        int lru_next = -1;
+    };
+
+    class Column {
+    private:
+        const ChunkedGrid* grid;
+        int x;
+
+    public:
+        Column(const ChunkedGrid* grid, int x) : grid(grid), x(x) {}
+        T operator[](int y) const {
+            return grid->get(x, y);
+        }
+    };
+
+    int grid_width = 0;
+    int grid_height = 0;
+    int chunks_x = 0;
+    int max_resident = 0;
+    mutable std::vector<Chunk> chunks;
+    mutable std::vector<Cell> slot_data;      // CHUNK_CELLS per slot
+    mutable std::vector<int> slot_chunks;     // which chunk is in each slot
+    mutable int lru_head = -1;                // most recently used
+    mutable int lru_tail = -1;
+    mutable int last_chunk = -1;              // skips the lru bookkeeping while we stay in one chunk
+    mutable int last_offset = 0;
+    mutable ChunkStats stats;
+
+    static double get_ms() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static size_t get_stored_bytes(const Chunk& chunk) {
+        return chunk.run_values.size() * sizeof(Cell) + chunk.run_lengths.size() * sizeof(uint16_t);
+    }
+
+    // a chunk that doesn't compress (a distance field, say) is kept as it is instead: no run lengths, and
+    // run_values holds every cell
+    void encode(const Cell* cells, Chunk& chunk) const {
+        stats.stored_bytes -= get_stored_bytes(chunk);
+        chunk.run_values.clear();
+        chunk.run_lengths.clear();
+        static const size_t MAX_RUNS = CHUNK_CELLS * sizeof(Cell) / (sizeof(Cell) + sizeof(uint16_t));
+        for (int i = 0; i < CHUNK_CELLS; ++i) {
+            if (!chunk.run_values.empty() && chunk.run_values.back() == cells[i])
+                chunk.run_lengths.back() += 1;
+            else if (chunk.run_values.size() == MAX_RUNS) {
+                chunk.run_values.assign(cells, cells + CHUNK_CELLS);
+                chunk.run_lengths.clear();
+                break;
+            }
+            else {
+                chunk.run_values.push_back(cells[i]);
+                chunk.run_lengths.push_back(1);
+            }
+        }
+        chunk.run_values.shrink_to_fit();
+        chunk.run_lengths.shrink_to_fit();
+        stats.stored_bytes += get_stored_bytes(chunk);
+    }
+
+    static void decode(const Chunk& chunk, Cell* cells) {
+        if (chunk.run_lengths.empty()) {
+            std::copy(chunk.run_values.begin(), chunk.run_values.end(), cells);
+            return;
+        }
+        for (size_t run = 0; run < chunk.run_values.size(); ++run) {
+            std::fill(cells, cells + chunk.run_lengths[run], chunk.run_values[run]);
+            cells += chunk.run_lengths[run];
+        }
+    }
+
+    void lru_unlink(int c) const {
+        Chunk& chunk = chunks[c];
+        if (chunk.lru_prev >= 0)
+            chunks[chunk.lru_prev].lru_next = chunk.lru_next;
+        else
+            lru_head = chunk.lru_next;
+        if (chunk.lru_next >= 0)
+            chunks[chunk.lru_next].lru_prev = chunk.lru_prev;
+        else
+            lru_tail = chunk.lru_prev;
+        chunk.lru_prev = -1;
+        chunk.lru_next = -1;
+    }
+
+    void lru_push_front(int c) const {
+        chunks[c].lru_next = lru_head;
+        if (lru_head >= 0)
+            chunks[lru_head].lru_prev = c;
+        lru_head = c;
+        if (lru_tail < 0)
+            lru_tail = c;
+    }
+
+    // makes chunk c resident and most recently used, returns its offset into slot_data
+    int touch(int c) const {
+        Chunk& chunk = chunks[c];
+        if (chunk.slot >= 0) {
+            if (lru_head != c) {
+                lru_unlink(c);
+                lru_push_front(c);
+            }
+            return chunk.slot * CHUNK_CELLS;
+        }
+        double start = get_ms();
+        int slot;
+        if (static_cast<int>(slot_chunks.size()) < max_resident) {
+            slot = slot_chunks.size();
+            slot_chunks.push_back(c);
+            slot_data.resize(slot_data.size() + CHUNK_CELLS);
+        }
+        else {
+            int evicted = lru_tail;
+            Chunk& victim = chunks[evicted];
+            slot = victim.slot;
+            if (victim.is_dirty)
+                encode(&slot_data[slot * CHUNK_CELLS], victim);
+            victim.slot = -1;
+            victim.is_dirty = false;
+            lru_unlink(evicted);
+            slot_chunks[slot] = c;
+            stats.page_outs += 1;
+            if (evicted == last_chunk)
+                last_chunk = -1;
+        }
+        decode(chunk, &slot_data[slot * CHUNK_CELLS]);
+        chunk.slot = slot;
+        lru_push_front(c);
+        double elapsed = get_ms() - start;
+        stats.page_ins += 1;
+        stats.page_in_ms += elapsed;
+        stats.max_page_in_ms = std::max(stats.max_page_in_ms, elapsed);
+        return slot * CHUNK_CELLS;
+    }
+
+    int get_offset(int x, int y) const {
+        if (x < 0 || x >= grid_width || y < 0 || y >= grid_height)
+            throw std::out_of_range("ChunkedGrid index out of range");
+        int c = (x / MAP_CHUNK_SIZE) + (y / MAP_CHUNK_SIZE) * chunks_x;
+        if (c != last_chunk) {
+            last_offset = touch(c);
+            last_chunk = c;
+        }
+        return last_offset + (x % MAP_CHUNK_SIZE) + (y % MAP_CHUNK_SIZE) * MAP_CHUNK_SIZE;
+    }
+
+    template <typename NextValue>
+    void fill(NextValue& next_value) {
+        std::vector<Cell> band(static_cast<size_t>(chunks_x) * CHUNK_CELLS);
+        for (size_t c0 = 0; c0 < chunks.size(); c0 += chunks_x) {
+            int y0 = (c0 / chunks_x) * MAP_CHUNK_SIZE;
+            std::fill(band.begin(), band.end(), Cell());
+            for (int y = y0; y < std::min(y0 + MAP_CHUNK_SIZE, grid_height); ++y) {
+                for (int x = 0; x < grid_width; ++x)
+                    band[(x / MAP_CHUNK_SIZE) * CHUNK_CELLS + (x % MAP_CHUNK_SIZE) + (y - y0) * MAP_CHUNK_SIZE] = next_value();
+            }
+            for (int cx = 0; cx < chunks_x; ++cx)
+                encode(&band[cx * CHUNK_CELLS], chunks[c0 + cx]);
+        }
+    }
+
+    void init(int width, int height, int resident_chunks) {
+        if (width < 0 || height < 0 || resident_chunks < 1)
+            throw std::invalid_argument("Invalid ChunkedGrid dimensions");
+        grid_width = width;
+        grid_height = height;
+        chunks_x = (width + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE;
+        int chunks_y = (height + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE;
+        chunks.resize(chunks_x * chunks_y);
+        max_resident = std::min(resident_chunks, std::max(static_cast<int>(chunks.size()), 1));
+    }
+
+public:
+    ChunkedGrid() {}
+
+    // values is indexed x + y * width, like the tile_dat in map json
+    ChunkedGrid(int width, int height, const std::vector<T>& values, int resident_chunks = MAP_RESIDENT_CHUNKS) {
+        if (static_cast<size_t>(width) * height != values.size())
+            throw std::invalid_argument("Input vector size does not match the specified dimensions");
+        init(width, height, resident_chunks);
+        size_t i = 0;
+        auto next_value = [&values, &i]() -> T { return values[i++]; };
+        fill(next_value);
+    }
+
+    // next_value() gets called width * height times, for the values in x + y * width order. only one row of
+    // chunks is ever held decoded, so a whole map can be streamed in without the flat vector
+    template <typename NextValue>
+    static ChunkedGrid generate(int width, int height, NextValue next_value, int resident_chunks = MAP_RESIDENT_CHUNKS) {
+        ChunkedGrid grid;
+        grid.init(width, height, resident_chunks);
+        grid.fill(next_value);
+        return grid;
+    }
+
+    ChunkedGrid(int width, int height, const T& initial_value, int resident_chunks = MAP_RESIDENT_CHUNKS) {
+        init(width, height, resident_chunks);
+        for (Chunk& chunk : chunks) {
+            chunk.run_values.assign(1, initial_value);
+            chunk.run_lengths.assign(1, CHUNK_CELLS);
+            stats.stored_bytes += get_stored_bytes(chunk);
+        }
+    }
+
+    int width() const {
+        return grid_width;
+    }
+
+    int height() const {
+        return grid_height;
+    }
+
+    int get_max_resident() const {
+        return max_resident;
+    }
+
+    T get(int x, int y) const {
+        return slot_data[get_offset(x, y)];
+    }
+
+    void set(int x, int y, const T& value) {
+        int offset = get_offset(x, y);
+        slot_data[offset] = value;
+        chunks[last_chunk].is_dirty = true;
+    }
+
+    Column operator[](int x) const {
+        if (x < 0 || x >= grid_width)
+            throw std::out_of_range("Row index out of range");
+        return Column(this, x);
+    }
+
+    // pages in (and marks as recently used) every chunk overlapping the tile rect
+    void prefetch(int x0, int y0, int x1, int y1) const {
+        int cx0 = std::max(x0, 0) / MAP_CHUNK_SIZE;
+        int cy0 = std::max(y0, 0) / MAP_CHUNK_SIZE;
+        int cx1 = std::min(x1, grid_width - 1) / MAP_CHUNK_SIZE;
+        int cy1 = std::min(y1, grid_height - 1) / MAP_CHUNK_SIZE;
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            for (int cx = cx0; cx <= cx1; ++cx)
+                touch(cx + cy * chunks_x);
+        }
+        last_chunk = -1;
+    }
+
+    // decoded copy of the whole thing, for the preprocessing that needs it all at once. doesn't page anything
+    Array2D<T> expand() const {
+        Array2D<T> out(grid_width, grid_height, T());
+        std::vector<Cell> cells(CHUNK_CELLS);
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            const Cell* source = cells.data();
+            if (chunks[c].slot >= 0)
+                source = &slot_data[chunks[c].slot * CHUNK_CELLS];
+            else
+                decode(chunks[c], cells.data());
+            int x0 = (c % chunks_x) * MAP_CHUNK_SIZE;
+            int y0 = (c / chunks_x) * MAP_CHUNK_SIZE;
+            for (int x = x0; x < std::min(x0 + MAP_CHUNK_SIZE, grid_width); ++x) {
+                for (int y = y0; y < std::min(y0 + MAP_CHUNK_SIZE, grid_height); ++y)
+                    out[x][y] = source[(x - x0) + (y - y0) * MAP_CHUNK_SIZE];
+            }
+        }
+        return out;
+    }
+
+    ChunkStats get_stats() const {
+        ChunkStats out = stats;
+        out.num_chunks = chunks.size();
+        out.resident_chunks = slot_chunks.size();
+        out.resident_bytes = slot_data.size() * sizeof(Cell);
+        out.full_bytes = static_cast<size_t>(grid_width) * grid_height * sizeof(Cell);
+        return out;
+    }
+};
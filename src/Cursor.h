@@ -4,6 +4,7 @@
 
 #include <SDL.h>
 
+#include "AssetLoader.h"
 #include "Vec2.h"
 
 extern SDL_Renderer* renderer;
@@ -19,14 +20,14 @@ private:
     int animation_tick_cursor;
     int animation_tick_click_animation;
     std::vector<vec2<int>> cursor_sizes;
-    std::vector<SDL_Texture*> textures_cursor;
-    std::vector<SDL_Texture*> textures_click;
-    std::vector<SDL_Texture*> textures_shiftclick;
+    std::vector<int> sprites_cursor;       // texture_atlas sprites
+    std::vector<int> sprites_click;
+    std::vector<int> sprites_shiftclick;
     vec2<int> click_animation_position;
     bool click_animation_is_queue;
 
 public:
-    Cursor(std::vector<std::string> cursor_images, std::string click_image, std::string shiftclick_image);
+    Cursor(AssetLoader& loader, std::vector<std::string> cursor_images, std::string click_image, std::string shiftclick_image);
     ~Cursor();
     vec2<int> get_pos();
     void start_click_animation(bool is_queue);
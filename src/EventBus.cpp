@@ -0,0 +1,63 @@
+#include "EventBus.h"
+
+#include <stdexcept>
+#include <unordered_map>
+
+static std::unordered_map<std::string, int> interned_ids;
+static std::vector<std::string> interned_names;
+
+int intern_name(const std::string& name) {
+    auto it = interned_ids.find(name);
+    if (it != interned_ids.end())
+        return it->second;
+    int id = interned_names.size();
+    interned_ids[name] = id;
+    interned_names.push_back(name);
+    return id;
+}
+
+const std::string& get_interned_name(int id) {
+    if (id < 0 || id >= static_cast<int>(interned_names.size()))
+        throw std::invalid_argument("Requesting invalid interned name");
+    return interned_names[id];
+}
+
+EventBus::EventBus() :
+    ring(EVENT_BUS_CAPACITY),
+    head(0),
+    count(0) {}
+
+// the previous tick's events are dropped, new ones continue around the ring from where those ended
+void EventBus::clear() {
+    head = (head + count) & (ring.size() - 1);
+    count = 0;
+}
+
+void EventBus::push(const Event& event) {
+    if (count == ring.size()) {
+        std::vector<Event> bigger(2 * ring.size());
+        for (size_t i = 0; i < count; ++i)
+            bigger[i] = (*this)[i];
+        ring.swap(bigger);
+        head = 0;
+    }
+    ring[(head + count) & (ring.size() - 1)] = event;
+    count += 1;
+}
+
+void EventBus::push(EventType type, int data_id, int data_id_2, const vec2<int>& data_vec) {
+    Event event;
+    event.type = type;
+    event.data_id = data_id;
+    event.data_id_2 = data_id_2;
+    event.data_vec = data_vec;
+    push(event);
+}
+
+size_t EventBus::size() const {
+    return count;
+}
+
+const Event& EventBus::operator[](size_t i) const {
+    return ring[(head + i) & (ring.size() - 1)];
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "globals.h"
+
+static const size_t EVENT_BUS_CAPACITY = 256; // power of two, grows (by doubling) if a tick ever overflows it
+
+// names (animations, locations) are turned into small ints once, at load time, so events never carry strings
+int intern_name(const std::string& name);
+const std::string& get_interned_name(int id);
+
+//
+// ring buffer of the events raised during the current tick. Game::tick clears it, the game state / world map
+// append to it, and Game::tick dispatches whatever ended up in it. no allocations once it has warmed up.
+//
+class EventBus {
+private:
+    std::vector<Event> ring;
+    size_t head;
+    size_t count;
+
+public:
+    EventBus();
+    void clear();
+    void push(const Event& event);
+    void push(EventType type, int data_id, int data_id_2, const vec2<int>& data_vec);
+    size_t size() const;
+    const Event& operator[](size_t i) const;
+};
@@ -0,0 +1,156 @@
+#include "ExplosionMask.h"
+
+#include <algorithm>
+#include <cmath>
+
+ExplosionMask::ExplosionMask() :
+    width(0),
+    height(0),
+    words_per_row(0) {}
+
+ExplosionMask::ExplosionMask(int map_width, int map_height) :
+    width(map_width),
+    height(map_height),
+    words_per_row((map_width + 63) / 64),
+    exploding_now(static_cast<size_t>((map_width + 63) / 64) * map_height, 0),
+    exploding_edges(exploding_now.size(), 0) {}
+
+// tiles x0..x1, y0..y1 clipped to the map
+ExplosionMask::TileSpan ExplosionMask::get_tile_span(int x0, int y0, int x1, int y1) const {
+    TileSpan span;
+    span.x0 = std::max(x0, 0);
+    span.y0 = std::max(y0, 0);
+    span.x1 = std::min(x1, width - 1);
+    span.y1 = std::min(y1, height - 1);
+    if (span.x0 > span.x1 || span.y0 > span.y1) {
+        span.x0 = 0;
+        span.x1 = -1;
+        span.y0 = 0;
+        span.y1 = -1;
+        return span;
+    }
+    span.w0 = span.x0 / 64;
+    span.w1 = span.x1 / 64;
+    span.first_bits = ~uint64_t(0) << (span.x0 % 64);
+    span.last_bits = ~uint64_t(0) >> (63 - span.x1 % 64);
+    if (span.w0 == span.w1) {
+        span.first_bits &= span.last_bits;
+        span.last_bits = span.first_bits;
+    }
+    return span;
+}
+
+void ExplosionMask::set_bits(std::vector<uint64_t>& mask, const TileSpan& span) {
+    for (int y = span.y0; y <= span.y1; ++y) {
+        uint64_t* row = &mask[y * words_per_row];
+        row[span.w0] |= span.first_bits;
+        for (int w = span.w0 + 1; w < span.w1; ++w)
+            row[w] = ~uint64_t(0);
+        row[span.w1] |= span.last_bits;
+        dirty_rows.push_back(y);
+    }
+}
+
+bool ExplosionMask::any_bits(const std::vector<uint64_t>& mask, const TileSpan& span) const {
+    for (int y = span.y0; y <= span.y1; ++y) {
+        const uint64_t* row = &mask[y * words_per_row];
+        if (span.w0 == span.w1) {
+            if (row[span.w0] & span.first_bits)
+                return true;
+            continue;
+        }
+        if ((row[span.w0] & span.first_bits) || (row[span.w1] & span.last_bits))
+            return true;
+        for (int w = span.w0 + 1; w < span.w1; ++w) {
+            if (row[w])
+                return true;
+        }
+    }
+    return false;
+}
+
+// the tiles a unit's body overlaps with nonzero area
+ExplosionMask::TileSpan ExplosionMask::get_body_tiles(const vec2<float>& position, float radius) const {
+    int x0 = static_cast<int>(std::floor((position.x - radius) / F_GRIDSIZE));
+    int y0 = static_cast<int>(std::floor((position.y - radius) / F_GRIDSIZE));
+    int x1 = static_cast<int>(std::ceil((position.x + radius) / F_GRIDSIZE)) - 1;
+    int y1 = static_cast<int>(std::ceil((position.y + radius) / F_GRIDSIZE)) - 1;
+    return get_tile_span(x0, y0, std::max(x1, x0), std::max(y1, y0));
+}
+
+// locations hanging off the map are clipped (the part off it never kills anything). a location that isn't tile
+// aligned gets its partly covered tiles in edges, so only those ever need the exact rect test
+void ExplosionMask::add_obstacle(const std::vector<Rect>& locations) {
+    std::vector<LocationMask> masks;
+    for (const Rect& loc : locations) {
+        LocationMask m;
+        int left = std::max(loc.position.x, 0);
+        int top = std::max(loc.position.y, 0);
+        int right = std::min(loc.position.x + loc.size.x, width * GRIDSIZE);
+        int bottom = std::min(loc.position.y + loc.size.y, height * GRIDSIZE);
+        m.rect = {{left, top}, {right - left, bottom - top}};
+        if (left >= right || top >= bottom) {
+            // empty location, never kills anything
+            m.whole = get_tile_span(0, 0, -1, -1);
+            m.edges = m.whole;
+        }
+        else {
+            m.whole = get_tile_span((left + GRIDSIZE - 1) / GRIDSIZE, (top + GRIDSIZE - 1) / GRIDSIZE,
+                                    right / GRIDSIZE - 1, bottom / GRIDSIZE - 1);
+            m.edges = get_tile_span(left / GRIDSIZE, top / GRIDSIZE, (right - 1) / GRIDSIZE, (bottom - 1) / GRIDSIZE);
+            if (m.edges.x0 == m.whole.x0 && m.edges.x1 == m.whole.x1 && m.edges.y0 == m.whole.y0 && m.edges.y1 == m.whole.y1)
+                m.edges = get_tile_span(0, 0, -1, -1);
+        }
+        masks.push_back(m);
+    }
+    location_masks.push_back(masks);
+}
+
+// only touch the rows that something exploded in last time
+void ExplosionMask::clear() {
+    for (int y : dirty_rows) {
+        std::fill(exploding_now.begin() + y * words_per_row, exploding_now.begin() + (y + 1) * words_per_row, 0);
+        std::fill(exploding_edges.begin() + y * words_per_row, exploding_edges.begin() + (y + 1) * words_per_row, 0);
+    }
+    dirty_rows.clear();
+    exploded_locs.clear();
+}
+
+// ob_index and loc_index are 0-indexed
+void ExplosionMask::explode(int ob_index, int loc_index) {
+    if (ob_index < 0 || ob_index >= static_cast<int>(location_masks.size()))
+        return;
+    if (loc_index < 0 || loc_index >= static_cast<int>(location_masks[ob_index].size()))
+        return;
+    const LocationMask& m = location_masks[ob_index][loc_index];
+    set_bits(exploding_now, m.whole);
+    set_bits(exploding_edges, m.edges);
+    exploded_locs.push_back({ob_index, loc_index});
+}
+
+bool ExplosionMask::any_exploding() const {
+    return !exploded_locs.empty();
+}
+
+bool ExplosionMask::is_exploding(const vec2<float>& position, float radius) const {
+    TileSpan body = get_body_tiles(position, radius);
+    if (any_bits(exploding_now, body))
+        return true;
+    if (!any_bits(exploding_edges, body))
+        return false;
+    return get_exploding_location(position, radius).x >= 0;
+}
+
+// which location exploded under the unit, as 1-indexed (ob_num, loc_num). (-1,-1) if nothing did.
+// only needed once a unit is known to be dead (or is on a partly covered tile), so a linear scan over this
+// tick's explosions is fine
+vec2<int> ExplosionMask::get_exploding_location(const vec2<float>& position, float radius) const {
+    for (const vec2<int>& ob_loc : exploded_locs) {
+        const Rect& rect = location_masks[ob_loc.x][ob_loc.y].rect;
+        if (rect.size.x > 0 && rect.size.y > 0 &&
+            position.x - radius < static_cast<float>(rect.position.x + rect.size.x) && position.x + radius > static_cast<float>(rect.position.x) &&
+            position.y - radius < static_cast<float>(rect.position.y + rect.size.y) && position.y + radius > static_cast<float>(rect.position.y))
+            return {ob_loc.x + 1, ob_loc.y + 1};
+    }
+    return {-1, -1};
+}
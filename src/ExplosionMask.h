@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+#include "globals.h"
+#include "Vec2.h"
+
+// a unit standing in an exploding location this tick
+struct KillEvent {
+    int unit_id;
+    int ob_num;   // 1-indexed, like the map json
+    int loc_num;  // 1-indexed, like the map json
+};
+
+//
+// obstacle locations compiled into bitmasks over the tile grid (one bit per tile, rows packed into 64-bit words).
+// each tick the masks of every location that exploded are OR'd into the "exploding now" masks: one for the tiles
+// a location covers whole, one for the tiles along its edges it only covers part of. checking if a unit died is
+// a few bit lookups over the tiles under its body, with an exact test against the location rects only when
+// those include a partly covered tile.
+//
+class ExplosionMask {
+private:
+    // a span of tiles: rows y0..y1, each row covering words w0..w1 with partial masks at either end (empty if
+    // x0 > x1 or y0 > y1)
+    struct TileSpan {
+        int x0, x1, y0, y1;
+        int w0, w1;
+        uint64_t first_bits;
+        uint64_t last_bits;
+    };
+    struct LocationMask {
+        Rect rect;        // in pixels
+        TileSpan whole;   // tiles inside the rect
+        TileSpan edges;   // every tile the rect overlaps, empty when that's the same as whole
+    };
+
+    int width;
+    int height;
+    int words_per_row;
+    std::vector<uint64_t> exploding_now;
+    std::vector<uint64_t> exploding_edges;
+    std::vector<std::vector<LocationMask>> location_masks; // [obstacle index][location index]
+    std::vector<int> dirty_rows;
+    std::vector<vec2<int>> exploded_locs;                  // (obstacle index, location index) that went off this tick
+
+    TileSpan get_tile_span(int x0, int y0, int x1, int y1) const;
+    void set_bits(std::vector<uint64_t>& mask, const TileSpan& span);
+    bool any_bits(const std::vector<uint64_t>& mask, const TileSpan& span) const;
+    TileSpan get_body_tiles(const vec2<float>& position, float radius) const;
+
+public:
+    ExplosionMask();
+    ExplosionMask(int map_width, int map_height);
+    void add_obstacle(const std::vector<Rect>& locations);
+    void clear();
+    void explode(int ob_index, int loc_index);
+    bool any_exploding() const;
+    // the unit's body is the square radius around position, it's exploding if that overlaps an exploding location
+    bool is_exploding(const vec2<float>& position, float radius = PLAYER_RADIUS) const;
+    vec2<int> get_exploding_location(const vec2<float>& position, float radius = PLAYER_RADIUS) const;
+};
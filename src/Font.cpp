@@ -1,19 +1,17 @@
 #include "Font.h"
 
+#include <algorithm>
 #include <string>
 #include <unordered_map>
 
 #include "misc_gfx.h"
 #include "globals.h"
+#include "TextureAtlas.h"
 
 Font::Font() : spacing(1), char_height(0) {}
 
-Font::Font(const std::string& path, SDL_Color color, int scalar) :
-    spacing(scalar),
-    char_height(0) {
-
-    SDL_Surface* font_img = load_image(path, false);
-
+// recolors font_img in place and cuts it into one RGBA32 surface per character of CHARACTER_ORDER
+static std::vector<SDL_Surface*> slice_font(SDL_Surface* font_img, SDL_Color color, int scalar) {
     // recolor
     SDL_LockSurface(font_img);
     Uint32* pixels = static_cast<Uint32*>(font_img->pixels);
@@ -30,9 +28,9 @@ Font::Font(const std::string& path, SDL_Color color, int scalar) :
     SDL_UnlockSurface(font_img);
 
     // separate characters
+    std::vector<SDL_Surface*> char_surfaces;
     int current_char_width = 0;
-    int character_count = 0;
-    for (int x = 0; x < font_img->w; ++x) {
+    for (int x = 0; x < font_img->w && char_surfaces.size() < CHARACTER_ORDER.size(); ++x) {
         Uint32 pixel = pixels[x];
         Uint8 r, g, b, a;
         SDL_GetRGBA(pixel, font_img->format, &r, &g, &b, &a);
@@ -51,37 +49,61 @@ Font::Font(const std::string& path, SDL_Color color, int scalar) :
                 char_surface = scaled_surface;
             }
 
-            char c = CHARACTER_ORDER[character_count];
-            char_width[c] = char_surface->w;
-            char_height = std::max(char_height, char_surface->h);
             SDL_SetColorKey(char_surface, SDL_TRUE, SDL_MapRGB(char_surface->format, TRANS_COL.r, TRANS_COL.g, TRANS_COL.b));
-            char_textures[c] = SDL_CreateTextureFromSurface(renderer, char_surface);
+            char_surfaces.push_back(colorkey_to_alpha(char_surface));
             SDL_FreeSurface(char_surface);
-
-            character_count++;
             current_char_width = 0;
         } else {
             current_char_width++;
         }
     }
+    return char_surfaces;
+}
+
+Font::Font(const std::string& path, SDL_Color color, int scalar) : Font(scalar) {
+    SDL_Surface* font_img = load_image(path, false);
+    add_characters(slice_font(font_img, color, scalar));
     SDL_FreeSurface(font_img);
+}
+
+Font::Font(AssetLoader& loader, int handle, int scalar) : Font(scalar) {
+    add_characters(loader.take(handle));
+}
+
+Font::Font(int scalar) : spacing(scalar), char_height(0) {}
+
+// queues decoding + slicing the font image on loader's workers, hand the result to Font(loader, handle, scalar)
+int Font::load(AssetLoader& loader, const std::string& path, SDL_Color color, int scalar) {
+    return loader.load(path, [color, scalar](SDL_Surface* font_img) {
+        return slice_font(font_img, color, scalar);
+    });
+}
+
+void Font::add_characters(const std::vector<SDL_Surface*>& char_surfaces) {
+    for (size_t i = 0; i < char_surfaces.size(); ++i) {
+        char c = CHARACTER_ORDER[i];
+        char_width[c] = char_surfaces[i]->w;
+        char_height = std::max(char_height, char_surfaces[i]->h);
+        char_sprites[c] = texture_atlas->add_rgba_surface(char_surfaces[i]);
+    }
     char_width[' '] = char_width['A'];
 }
 
 Font::~Font() {
-    for (auto& pair : char_textures)
-        SDL_DestroyTexture(pair.second);
+    // sprites belong to texture_atlas
 }
 
 void Font::draw_text(const std::string& text, const vec2<int>& position) {
     int current_x = 0;
     for (char c : text) {
-        if (char_textures.find(c) != char_textures.end()) {
+        auto it = char_sprites.find(c);
+        if (it != char_sprites.end()) {
             SDL_Rect rect = {current_x + position.x, position.y, char_width[c], char_height};
-            SDL_RenderCopy(renderer, char_textures[c], nullptr, &rect);
+            texture_atlas->queue(it->second, rect);
             current_x += char_width[c] + spacing;
         } else if (c == ' ') {
             current_x += char_width[' '] + spacing;
         }
     }
+    texture_atlas->flush();
 }
@@ -1,9 +1,11 @@
 #pragma once
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <SDL.h>
 
+#include "AssetLoader.h"
 #include "Vec2.h"
 
 extern SDL_Renderer* renderer;
@@ -14,12 +16,17 @@ class Font {
 private:
     int spacing;
     int char_height;
-    std::unordered_map<char, SDL_Texture*> char_textures;
+    std::unordered_map<char, int> char_sprites;    // texture_atlas sprites
     std::unordered_map<char, int> char_width;
 
+    explicit Font(int scalar);
+    void add_characters(const std::vector<SDL_Surface*>& char_surfaces);
+
 public:
     Font();
     Font(const std::string& path, SDL_Color color, int scalar = 1);
+    Font(AssetLoader& loader, int handle, int scalar = 1);
+    static int load(AssetLoader& loader, const std::string& path, SDL_Color color, int scalar = 1);
     ~Font();
     void draw_text(const std::string& text, const vec2<int>& position);
 };
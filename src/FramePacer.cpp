@@ -0,0 +1,121 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "Profiler.h"
+
+static const int OVERSLEEP_MAX_COUNT = 1000;  // stop growing the sample count so the estimate keeps adapting
+static const double CPU_USAGE_WINDOW = 1.0;    // seconds
+
+FramePacer::FramePacer(double target_fps) :
+    target_fps(target_fps),
+    frame_intervals(FRAME_PACER_SAMPLES, 0.0f),
+    frame_busy(FRAME_PACER_SAMPLES, 0.0f) {
+    cpu_clock_start = std::clock();
+    cpu_wall_start = get_precise_time();
+}
+
+void FramePacer::set_target_fps(double fps) {
+    target_fps = fps;
+}
+
+double FramePacer::get_target_fps() const {
+    return target_fps;
+}
+
+double FramePacer::get_oversleep_estimate() const {
+    if (oversleep_count < 2)
+        return oversleep_mean;
+    return oversleep_mean + std::sqrt(oversleep_m2 / (oversleep_count - 1));
+}
+
+void FramePacer::sleep_until(double deadline) {
+    PROFILE_ZONE("frame pacing");
+    while (true) {
+        double remaining = deadline - get_precise_time();
+        double margin = get_oversleep_estimate() + FRAME_PACER_SPIN_TIME;
+        if (remaining <= margin)
+            break;
+        double requested = remaining - margin;
+        double start_time = get_precise_time();
+        std::this_thread::sleep_for(std::chrono::duration<double>(requested));
+        double oversleep = std::max(get_precise_time() - start_time - requested, 0.0);
+        if (oversleep_count < OVERSLEEP_MAX_COUNT)
+            oversleep_count += 1;
+        double delta = oversleep - oversleep_mean;
+        oversleep_mean += delta / oversleep_count;
+        oversleep_m2 += delta * (oversleep - oversleep_mean);
+    }
+    while (get_precise_time() < deadline)
+        std::this_thread::yield();
+}
+
+void FramePacer::begin_frame() {
+    double now = get_precise_time();
+    if (frame_start_time > 0.0) {
+        frame_intervals[next_sample] = now - frame_start_time;
+        next_sample = (next_sample + 1) % FRAME_PACER_SAMPLES;
+        num_samples = std::min(num_samples + 1, FRAME_PACER_SAMPLES);
+    }
+    frame_start_time = now;
+    if (now - cpu_wall_start >= CPU_USAGE_WINDOW) {
+        std::clock_t cpu_clock = std::clock();
+        cpu_usage = (cpu_clock - cpu_clock_start) / static_cast<double>(CLOCKS_PER_SEC) / (now - cpu_wall_start);
+        cpu_clock_start = cpu_clock;
+        cpu_wall_start = now;
+    }
+}
+
+// waits for the next frame (or other_deadline, e.g. the next tick, if that comes first)
+void FramePacer::end_frame(double other_deadline) {
+    double now = get_precise_time();
+    frame_busy[next_sample] = now - frame_start_time;
+    double deadline = other_deadline;
+    if (target_fps > 0.0) {
+        double frame_time = 1.0 / target_fps;
+        next_frame_time += frame_time;
+        // fell more than a frame behind: start over from now rather than rushing out frames to catch up
+        if (next_frame_time < now - frame_time)
+            next_frame_time = now;
+        deadline = other_deadline > 0.0 ? std::min(next_frame_time, other_deadline) : next_frame_time;
+    }
+    if (deadline > now)
+        sleep_until(deadline);
+}
+
+float FramePacer::get_jitter_ms() const {
+    if (num_samples < 2)
+        return 0.0f;
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    for (int i = 0; i < num_samples; ++i) {
+        sum += frame_intervals[i];
+        sum_sq += frame_intervals[i] * frame_intervals[i];
+    }
+    double mean = sum / num_samples;
+    return 1000.0 * std::sqrt(std::max(sum_sq / num_samples - mean * mean, 0.0));
+}
+
+float FramePacer::get_max_interval_ms() const {
+    float max_interval = 0.0f;
+    for (int i = 0; i < num_samples; ++i)
+        max_interval = std::max(max_interval, frame_intervals[i]);
+    return 1000.0f * max_interval;
+}
+
+float FramePacer::get_busy_fraction() const {
+    double busy = 0.0;
+    double total = 0.0;
+    for (int i = 0; i < num_samples; ++i) {
+        busy += frame_busy[i];
+        total += frame_intervals[i];
+    }
+    return total > 0.0 ? busy / total : 0.0f;
+}
+
+float FramePacer::get_cpu_usage() const {
+    return cpu_usage;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <ctime>
+#include <vector>
+
+static const int FRAME_PACER_SAMPLES = 120;         // frames the jitter/cpu stats are averaged over
+static const double FRAME_PACER_SPIN_TIME = 0.0005; // spin (instead of sleeping) for the last half millisecond
+
+//
+// frame limiter for the native main loop. sleeps until a deadline in chunks, learning how much the os tends
+// to oversleep by, and only spins for the last little bit so it wakes up on time without burning a core.
+//
+class FramePacer {
+private:
+    double target_fps;
+    double next_frame_time = 0.0;
+    // oversleep estimate (mean + stddev of how late sleeps wake up, welford)
+    double oversleep_mean = 0.0;
+    double oversleep_m2 = 0.0;
+    int oversleep_count = 0;
+    // stats
+    double frame_start_time = 0.0;
+    std::vector<float> frame_intervals;  // seconds between frame starts
+    std::vector<float> frame_busy;       // seconds of each frame spent working (not waiting)
+    int next_sample = 0;
+    int num_samples = 0;
+    std::clock_t cpu_clock_start = 0;
+    double cpu_wall_start = 0.0;
+    float cpu_usage = 0.0f;
+
+    double get_oversleep_estimate() const;
+    void sleep_until(double deadline);
+
+public:
+    explicit FramePacer(double target_fps);
+    void set_target_fps(double fps); // <= 0 means unlimited
+    double get_target_fps() const;
+    void begin_frame();
+    void end_frame(double other_deadline = 0.0);
+    float get_jitter_ms() const;       // stddev of the frame interval
+    float get_max_interval_ms() const;
+    float get_busy_fraction() const;   // of the frame time this thread spent not waiting
+    float get_cpu_usage() const;       // process cpu time / wall time (all threads, so can go over 1)
+};
@@ -5,6 +5,7 @@
 
 #include <SDL.h>
 
+#include "EventBus.h"
 #include "geometry.h"
 #include "globals.h"
 #include "misc_gfx.h"
@@ -19,13 +20,13 @@ struct ExplosionCount {
     std::vector<int> locs;
     std::vector<std::string> units;
     int delay;
+    std::vector<int> unit_ids; // interned units
+
 };
 
 class Obstacle {
 private:
     int ob_num;
-    int ob_timer;
-    int ob_currentcount;
     Rect ob_startbox;
     Rect ob_endbox;
     vec2<int> ob_revive;
@@ -34,6 +35,7 @@ private:
     std::string action_changemusic;
     std::vector<Rect> ob_locations;
     std::vector<ExplosionCount> ob_explosions;
+    std::vector<int> ob_location_ids; // interned "obnum-locnum"
 
 public:
     Obstacle(int num, const Rect& startbox, const Rect& endbox, const vec2<int>& revive,
@@ -50,9 +52,12 @@ public:
         ob_locations(locations),
         ob_explosions(explosions) {
         //
-        if (ob_explosions.size() > 0) {
-            ob_currentcount = ob_explosions.size() - 1;
-            ob_timer = ob_explosions[ob_currentcount].delay;
+        for (size_t i = 0; i < ob_locations.size(); ++i)
+            ob_location_ids.push_back(intern_name(std::to_string(ob_num) + "-" + std::to_string(i+1)));
+        for (ExplosionCount& exp : ob_explosions) {
+            exp.unit_ids.clear();
+            for (const std::string& unit : exp.units)
+                exp.unit_ids.push_back(intern_name(unit));
         }
     }
 
@@ -60,11 +65,25 @@ public:
         //
     }
 
-    void reset() {
-        if (ob_explosions.size() > 0) {
-            ob_currentcount = ob_explosions.size() - 1;
-            ob_timer = ob_explosions[ob_currentcount].delay;
-        }
+    vec2<int> get_revive_pos() const {
+        return ob_revive;
+    }
+
+    const std::vector<Rect>& get_locations() const {
+        return ob_locations;
+    }
+
+    int get_num_explosions() const {
+        return ob_explosions.size();
+    }
+
+    int get_explosion_delay(int count) const {
+        return ob_explosions[count].delay;
+    }
+
+    // loc nums (1-indexed) that go off on explosion number count
+    const std::vector<int>& get_explosion_locs(int count) const {
+        return ob_explosions[count].locs;
     }
 
     void check_for_ob_start(const vec2<int>& player_pos);
@@ -74,35 +93,22 @@ public:
     void add_event_playsound();
     void add_event_teleport();
 
-    std::vector<Event> tick() {
-        std::vector<Event> out_events;
-        int num_explosions = ob_explosions.size();
-        if (num_explosions > 0) {
-            ob_timer += 1;
-            bool execute_explosion = false;
-            if (ob_timer > ob_explosions[ob_currentcount].delay) {
-                execute_explosion = true;
-                ob_currentcount += 1;
-                ob_timer = 0;
-                if (ob_currentcount >= num_explosions)
-                    ob_currentcount = 0;
-            }
-            //printf("tick: %i [%i]\n", ob_timer, ob_currentcount);
-            if (execute_explosion) {
-                printf("Bang [%i]!\n", ob_currentcount);
-                for (size_t i = 0; i < ob_explosions[ob_currentcount].locs.size(); ++i) {
-                    int loc_num = ob_explosions[ob_currentcount].locs[i];
-                    Rect exp_loc = ob_locations[loc_num - 1];
-                    Event new_event;
-                    new_event.type = "start_animation";
-                    new_event.data_str = ob_explosions[ob_currentcount].units[i]; // explosion sprite
-                    new_event.data_str_2 = std::to_string(ob_num) + "-" + std::to_string(loc_num); // animation id: obnum_loc
-                    new_event.data_vec = exp_loc.position + vec2<int>(exp_loc.size.x / 2, exp_loc.size.y / 2); // centered coords
-                    out_events.push_back(new_event);
-                }
-            }
+    int get_location_id(int loc_num) const {
+        return ob_location_ids[loc_num - 1];
+    }
+
+    // timing lives in ObstacleScheduler, this just raises the animations for explosion number count
+    void explode(int count, EventBus& events) const {
+        printf("Bang [%i]!\n", count);
+        const ExplosionCount& exp = ob_explosions[count];
+        for (size_t i = 0; i < exp.locs.size(); ++i) {
+            int loc_num = exp.locs[i];
+            Rect exp_loc = ob_locations[loc_num - 1];
+            events.push(EventType::START_ANIMATION,
+                        exp.unit_ids[i],                                                    // explosion sprite
+                        ob_location_ids[loc_num - 1],                                       // animation id: obnum_loc
+                        exp_loc.position + vec2<int>(exp_loc.size.x / 2, exp_loc.size.y / 2)); // centered coords
         }
-        return out_events;
     }
 
     void draw(const vec2<int>& offset) {
@@ -123,7 +129,7 @@ public:
 
         // locs
         for (size_t i = 0; i < ob_locations.size(); ++i) {
-            std::string loc_string = std::to_string(ob_num) + "-" + std::to_string(i+1);
+            const std::string& loc_string = get_interned_name(ob_location_ids[i]);
             my_rect = ob_locations[i];
             my_rect.position -= offset;
             draw_rect(my_rect, OB_LOC_COL, true);
@@ -0,0 +1,183 @@
+#include "ObstacleScheduler.h"
+
+#include <algorithm>
+
+ObstacleScheduler::ObstacleScheduler() :
+    current_tick(0),
+    wheel(TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS) {}
+
+int ObstacleScheduler::find_instance(int ob_index, int player) const {
+    for (size_t i = 0; i < instances.size(); ++i) {
+        if (instances[i].active && instances[i].ob_index == ob_index && instances[i].player == player)
+            return i;
+    }
+    return -1;
+}
+
+// entries are never removed from the wheel directly, they just go stale when their instance moves on
+bool ObstacleScheduler::is_current(const TimerEntry& entry) const {
+    const ObstacleInstance& inst = instances[entry.instance];
+    return inst.active && !inst.paused && inst.generation == entry.generation;
+}
+
+void ObstacleScheduler::schedule(int instance, uint32_t fire_tick) {
+    ObstacleInstance& inst = instances[instance];
+    inst.generation += 1;
+    inst.fire_tick = fire_tick;
+    TimerEntry entry = {instance, inst.generation, fire_tick};
+    uint32_t delta = fire_tick - current_tick;
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; ++level) {
+        int shift = TIMER_WHEEL_BITS * level;
+        if (delta < (uint32_t(1) << (shift + TIMER_WHEEL_BITS))) {
+            int slot = (fire_tick >> shift) & (TIMER_WHEEL_SLOTS - 1);
+            wheel[level * TIMER_WHEEL_SLOTS + slot].push_back(entry);
+            return;
+        }
+    }
+    overflow.push_back(entry);
+}
+
+// redistribute the current slot of a level (or the overflow list, for level == TIMER_WHEEL_LEVELS) into the levels below
+void ObstacleScheduler::cascade(int level) {
+    scratch.clear();
+    if (level < TIMER_WHEEL_LEVELS) {
+        int slot = (current_tick >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+        scratch.swap(wheel[level * TIMER_WHEEL_SLOTS + slot]);
+    }
+    else {
+        scratch.swap(overflow);
+    }
+    for (const TimerEntry& entry : scratch) {
+        if (is_current(entry))
+            schedule(entry.instance, entry.fire_tick);
+    }
+}
+
+// start ob_index for player, first explosion goes off on the next tick. restarts it if it's already running
+void ObstacleScheduler::activate(int ob_index, int player) {
+    int instance = find_instance(ob_index, player);
+    if (instance < 0) {
+        if (free_instances.empty()) {
+            instance = instances.size();
+            instances.push_back(ObstacleInstance());
+            instances[instance].generation = 0;
+        }
+        else {
+            instance = free_instances.back();
+            free_instances.pop_back();
+        }
+        ObstacleInstance& inst = instances[instance];
+        inst.ob_index = ob_index;
+        inst.player = player;
+        inst.active = true;
+    }
+    instances[instance].paused = false;
+    instances[instance].next_count = 0;
+    schedule(instance, current_tick);
+}
+
+void ObstacleScheduler::deactivate(int ob_index, int player) {
+    int instance = find_instance(ob_index, player);
+    if (instance < 0)
+        return;
+    instances[instance].active = false;
+    instances[instance].generation += 1;
+    free_instances.push_back(instance);
+}
+
+void ObstacleScheduler::deactivate_all(int player) {
+    for (size_t i = 0; i < instances.size(); ++i) {
+        if (instances[i].active && instances[i].player == player)
+            deactivate(instances[i].ob_index, player);
+    }
+}
+
+// back to the first explosion, keeping the instance paused if it was
+void ObstacleScheduler::reset(int ob_index, int player) {
+    int instance = find_instance(ob_index, player);
+    if (instance < 0)
+        return;
+    ObstacleInstance& inst = instances[instance];
+    inst.next_count = 0;
+    if (inst.paused) {
+        inst.generation += 1;
+        inst.ticks_left = 0;
+    }
+    else {
+        schedule(instance, current_tick);
+    }
+}
+
+void ObstacleScheduler::pause(int ob_index, int player) {
+    int instance = find_instance(ob_index, player);
+    if (instance < 0 || instances[instance].paused)
+        return;
+    ObstacleInstance& inst = instances[instance];
+    inst.ticks_left = inst.fire_tick - current_tick;
+    inst.paused = true;
+    inst.generation += 1;
+}
+
+void ObstacleScheduler::resume(int ob_index, int player) {
+    int instance = find_instance(ob_index, player);
+    if (instance < 0 || !instances[instance].paused)
+        return;
+    instances[instance].paused = false;
+    schedule(instance, current_tick + instances[instance].ticks_left);
+}
+
+bool ObstacleScheduler::is_active(int ob_index, int player) const {
+    return find_instance(ob_index, player) >= 0;
+}
+
+// running for anybody
+bool ObstacleScheduler::is_active(int ob_index) const {
+    for (const ObstacleInstance& inst : instances) {
+        if (inst.active && inst.ob_index == ob_index)
+            return true;
+    }
+    return false;
+}
+
+bool ObstacleScheduler::is_paused(int ob_index, int player) const {
+    int instance = find_instance(ob_index, player);
+    return instance >= 0 && instances[instance].paused;
+}
+
+//
+// fire everything due on this tick and schedule each instance's next explosion. an explosion with delay d
+// is followed by the next one d+1 ticks later. out_fired is sorted by (ob_index, player).
+//
+void ObstacleScheduler::tick(const std::vector<Obstacle>& obstacles, std::vector<FiredExplosion>& out_fired) {
+    out_fired.clear();
+
+    // whenever a level wraps around, pull the next slot of the level above it down
+    for (int level = 1; level <= TIMER_WHEEL_LEVELS; ++level) {
+        if ((current_tick & ((uint32_t(1) << (TIMER_WHEEL_BITS * level)) - 1)) != 0)
+            break;
+        cascade(level);
+    }
+
+    scratch.clear();
+    scratch.swap(wheel[current_tick & (TIMER_WHEEL_SLOTS - 1)]);
+    for (const TimerEntry& entry : scratch) {
+        if (!is_current(entry))
+            continue;
+        ObstacleInstance& inst = instances[entry.instance];
+        const Obstacle& ob = obstacles[inst.ob_index];
+        int num_explosions = ob.get_num_explosions();
+        if (num_explosions == 0) {
+            inst.generation += 1;
+            continue;
+        }
+        int count = inst.next_count;
+        out_fired.push_back({inst.ob_index, inst.player, count});
+        inst.next_count = (count + 1) % num_explosions;
+        schedule(entry.instance, current_tick + ob.get_explosion_delay(count) + 1);
+    }
+    std::sort(out_fired.begin(), out_fired.end(), [](const FiredExplosion& a, const FiredExplosion& b) {
+        return a.ob_index < b.ob_index || (a.ob_index == b.ob_index && a.player < b.player);
+    });
+
+    current_tick += 1;
+}
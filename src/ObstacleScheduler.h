@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Obstacle.h"
+
+//
+// timer wheel layout: TIMER_WHEEL_LEVELS levels of TIMER_WHEEL_SLOTS slots each. level 0 has one slot per tick,
+// each level above covers TIMER_WHEEL_SLOTS times the span of the one below it. anything further out than the
+// top level can represent waits in an overflow list.
+//
+static const int TIMER_WHEEL_BITS   = 6;
+static const int TIMER_WHEEL_SLOTS  = 1 << TIMER_WHEEL_BITS;
+static const int TIMER_WHEEL_LEVELS = 4;
+
+// an obstacle explosion that's due this tick
+struct FiredExplosion {
+    int ob_index;  // 0-indexed into WorldMap::obstacles
+    int player;
+    int count;     // which exp_ (0-indexed) goes off
+};
+
+//
+// runs any number of obstacles at once (one instance per obstacle per player). the next explosion of every
+// running instance sits in a hierarchical timer wheel, so a tick only costs the instances that fire on it.
+//
+class ObstacleScheduler {
+private:
+    struct ObstacleInstance {
+        int ob_index;
+        int player;
+        int next_count;
+        uint32_t fire_tick;
+        uint32_t ticks_left;    // time until fire_tick when we got paused
+        uint32_t generation;    // bumped to invalidate whatever this instance already has in the wheel
+        bool active;
+        bool paused;
+    };
+
+    struct TimerEntry {
+        int instance;
+        uint32_t generation;
+        uint32_t fire_tick;
+    };
+
+    uint32_t current_tick;
+    std::vector<ObstacleInstance> instances;
+    std::vector<int> free_instances;
+    std::vector<std::vector<TimerEntry>> wheel; // [level * TIMER_WHEEL_SLOTS + slot]
+    std::vector<TimerEntry> overflow;
+    std::vector<TimerEntry> scratch;
+
+    int find_instance(int ob_index, int player) const;
+    bool is_current(const TimerEntry& entry) const;
+    void schedule(int instance, uint32_t fire_tick);
+    void cascade(int level);
+
+public:
+    ObstacleScheduler();
+    void activate(int ob_index, int player = 0);
+    void deactivate(int ob_index, int player = 0);
+    void deactivate_all(int player = 0);
+    void reset(int ob_index, int player = 0);
+    void pause(int ob_index, int player = 0);
+    void resume(int ob_index, int player = 0);
+    bool is_active(int ob_index, int player) const;
+    bool is_active(int ob_index) const;
+    bool is_paused(int ob_index, int player = 0) const;
+    void tick(const std::vector<Obstacle>& obstacles, std::vector<FiredExplosion>& out_fired);
+};
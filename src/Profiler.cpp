@@ -0,0 +1,122 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "globals.h"
+#include "misc_gfx.h"
+
+struct ZoneRecord {
+    const char* name;
+    int64_t start_ns;
+    int64_t end_ns;
+};
+
+struct ProfilerThreadBuffer {
+    int thread_index;
+    std::vector<ZoneRecord> ring;
+    size_t next = 0;
+    size_t count = 0;
+};
+
+static std::mutex all_buffers_mutex;
+static std::vector<std::unique_ptr<ProfilerThreadBuffer>> all_buffers; // owned here so they outlive their threads
+static thread_local ProfilerThreadBuffer* thread_buffer = nullptr;
+
+static std::vector<float> graph_frame_ms(PROFILER_GRAPH_SAMPLES, 0.0f);
+static std::vector<float> graph_tick_ms(PROFILER_GRAPH_SAMPLES, 0.0f);
+static int graph_next = 0;
+
+static int64_t get_precise_time_ns() {
+    static const std::chrono::steady_clock::time_point clock_start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - clock_start).count();
+}
+
+double get_precise_time() {
+    return get_precise_time_ns() / 1e9;
+}
+
+static ProfilerThreadBuffer* get_thread_buffer() {
+    if (thread_buffer == nullptr) {
+        std::lock_guard<std::mutex> lock(all_buffers_mutex);
+        std::unique_ptr<ProfilerThreadBuffer> new_buffer(new ProfilerThreadBuffer());
+        new_buffer->thread_index = all_buffers.size();
+        new_buffer->ring.resize(PROFILER_RING_SIZE);
+        thread_buffer = new_buffer.get();
+        all_buffers.push_back(std::move(new_buffer));
+    }
+    return thread_buffer;
+}
+
+ProfileZone::ProfileZone(const char* name) :
+    name(name),
+    start_ns(get_precise_time_ns()) {}
+
+ProfileZone::~ProfileZone() {
+    ProfilerThreadBuffer* buffer = get_thread_buffer();
+    buffer->ring[buffer->next] = {name, start_ns, get_precise_time_ns()};
+    buffer->next = (buffer->next + 1) % PROFILER_RING_SIZE;
+    if (buffer->count < PROFILER_RING_SIZE)
+        buffer->count += 1;
+}
+
+double ProfileZone::get_elapsed() const {
+    return (get_precise_time_ns() - start_ns) / 1e9;
+}
+
+// other threads keep recording while we read, so only call this while they're idle if exact output matters
+bool profiler_dump_chrome_trace(const std::string& filename) {
+    FILE* f = fopen(filename.c_str(), "w");
+    if (f == nullptr) {
+        printf("could not open %s for writing\n", filename.c_str());
+        return false;
+    }
+    size_t num_zones = 0;
+    fprintf(f, "{\"traceEvents\":[\n");
+    std::lock_guard<std::mutex> lock(all_buffers_mutex);
+    for (const auto& buffer : all_buffers) {
+        size_t first = (buffer->next + PROFILER_RING_SIZE - buffer->count) % PROFILER_RING_SIZE;
+        for (size_t i = 0; i < buffer->count; ++i) {
+            const ZoneRecord& zone = buffer->ring[(first + i) % PROFILER_RING_SIZE];
+            fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f}",
+                    num_zones > 0 ? ",\n" : "", zone.name, buffer->thread_index,
+                    zone.start_ns / 1000.0, (zone.end_ns - zone.start_ns) / 1000.0);
+            num_zones += 1;
+        }
+    }
+    fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(f);
+    printf("wrote %zu profiler zones to %s\n", num_zones, filename.c_str());
+    return true;
+}
+
+void profiler_add_frame_sample(float frame_ms, float tick_ms) {
+    graph_frame_ms[graph_next] = frame_ms;
+    graph_tick_ms[graph_next] = tick_ms;
+    graph_next = (graph_next + 1) % PROFILER_GRAPH_SAMPLES;
+}
+
+// one column per frame, oldest on the left. frame time behind, tick time in front of it
+void draw_profiler_graph(const vec2<int>& position) {
+    int graph_height = 100;
+    float px_per_ms = graph_height / PROFILER_GRAPH_MAX_MS;
+    draw_rect(Rect{position, {PROFILER_GRAPH_SAMPLES, graph_height}}, PROFILER_BG_COL, true);
+    for (int i = 0; i < PROFILER_GRAPH_SAMPLES; ++i) {
+        int sample = (graph_next + i) % PROFILER_GRAPH_SAMPLES;
+        int x = position.x + i;
+        int bottom = position.y + graph_height;
+        int frame_px = std::min(static_cast<int>(graph_frame_ms[sample] * px_per_ms), graph_height);
+        int tick_px = std::min(static_cast<int>(graph_tick_ms[sample] * px_per_ms), graph_height);
+        if (frame_px > 0)
+            draw_line(Line{{x, bottom}, {x, bottom - frame_px}}, PROFILER_FRAME_COL);
+        if (tick_px > 0)
+            draw_line(Line{{x, bottom}, {x, bottom - tick_px}}, PROFILER_TICK_COL);
+    }
+    // one tick's worth of time
+    int tick_line_y = position.y + graph_height - static_cast<int>(1000.0 * DT * px_per_ms);
+    draw_line(Line{{position.x, tick_line_y}, {position.x + PROFILER_GRAPH_SAMPLES, tick_line_y}}, PROFILER_TICKRATE_COL);
+}
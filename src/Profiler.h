@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include <SDL.h>
+
+#include "Vec2.h"
+
+static const size_t PROFILER_RING_SIZE = 1 << 16;  // zones kept per thread
+static const int PROFILER_GRAPH_SAMPLES = 240;     // frames shown in the HUD graph
+static const float PROFILER_GRAPH_MAX_MS = 50.0f;  // top of the HUD graph
+
+// seconds on a monotonic high resolution clock (use this instead of SDL_GetTicks for timing)
+double get_precise_time();
+
+//
+// times everything from its construction to the end of the enclosing scope and records it into a ring buffer
+// owned by the current thread. name has to be a string literal (or otherwise outlive the profiler).
+//
+class ProfileZone {
+private:
+    const char* name;
+    int64_t start_ns;
+
+public:
+    explicit ProfileZone(const char* name);
+    ~ProfileZone();
+    double get_elapsed() const; // seconds so far
+};
+
+#define PROFILE_ZONE_CONCAT_INNER(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_ZONE_CONCAT(profile_zone_, __LINE__)(name)
+
+// write every zone still held in the ring buffers as a chrome://tracing / perfetto json file
+bool profiler_dump_chrome_trace(const std::string& filename);
+
+// HUD graph of the last PROFILER_GRAPH_SAMPLES frames: total frame time and the part of it spent ticking
+void profiler_add_frame_sample(float frame_ms, float tick_ms);
+void draw_profiler_graph(const vec2<int>& position);
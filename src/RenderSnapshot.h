@@ -0,0 +1,53 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "ChunkedGrid.h"
+#include "geometry.h"
+#include "Vec2.h"
+
+struct UnitSnapshot {
+    vec2<float> prev_position; // at the start of the tick, for interpolation
+    vec2<float> position;
+    float angle;
+    float radius;
+    bool is_selected;
+};
+
+struct AnimationSnapshot {
+    int animation;
+    vec2<int> position;
+    unsigned int frame;
+    bool is_centered;
+};
+
+struct TileChange {
+    int tile_index; // x + y * map width
+    int tile;
+};
+
+//
+// everything the render thread needs to draw one simulation tick. written by the sim thread after every tick
+// and handed over through a TripleBuffer, so nothing in here may point at state the sim thread keeps mutating.
+// things that rarely change (tile edits, the pathfinding debug graph) are shared_ptrs to immutable data that
+// is only rebuilt when it actually changes.
+//
+struct RenderSnapshot {
+    int tick = 0;
+    int state_serial = -1;      // which GameState produced this (Game bumps it on every state change)
+    double tick_time = 0.0;     // get_precise_time() when the tick finished
+    double tick_ms = 0.0;       // how long the tick took
+    // cursor click flash, raised by orders
+    int num_cursor_clicks = 0;
+    bool last_click_is_queue = false;
+    // animations (explosions etc)
+    std::vector<AnimationSnapshot> animations;
+    // G_Bounding
+    std::vector<UnitSnapshot> units;
+    std::vector<unsigned int> tile_frames;                      // current frame of every tile type
+    std::vector<int> active_obstacles;
+    ChunkStats map_chunks;                                       // sim side tile/wall grids
+    std::shared_ptr<const std::vector<TileChange>> tile_changes; // every tile changed since the map was loaded
+    std::shared_ptr<const std::vector<Line>> pf_debug_edges;
+    std::shared_ptr<const std::vector<vec2<int>>> pf_debug_nodes;
+};
@@ -0,0 +1,150 @@
+#include "TextureAtlas.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "misc_gfx.h"
+
+TextureAtlas::TextureAtlas() {}
+
+TextureAtlas::~TextureAtlas() {
+    for (SDL_Texture* page : pages)
+        SDL_DestroyTexture(page);
+    for (PendingSprite& sprite : pending)
+        SDL_FreeSurface(sprite.surface);
+}
+
+// copies surface as RGBA32 (colorkeyed pixels become transparent, the atlas pages are alpha blended)
+int TextureAtlas::add_surface(SDL_Surface* surface) {
+    if (surface == nullptr)
+        throw std::invalid_argument("TextureAtlas::add_surface got a null surface");
+    SDL_Surface* converted = colorkey_to_alpha(surface);
+    if (converted == nullptr)
+        throw std::invalid_argument(std::string("could not convert surface for the atlas: ") + SDL_GetError());
+    return add_rgba_surface(converted);
+}
+
+// for surfaces that are already RGBA32 with alpha (e.g. from AssetLoader). the atlas takes ownership
+int TextureAtlas::add_rgba_surface(SDL_Surface* surface) {
+    if (surface == nullptr || surface->format->format != SDL_PIXELFORMAT_RGBA32)
+        throw std::invalid_argument("TextureAtlas::add_rgba_surface needs an RGBA32 surface");
+    int id = sprites.size();
+    sprites.push_back({-1, {0, 0, surface->w, surface->h}});
+    pending.push_back({id, surface});
+    return id;
+}
+
+void TextureAtlas::add_page(int width, int height) {
+    SDL_Texture* page = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, width, height);
+    if (page == nullptr)
+        throw std::invalid_argument(std::string("could not create atlas page: ") + SDL_GetError());
+    // clear it, so padding is transparent rather than whatever the driver had lying around
+    std::vector<Uint32> blank(static_cast<size_t>(width) * height, 0);
+    SDL_UpdateTexture(page, nullptr, blank.data(), width * sizeof(Uint32));
+    SDL_SetTextureBlendMode(page, SDL_BLENDMODE_BLEND);
+    pages.push_back(page);
+    page_sizes.push_back({width, height});
+    batch_vertices.resize(pages.size());
+}
+
+// shelf packing, tallest first. new sprites go into the space left on the last shared page before a new one is
+// started, existing sprites never move
+void TextureAtlas::build() {
+    if (pending.empty())
+        return;
+    std::stable_sort(pending.begin(), pending.end(), [](const PendingSprite& a, const PendingSprite& b) {
+        return a.surface->h > b.surface->h;
+    });
+    for (PendingSprite& sprite : pending) {
+        int w = sprite.surface->w + ATLAS_PADDING;
+        int h = sprite.surface->h + ATLAS_PADDING;
+        int page = -1;
+        vec2<int> position = {0, 0};
+        if (w > ATLAS_PAGE_SIZE || h > ATLAS_PAGE_SIZE) {
+            add_page(sprite.surface->w, sprite.surface->h);
+            page = pages.size() - 1;
+            // the page after this one has to start fresh
+            shelf_x = ATLAS_PAGE_SIZE;
+            shelf_y = ATLAS_PAGE_SIZE;
+        }
+        else {
+            if (shelf_x + w > ATLAS_PAGE_SIZE) {
+                shelf_x = 0;
+                shelf_y += shelf_height;
+                shelf_height = 0;
+            }
+            if (pages.empty() || shelf_y + h > ATLAS_PAGE_SIZE) {
+                add_page(ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE);
+                shelf_x = 0;
+                shelf_y = 0;
+                shelf_height = 0;
+            }
+            page = pages.size() - 1;
+            position = {shelf_x, shelf_y};
+            shelf_x += w;
+            shelf_height = std::max(shelf_height, h);
+        }
+        SDL_Rect rect = {position.x, position.y, sprite.surface->w, sprite.surface->h};
+        SDL_UpdateTexture(pages[page], &rect, sprite.surface->pixels, sprite.surface->pitch);
+        sprites[sprite.id] = {page, rect};
+        SDL_FreeSurface(sprite.surface);
+    }
+    pending.clear();
+}
+
+vec2<int> TextureAtlas::get_sprite_size(int id) const {
+    return {sprites[id].rect.w, sprites[id].rect.h};
+}
+
+int TextureAtlas::get_num_pages() const {
+    return pages.size();
+}
+
+void TextureAtlas::draw(int id, const SDL_Rect& dst_rect) {
+    if (!pending.empty())
+        build();
+    const AtlasSprite& sprite = sprites[id];
+    SDL_RenderCopy(renderer, pages[sprite.page], &sprite.rect, &dst_rect);
+}
+
+// nothing is drawn until flush(), so flush before drawing anything that should end up on top of these. quads on
+// different pages don't keep their order relative to each other
+void TextureAtlas::queue(int id, const SDL_Rect& dst_rect) {
+    if (!pending.empty())
+        build();
+    const AtlasSprite& sprite = sprites[id];
+    float page_w = page_sizes[sprite.page].x;
+    float page_h = page_sizes[sprite.page].y;
+    float u0 = sprite.rect.x / page_w;
+    float v0 = sprite.rect.y / page_h;
+    float u1 = (sprite.rect.x + sprite.rect.w) / page_w;
+    float v1 = (sprite.rect.y + sprite.rect.h) / page_h;
+    float x0 = dst_rect.x;
+    float y0 = dst_rect.y;
+    float x1 = dst_rect.x + dst_rect.w;
+    float y1 = dst_rect.y + dst_rect.h;
+    const SDL_Color white = {255, 255, 255, 255};
+    std::vector<SDL_Vertex>& vertices = batch_vertices[sprite.page];
+    vertices.push_back({{x0, y0}, white, {u0, v0}});
+    vertices.push_back({{x1, y0}, white, {u1, v0}});
+    vertices.push_back({{x1, y1}, white, {u1, v1}});
+    vertices.push_back({{x0, y1}, white, {u0, v1}});
+}
+
+void TextureAtlas::flush() {
+    for (size_t page = 0; page < batch_vertices.size(); ++page) {
+        std::vector<SDL_Vertex>& vertices = batch_vertices[page];
+        if (vertices.empty())
+            continue;
+        // two triangles per quad, the index list is shared and only ever grows
+        int num_quads = vertices.size() / 4;
+        for (int quad = batch_indices.size() / 6; quad < num_quads; ++quad) {
+            int base = 4 * quad;
+            int quad_indices[6] = {base, base + 1, base + 2, base, base + 2, base + 3};
+            batch_indices.insert(batch_indices.end(), quad_indices, quad_indices + 6);
+        }
+        SDL_RenderGeometry(renderer, pages[page], vertices.data(), vertices.size(), batch_indices.data(), 6 * num_quads);
+        vertices.clear();
+    }
+}
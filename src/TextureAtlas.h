@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+
+#include <SDL.h>
+
+#include "Vec2.h"
+
+extern SDL_Renderer* renderer;
+
+static const int ATLAS_PAGE_SIZE = 1024;  // sprites bigger than this get a page of their own
+static const int ATLAS_PADDING = 1;       // transparent gap between sprites
+
+struct AtlasSprite {
+    int page;
+    SDL_Rect rect;
+};
+
+//
+// packs lots of small images into a few big textures, so drawing them doesn't switch textures all the time and
+// quads from the same page can go out in one SDL_RenderGeometry call. add_surface only copies the pixels, the
+// packing and uploading happens in build(), which draw/queue call if anything is still pending. sprites keep
+// their id and rect for the lifetime of the atlas.
+//
+class TextureAtlas {
+private:
+    struct PendingSprite {
+        int id;
+        SDL_Surface* surface; // RGBA32, colorkey already turned into alpha
+    };
+
+    std::vector<SDL_Texture*> pages;
+    std::vector<vec2<int>> page_sizes;
+    std::vector<AtlasSprite> sprites;
+    std::vector<PendingSprite> pending;
+    // shelf packer state for the last page
+    int shelf_x = 0;
+    int shelf_y = 0;
+    int shelf_height = 0;
+    // queued quads, per page
+    std::vector<std::vector<SDL_Vertex>> batch_vertices;
+    std::vector<int> batch_indices;
+
+    void add_page(int width, int height);
+
+public:
+    TextureAtlas();
+    ~TextureAtlas();
+    int add_surface(SDL_Surface* surface);      // the caller still owns (and frees) surface
+    int add_rgba_surface(SDL_Surface* surface); // takes ownership
+    void build();
+    vec2<int> get_sprite_size(int id) const;
+    int get_num_pages() const;
+    void draw(int id, const SDL_Rect& dst_rect);
+    void queue(int id, const SDL_Rect& dst_rect);
+    void flush();
+};
+
+// atlas for everything loaded at startup (fonts, cursor, animations). defined in main.cpp
+extern TextureAtlas* texture_atlas;
@@ -5,13 +5,13 @@
 
 #include <nlohmann/json.hpp>
 
+#include "AssetLoader.h"
 #include "geometry.h"
 #include "globals.h"
-#include "misc_gfx.h"
 
 using json = nlohmann::json;
 
-TileManager::TileManager(const std::string& tiledata_json) : all_tile_data() {
+TileManager::TileManager(const std::string& tiledata_json) : all_tile_data(), animation_manager(&atlas) {
     // load map from json
     std::ifstream input_file(tiledata_json);
     json loaded_data = json::parse(input_file);
@@ -20,9 +20,21 @@ TileManager::TileManager(const std::string& tiledata_json) : all_tile_data() {
     for (const auto& item : loaded_data["tile_data"]) {
         if (item.size() != 5)
             throw std::invalid_argument("Invalid tile json");
+    }
+    // queue every image first so they all decode in parallel, then collect them in order
+    AssetLoader loader;
+    std::vector<int> tile_images;
+    for (const auto& item : loaded_data["tile_data"]) {
+        std::string tile_image_filename = tile_image_dir + item[2].get<std::string>();
+        if (item[3].size() == 0)
+            tile_images.push_back(loader.load_image(tile_image_filename));
+        else
+            tile_images.push_back(loader.load_spritesheet(tile_image_filename, {GRIDSIZE,GRIDSIZE}));
+    }
+    for (size_t i = 0; i < tile_images.size(); ++i) {
+        const auto& item = loaded_data["tile_data"][i];
         int tile_index = item[0].get<int>();
         int tile_is_blocking = item[1].get<int>();
-        std::string tile_image_filename = tile_image_dir + item[2].get<std::string>();
         bool tile_is_wall = false;
         if (tile_is_blocking > 0)
             tile_is_wall = true;
@@ -35,29 +47,29 @@ TileManager::TileManager(const std::string& tiledata_json) : all_tile_data() {
             float scroll_y = scroll_mag * std::sin(ANGLE_SCALAR * scroll_params[1]);
             scroll_xy = {scroll_x, scroll_y};
         }
+        std::vector<SDL_Surface*> frames = loader.take(tile_images[i]);
         //
         // static tiles
         //
         if (animated_tile_iscript.size() == 0) {
-            SDL_Surface* temp_surface = load_image(tile_image_filename);
-            all_tile_data.push_back({SDL_CreateTextureFromSurface(renderer, temp_surface), tile_is_wall, false, scroll_xy});
-            SDL_FreeSurface(temp_surface);
+            all_tile_data.push_back({atlas.add_rgba_surface(frames[0]), tile_is_wall, false, -1, scroll_xy});
         }
         //
         // animated tiles
         //
         else {
-            std::string animated_tile_name = std::to_string(tile_index);
-            animation_manager.add_animation(animated_tile_name, tile_image_filename, {GRIDSIZE,GRIDSIZE}, animated_tile_iscript);
-            animation_manager.start_new_animation(animated_tile_name, animated_tile_name, {0,0}, true);
-            all_tile_data.push_back({nullptr, tile_is_wall, true, scroll_xy});
+            std::string animated_tile_name = "tile_" + std::to_string(tile_index);
+            int animation = animation_manager.add_animation(animated_tile_name, frames, animated_tile_iscript);
+            animation_manager.start_new_animation(animation, tile_index, {0,0}, true);
+            all_tile_data.push_back({-1, tile_is_wall, true, animation, scroll_xy});
         }
     }
+    printf("tileset %s:\n", tiledata_json.c_str());
+    loader.print_report();
 };
 
 TileManager::~TileManager() {
-    for(size_t i = 0; i < all_tile_data.size(); ++i)
-        SDL_DestroyTexture(all_tile_data[i].texture);
+    // textures belong to the atlas
 }
 
 int TileManager::get_number_of_loaded_tiles() {
@@ -76,17 +88,28 @@ vec2<float> TileManager::get_tile_scroll(size_t i) {
     return all_tile_data[i].scroll_parameters;
 }
 
-SDL_Texture* TileManager::get_tile_texture(size_t i) {
+// frame comes from a RenderSnapshot (see fill_snapshot), static tiles ignore it. nothing shows up until flush_tiles
+void TileManager::queue_tile(size_t i, unsigned int frame, const SDL_Rect& dst_rect) {
     if (i >= all_tile_data.size())
         throw std::invalid_argument("Requesting invalid tile");
-    // static tiles
-    if (!all_tile_data[i].is_animated)
-        return all_tile_data[i].texture;
-    // animated tiles
-    std::string animated_tile_name = std::to_string(i);
-    return animation_manager.get_animating_texture(animated_tile_name);
+    int sprite = all_tile_data[i].sprite;
+    if (all_tile_data[i].is_animated)
+        sprite = animation_manager.get_frame_sprite(all_tile_data[i].animation, frame);
+    if (sprite >= 0)
+        atlas.queue(sprite, dst_rect);
+}
+
+void TileManager::flush_tiles() {
+    atlas.flush();
 }
 
 void TileManager::tick() {
     animation_manager.tick();
 }
+
+// animated tiles play under their tile index
+void TileManager::fill_snapshot(std::vector<unsigned int>& out_tile_frames) const {
+    out_tile_frames.resize(all_tile_data.size());
+    for (size_t i = 0; i < all_tile_data.size(); ++i)
+        out_tile_frames[i] = all_tile_data[i].is_animated ? animation_manager.get_current_frame(i) : 0;
+}
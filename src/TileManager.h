@@ -5,18 +5,21 @@
 #include <SDL.h>
 
 #include "AnimationManager.h"
+#include "TextureAtlas.h"
 
 extern SDL_Renderer* renderer;
 
 struct TileMetadata {
-    SDL_Texture* texture;
+    int sprite;                    // static tiles only
     bool is_wall;
     bool is_animated;
+    int animation;                 // interned name, animated tiles only
     vec2<float> scroll_parameters; // (magnitude, angle)
 };
 
 class TileManager {
 private:
+     TextureAtlas atlas;           // tiles are drawn a whole screen at a time, so they get an atlas of their own
      std::vector<TileMetadata> all_tile_data;
      AnimationManager animation_manager;
 
@@ -26,6 +29,8 @@ public:
     int get_number_of_loaded_tiles();
     bool get_tile_iswall(size_t i);
     vec2<float> get_tile_scroll(size_t i);
-    SDL_Texture* get_tile_texture(size_t i);
+    void queue_tile(size_t i, unsigned int frame, const SDL_Rect& dst_rect);
+    void flush_tiles();
     void tick();
+    void fill_snapshot(std::vector<unsigned int>& out_tile_frames) const;
 };
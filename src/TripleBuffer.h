@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+
+//
+// single producer / single consumer triple buffer. the producer always has a slot to write into and the
+// consumer always has a complete slot to read from, neither ever waits on the other. slots are reused, so
+// whatever the producer writes should overwrite the whole thing (vectors keep their capacity between uses).
+//
+// the middle slot index lives in the low bits of `middle`, STALE_BIT is cleared when the producer publishes
+// and set again once the consumer has picked the slot up.
+//
+template <typename T>
+class TripleBuffer {
+private:
+    static const int INDEX_MASK = 3;
+    static const int STALE_BIT = 4;
+
+    T slots[3];
+    int write_index = 0;
+    int read_index = 1;
+    std::atomic<int> middle;
+
+public:
+    TripleBuffer() : middle(2 | STALE_BIT) {}
+
+    // producer side
+    T& get_write_buffer() {
+        return slots[write_index];
+    }
+
+    void publish() {
+        int old_middle = middle.exchange(write_index, std::memory_order_acq_rel);
+        write_index = old_middle & INDEX_MASK;
+    }
+
+    // consumer side: returns true if a newer slot was published since the last call
+    bool update_read_buffer() {
+        if (middle.load(std::memory_order_relaxed) & STALE_BIT)
+            return false;
+        int old_middle = middle.exchange(read_index | STALE_BIT, std::memory_order_acq_rel);
+        read_index = old_middle & INDEX_MASK;
+        return true;
+    }
+
+    const T& get_read_buffer() const {
+        return slots[read_index];
+    }
+};
@@ -0,0 +1,99 @@
+#include "UnitGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+UnitGrid::UnitGrid(int cell_size) :
+    cell_size(cell_size),
+    bucket_mask(UNIT_GRID_MIN_BUCKETS - 1),
+    bucket_start(UNIT_GRID_MIN_BUCKETS + 1, 0),
+    bucket_stamp(UNIT_GRID_MIN_BUCKETS, 0),
+    query_stamp(0) {}
+
+uint32_t UnitGrid::get_bucket(int cx, int cy) const {
+    return ((static_cast<uint32_t>(cx) * 73856093u) ^ (static_cast<uint32_t>(cy) * 19349663u)) & bucket_mask;
+}
+
+void UnitGrid::rebuild(const UnitPool& units) {
+    int num_units = units.size();
+
+    // keep roughly two buckets per unit so chains stay short
+    uint32_t num_buckets = UNIT_GRID_MIN_BUCKETS;
+    while (num_buckets < 2 * static_cast<uint32_t>(num_units))
+        num_buckets *= 2;
+    if (num_buckets != bucket_mask + 1) {
+        bucket_mask = num_buckets - 1;
+        bucket_stamp.assign(num_buckets, 0);
+        query_stamp = 0;
+    }
+
+    // counting sort by bucket
+    bucket_start.assign(num_buckets + 1, 0);
+    unit_bucket.resize(num_units);
+    for (int i = 0; i < num_units; ++i) {
+        vec2<float> pos = units.get_position(i);
+        uint32_t b = get_bucket(static_cast<int>(pos.x) / cell_size, static_cast<int>(pos.y) / cell_size);
+        unit_bucket[i] = b;
+        bucket_start[b + 1] += 1;
+    }
+    for (uint32_t b = 0; b < num_buckets; ++b)
+        bucket_start[b + 1] += bucket_start[b];
+
+    sorted_ids.resize(num_units);
+    sorted_x.resize(num_units);
+    sorted_y.resize(num_units);
+    std::vector<int> fill_pos(bucket_start.begin(), bucket_start.end() - 1);
+    for (int i = 0; i < num_units; ++i) {
+        int slot = fill_pos[unit_bucket[i]]++;
+        vec2<float> pos = units.get_position(i);
+        sorted_ids[slot] = i;
+        sorted_x[slot] = pos.x;
+        sorted_y[slot] = pos.y;
+    }
+}
+
+// all units with p1 <= position <= p2 (corners can be given in any order)
+void UnitGrid::query_rect(const vec2<float>& p1, const vec2<float>& p2, std::vector<int>& out_ids) const {
+    out_ids.clear();
+    float x_min = std::min(p1.x, p2.x);
+    float x_max = std::max(p1.x, p2.x);
+    float y_min = std::min(p1.y, p2.y);
+    float y_max = std::max(p1.y, p2.y);
+    int cx_min = static_cast<int>(std::floor(std::max(x_min, 0.0f) / cell_size));
+    int cx_max = static_cast<int>(std::floor(std::max(x_max, 0.0f) / cell_size));
+    int cy_min = static_cast<int>(std::floor(std::max(y_min, 0.0f) / cell_size));
+    int cy_max = static_cast<int>(std::floor(std::max(y_max, 0.0f) / cell_size));
+
+    // huge rects: cheaper to just look at everyone
+    int64_t num_cells = static_cast<int64_t>(cx_max - cx_min + 1) * static_cast<int64_t>(cy_max - cy_min + 1);
+    if (num_cells > static_cast<int64_t>(bucket_mask) + 1) {
+        for (size_t i = 0; i < sorted_ids.size(); ++i) {
+            if (sorted_x[i] >= x_min && sorted_x[i] <= x_max && sorted_y[i] >= y_min && sorted_y[i] <= y_max)
+                out_ids.push_back(sorted_ids[i]);
+        }
+        return;
+    }
+
+    query_stamp += 1;
+    if (query_stamp == 0) {
+        std::fill(bucket_stamp.begin(), bucket_stamp.end(), 0);
+        query_stamp = 1;
+    }
+    for (int cx = cx_min; cx <= cx_max; ++cx) {
+        for (int cy = cy_min; cy <= cy_max; ++cy) {
+            uint32_t b = get_bucket(cx, cy);
+            if (bucket_stamp[b] == query_stamp)
+                continue;
+            bucket_stamp[b] = query_stamp;
+            for (int i = bucket_start[b]; i < bucket_start[b + 1]; ++i) {
+                if (sorted_x[i] >= x_min && sorted_x[i] <= x_max && sorted_y[i] >= y_min && sorted_y[i] <= y_max)
+                    out_ids.push_back(sorted_ids[i]);
+            }
+        }
+    }
+}
+
+// all units within half_size of point (i.e. point is inside the unit's box of size 2 * half_size)
+void UnitGrid::query_point(const vec2<float>& point, const vec2<float>& half_size, std::vector<int>& out_ids) const {
+    query_rect(point - half_size, point + half_size, out_ids);
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "UnitPool.h"
+#include "Vec2.h"
+
+static const int UNIT_GRID_CELL_SIZE = 64;     // pixels
+static const int UNIT_GRID_MIN_BUCKETS = 1024; // power of two
+
+//
+// spatial hash over unit positions. cells of UNIT_GRID_CELL_SIZE pixels are hashed into a power-of-two
+// number of buckets, and rebuild() counting-sorts every unit into its bucket so queries only have to look
+// at the units in the buckets that overlap the query rect
+//
+class UnitGrid {
+private:
+    int cell_size;
+    uint32_t bucket_mask;
+    std::vector<int> bucket_start;      // units in bucket b are sorted_*[bucket_start[b] ... bucket_start[b+1])
+    std::vector<int> sorted_ids;
+    std::vector<float> sorted_x;
+    std::vector<float> sorted_y;
+    std::vector<uint32_t> unit_bucket;  // scratch for rebuild()
+    // a query can hit the same bucket through two different cells, stamp buckets so we only scan them once
+    mutable std::vector<uint32_t> bucket_stamp;
+    mutable uint32_t query_stamp;
+
+    uint32_t get_bucket(int cx, int cy) const;
+
+public:
+    UnitGrid(int cell_size = UNIT_GRID_CELL_SIZE);
+    void rebuild(const UnitPool& units);
+    void query_rect(const vec2<float>& p1, const vec2<float>& p2, std::vector<int>& out_ids) const;
+    void query_point(const vec2<float>& point, const vec2<float>& half_size, std::vector<int>& out_ids) const;
+};
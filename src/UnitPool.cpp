@@ -0,0 +1,584 @@
+#include "UnitPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Profiler.h"
+
+UnitPool::UnitPool(bool fixed_point) : is_fixed_point(fixed_point) {
+    for (float speed : MOVE_CYCLE)
+        move_cycle_fixed.push_back(float_to_fixed(speed));
+}
+
+int UnitPool::add_unit(const vec2<float>& pos, float unit_radius) {
+    int i = size();
+    pos_x.push_back(pos.x);
+    pos_y.push_back(pos.y);
+    direction.push_back(0);
+    angle.push_back(0.0f);
+    radius.push_back(unit_radius);
+    state.push_back(static_cast<int>(PlayerState::IDLE));
+    iscript_ind.push_back(0);
+    selected.push_back(0);
+    order_ring.resize(order_ring.size() + ORDER_RING_CAPACITY);
+    order_head.push_back(0);
+    order_count.push_back(0);
+    incoming_ring.resize(incoming_ring.size() + MAX_ORDERS_IN_QUEUE);
+    incoming_head.push_back(0);
+    incoming_count.push_back(0);
+    fx_pos_x.push_back(0);
+    fx_pos_y.push_back(0);
+    fx_radius.push_back(float_to_fixed(unit_radius));
+    turns.push_back({0, 0, 0, 0, 0});
+    move_pending.push_back(0);
+    move_goal_x.push_back(pos.x);
+    move_goal_y.push_back(pos.y);
+    move_speed.push_back(0.0f);
+    move_step_x.push_back(pos.x);
+    move_step_y.push_back(pos.y);
+    move_arrives.push_back(0);
+    fx_move_goal_x.push_back(0);
+    fx_move_goal_y.push_back(0);
+    fx_move_speed.push_back(0);
+    scroll_active.push_back(0);
+    scrolled.push_back(0);
+    set_position(i, pos);
+    return i;
+}
+
+int UnitPool::size() const {
+    return pos_x.size();
+}
+
+vec2<float> UnitPool::get_position(int i) const {
+    return {pos_x[i], pos_y[i]};
+}
+
+float UnitPool::get_angle(int i) const {
+    return angle[i];
+}
+
+float UnitPool::get_radius(int i) const {
+    return radius[i];
+}
+
+int UnitPool::get_state(int i) const {
+    return state[i];
+}
+
+bool UnitPool::get_selected(int i) const {
+    return selected[i] > 0;
+}
+
+// in fixed point mode this rounds to the nearest 1/256 px
+void UnitPool::set_position(int i, const vec2<float>& pos) {
+    if (is_fixed_point)
+        set_fixed_position(i, {float_to_fixed(pos.x), float_to_fixed(pos.y)});
+    else {
+        pos_x[i] = pos.x;
+        pos_y[i] = pos.y;
+    }
+}
+
+void UnitPool::set_fixed_position(int i, const vec2<fixed_t>& pos) {
+    fx_pos_x[i] = pos.x;
+    fx_pos_y[i] = pos.y;
+    pos_x[i] = fixed_to_float(pos.x);
+    pos_y[i] = fixed_to_float(pos.y);
+}
+
+// rounds to the nearest of the NUM_DIRECTIONS directions
+void UnitPool::set_angle(int i, float new_angle) {
+    set_direction(i, degrees_to_direction(angle_clamp(new_angle)));
+}
+
+void UnitPool::set_direction(int i, int new_direction) {
+    direction[i] = new_direction & (NUM_DIRECTIONS - 1);
+    angle[i] = direction_to_degrees(direction[i]);
+}
+
+void UnitPool::set_selected(int i, bool is_selected) {
+    selected[i] = is_selected ? 1 : 0;
+}
+
+// drop everything the unit was doing and put it back down at pos
+void UnitPool::revive_unit(int i, const vec2<float>& pos) {
+    set_position(i, pos);
+    state[i] = PlayerState::IDLE;
+    iscript_ind[i] = 0;
+    order_clear(i);
+    incoming_head[i] = 0;
+    incoming_count[i] = 0;
+    turns[i] = {direction[i], 0, 0, direction[i], 0};
+}
+
+void UnitPool::kill_unit(int i) {
+    revive_unit(i, get_position(i));
+    state[i] = PlayerState::DEAD;
+}
+
+//
+// order ring
+//
+
+bool UnitPool::order_empty(int i) const {
+    return order_count[i] == 0;
+}
+
+AcceptedOrder& UnitPool::order_front(int i) {
+    return order_ring[i * ORDER_RING_CAPACITY + order_head[i]];
+}
+
+void UnitPool::order_pop(int i) {
+    if (order_count[i] > 0) {
+        order_head[i] = (order_head[i] + 1) & (ORDER_RING_CAPACITY - 1);
+        order_count[i] -= 1;
+    }
+}
+
+// orders that don't fit are dropped
+void UnitPool::order_push_back(int i, const AcceptedOrder& order) {
+    if (order_count[i] >= ORDER_RING_CAPACITY)
+        return;
+    int slot = (order_head[i] + order_count[i]) & (ORDER_RING_CAPACITY - 1);
+    order_ring[i * ORDER_RING_CAPACITY + slot] = order;
+    order_count[i] += 1;
+}
+
+// swaps the front order (the one a path was requested for, so it heads for clicked_pos) for the path's waypoints.
+// when they don't all fit the front order stays behind as many as do, to pathfind to clicked_pos again from the
+// last of them. with no free slot at all the back of the ring is dropped for the first waypoint (like
+// order_push_back drops what doesn't fit), so the unit always gets somewhere and always goes on from there
+int splice_path_orders(AcceptedOrder* ring, int& head, int& count, const vec2<int>* waypoints, int num_waypoints) {
+    vec2<int> clicked_pos = ring[head].goal_coordinates;
+    int num_free = ORDER_RING_CAPACITY - count;
+    if (num_waypoints <= num_free + 1) {
+        head = (head + 1) & (ORDER_RING_CAPACITY - 1);
+        count -= 1;
+    }
+    else {
+        ring[head] = {clicked_pos, 0, true, NO_CLICKPOS};
+        if (num_free == 0) {
+            count -= 1;
+            num_free = 1;
+        }
+        num_waypoints = num_free;
+    }
+    head = (head - num_waypoints) & (ORDER_RING_CAPACITY - 1);
+    for (int j = 0; j < num_waypoints; ++j)
+        ring[(head + j) & (ORDER_RING_CAPACITY - 1)] = {waypoints[j], 0, false, clicked_pos};
+    count += num_waypoints;
+    return num_waypoints;
+}
+
+void UnitPool::order_splice_path(int i, const vec2<int>* waypoints, int num_waypoints) {
+    splice_path_orders(&order_ring[i * ORDER_RING_CAPACITY], order_head[i], order_count[i], waypoints, num_waypoints);
+}
+
+void UnitPool::order_clear(int i) {
+    order_head[i] = 0;
+    order_count[i] = 0;
+}
+
+PlayerOrder& UnitPool::incoming_at(int i, int j) {
+    return incoming_ring[i * MAX_ORDERS_IN_QUEUE + ((incoming_head[i] + j) & (MAX_ORDERS_IN_QUEUE - 1))];
+}
+
+void UnitPool::incoming_pop(int i) {
+    incoming_head[i] = (incoming_head[i] + 1) & (MAX_ORDERS_IN_QUEUE - 1);
+    incoming_count[i] -= 1;
+}
+
+//
+// batched kernels. these are plain loops over the pool arrays with no branches so the compiler can
+// vectorize them (restrict has to be on the parameters for gcc to take it into account)
+//
+
+// IDLE / DELAY_Q units restart their iscript, ARRIVED units go back to IDLE
+static void update_states(int num_units, int* __restrict p_state, int* __restrict p_iscript) {
+    for (int i = 0; i < num_units; ++i) {
+        int s = p_state[i];
+        int keep_iscript = (s != PlayerState::IDLE) & (s != PlayerState::DELAY_Q);
+        int is_arrived = s == PlayerState::ARRIVED;
+        p_iscript[i] *= keep_iscript;
+        p_state[i] = s + is_arrived * (PlayerState::IDLE - PlayerState::ARRIVED);
+    }
+}
+
+// one movement step of length speed towards the goal (or onto the goal if it's closer than that)
+static void step_towards_goals(int num_units,
+                               const float* __restrict p_px, const float* __restrict p_py,
+                               const float* __restrict p_gx, const float* __restrict p_gy,
+                               const float* __restrict p_speed,
+                               float* __restrict p_sx, float* __restrict p_sy,
+                               uint8_t* __restrict p_arrives) {
+    for (int i = 0; i < num_units; ++i) {
+        float dx = p_gx[i] - p_px[i];
+        float dy = p_gy[i] - p_py[i];
+        float dv_length = std::sqrt(dx * dx + dy * dy);
+        float t = p_speed[i] / dv_length;
+        p_arrives[i] = dv_length <= p_speed[i];
+        p_sx[i] = p_px[i] + dx * t;
+        p_sy[i] = p_py[i] + dy * t;
+    }
+}
+
+//
+// turning
+//
+
+// which way to turn and in how many ticks, from the unit's current direction. deltas are in 24.8, the click
+// only matters for 180 degree turns
+TurnSequence UnitPool::get_turn_sequence(int i, const vec2<int64_t>& goal_delta, const vec2<int64_t>& click_delta) const {
+    int g_dir = get_direction(goal_delta.x, goal_delta.y);
+    int d_dir = direction_diff(direction[i], g_dir);
+    bool is_clockwise = d_dir < 0;
+
+    // if player is trying to do a 180 turn against a wall, turn towards the wall (it looks bad otherwise)
+    if (d_dir == -NUM_DIRECTIONS / 2)
+        is_clockwise = direction_diff(direction[i], get_direction(click_delta.x, click_delta.y)) < 0;
+
+    bool is_turning = state[i] == PlayerState::MOVING || state[i] == PlayerState::TURNING;
+    int abs_d_dir = std::abs(d_dir);
+    int num_turn_frames = abs_d_dir <= TURN_SPEED ? !is_turning : abs_d_dir / TURN_SPEED;
+    TurnSequence sequence = {direction[i], is_clockwise ? -TURN_SPEED : TURN_SPEED, 1, g_dir, 0};
+    if (num_turn_frames > 1)
+        sequence.count = num_turn_frames;
+    else if (num_turn_frames == 1 && !is_turning) {
+        // one extra tick, facing the goal already if it's that close
+        sequence.count = 2;
+        if (abs_d_dir <= TURN_SPEED) {
+            sequence.start = g_dir;
+            sequence.step = 0;
+        }
+    }
+    return sequence;
+}
+
+// queue up the turns from where the unit is now to face goal_position
+void UnitPool::set_turns(int i, const vec2<int>& goal_position, const vec2<int> clickpos) {
+    vec2<int64_t> goal_delta;
+    vec2<int64_t> click_delta;
+    if (is_fixed_point) {
+        goal_delta = {static_cast<int64_t>(goal_position.x) * FIXED_ONE - fx_pos_x[i], static_cast<int64_t>(goal_position.y) * FIXED_ONE - fx_pos_y[i]};
+        click_delta = {static_cast<int64_t>(clickpos.x) * FIXED_ONE - fx_pos_x[i], static_cast<int64_t>(clickpos.y) * FIXED_ONE - fx_pos_y[i]};
+    }
+    else {
+        goal_delta = {float_to_fixed(goal_position.x - pos_x[i]), float_to_fixed(goal_position.y - pos_y[i])};
+        click_delta = {float_to_fixed(clickpos.x - pos_x[i]), float_to_fixed(clickpos.y - pos_y[i])};
+    }
+    turns[i] = get_turn_sequence(i, goal_delta, click_delta);
+}
+
+bool UnitPool::has_turns(int i) const {
+    return turns[i].done < turns[i].count;
+}
+
+// face the next queued turn, returns true if that was the last one
+bool UnitPool::apply_next_turn(int i) {
+    TurnSequence& sequence = turns[i];
+    sequence.done += 1;
+    bool is_last = sequence.done >= sequence.count;
+    set_direction(i, is_last ? sequence.goal : sequence.start + sequence.done * sequence.step);
+    return is_last;
+}
+
+//
+// orders
+//
+
+// returns true if a cursor flash should be drawn
+bool UnitPool::issue_new_order(int i, const vec2<int>& order_coordinates, bool shift_pressed) {
+    // reject order if player is not selected
+    if (!selected[i] || state[i] == PlayerState::DEAD)
+        return false;
+    // reject order if clicked inside player
+    vec2<float> forder_coords = order_coordinates;
+    FRect deadzone;
+    deadzone.position = get_position(i) - DEADZONE_VEC2;
+    deadzone.size = 2 * DEADZONE_VEC2;
+    if (point_in_box(forder_coords, deadzone))
+        return false;
+    // new order or queue order? (plain clicks don't get dropped in practice, they can only pile up for MOVE_DELAY ticks)
+    int num_incoming = incoming_count[i];
+    bool move_is_queue = shift_pressed;
+    if (num_incoming >= MAX_ORDERS_IN_QUEUE)
+        return true;
+    // don't accept redundant orders
+    if (num_incoming > 0 && order_coordinates == incoming_at(i, num_incoming - 1).coordinates)
+        return true;
+    // don't accept new orders that are close to being redundant
+    if (num_incoming > 0 && !move_is_queue) {
+        int dx = std::abs(incoming_at(i, num_incoming - 1).coordinates.x - order_coordinates.x);
+        int dy = std::abs(incoming_at(i, num_incoming - 1).coordinates.y - order_coordinates.y);
+        if (dx <= CLICK_DEADZONE && dy <= CLICK_DEADZONE)
+            return true;
+    }
+    // append order to queue
+    incoming_at(i, num_incoming) = {order_coordinates, MOVE_DELAY, move_is_queue};
+    incoming_count[i] += 1;
+    if (state[i] == PlayerState::IDLE)
+        state[i] = PlayerState::DELAY;
+    return true;
+}
+
+// per-unit part of the tick: accept incoming orders, then either request a path (picked up by apply_path once
+// the tick's requests are resolved) or carry on with tick_turns
+void UnitPool::tick_orders(int i, WorldMap* world_map) {
+    //
+    // decrement delay on incoming orders. if any are ready add them to queue
+    //
+    for (int j = 0; j < incoming_count[i]; ++j)
+        incoming_at(i, j).current_delay -= 1;
+    while (incoming_count[i] > 0 && incoming_at(i, 0).current_delay <= 0) {
+        const PlayerOrder& incoming = incoming_at(i, 0);
+        AcceptedOrder accepted_order = {incoming.coordinates, 0, true, NO_CLICKPOS};
+        // for shift-clicks delay will be QUEUE_DELAY, for subpaths of a larger path it will be 0
+        if (incoming.is_queue && !order_empty(i))
+            accepted_order.accept_delay = QUEUE_DELAY;
+        else
+            order_clear(i);
+        order_push_back(i, accepted_order);
+        incoming_pop(i);
+    }
+
+    //
+    // act out our current order if we have one
+    //
+    if (order_empty(i))
+        return;
+    order_front(i).accept_delay -= 1;
+    if (order_front(i).accept_delay > -1) {
+        state[i] = PlayerState::DELAY_Q;
+        return;
+    }
+    // order accepted, pathfind subpaths if this is a new command
+    if (order_front(i).request_new_paths) {
+        path_units.push_back(i);
+        path_requests.push_back(world_map->request_path(get_position(i), order_front(i).goal_coordinates, radius[i]));
+        return;
+    }
+    tick_turns(i);
+}
+
+// the path requested in tick_orders came back
+void UnitPool::apply_path(int i, const vec2<int>* waypoints, int num_waypoints) {
+    // abandon this order if no path was returned
+    if (num_waypoints == 0) {
+        order_pop(i);
+        state[i] = PlayerState::ARRIVED;
+        return;
+    }
+    vec2<float> player_position = get_position(i);
+    bool is_at_destination;
+    if (is_fixed_point) {
+        int64_t dx = static_cast<int64_t>(waypoints[0].x) * FIXED_ONE - fx_pos_x[i];
+        int64_t dy = static_cast<int64_t>(waypoints[0].y) * FIXED_ONE - fx_pos_y[i];
+        is_at_destination = dx * dx + dy * dy < 7; // within 0.01 px, same as below
+    }
+    else {
+        vec2<float> dv = vec2<float>(waypoints[0]) - player_position;
+        is_at_destination = dv.length() < 0.01f;
+    }
+    // if we're already at the destination then we just need to turn
+    if (is_at_destination) {
+        set_turns(i, order_front(i).goal_coordinates);
+        order_front(i) = {player_position, -2, false, NO_CLICKPOS}; // why was this -2 and not -1 ?
+    }
+    // otherwise assign all the subpaths as new move orders
+    else {
+        order_splice_path(i, waypoints, num_waypoints);
+        order_front(i).accept_delay = -1; // so we process the first subpath immediately
+    }
+    tick_turns(i);
+}
+
+// turning towards the current order's goal, and flagging the unit for the movement step once it faces it
+void UnitPool::tick_turns(int i) {
+    // lets compute necessary turns before we can begin moving
+    if (order_front(i).accept_delay == -1)
+        set_turns(i, order_front(i).goal_coordinates, order_front(i).clicked_coordinates);
+    // do the actual turning
+    if (has_turns(i)) {
+        state[i] = PlayerState::TURNING;
+        if (apply_next_turn(i))
+            state[i] = PlayerState::MOVING;
+        else
+            iscript_ind[i] = (iscript_ind[i] + 1) % MOVE_CYCLE.size();
+    }
+    // move if we're now ready
+    if (state[i] == PlayerState::MOVING) {
+        move_pending[i] = 1;
+        if (is_fixed_point) {
+            fx_move_goal_x[i] = order_front(i).goal_coordinates.x * FIXED_ONE;
+            fx_move_goal_y[i] = order_front(i).goal_coordinates.y * FIXED_ONE;
+            fx_move_speed[i] = move_cycle_fixed[iscript_ind[i]];
+        }
+        else {
+            move_goal_x[i] = static_cast<float>(order_front(i).goal_coordinates.x);
+            move_goal_y[i] = static_cast<float>(order_front(i).goal_coordinates.y);
+            move_speed[i] = MOVE_CYCLE[iscript_ind[i]];
+        }
+    }
+}
+
+void UnitPool::tick(WorldMap* world_map) {
+    PROFILE_ZONE("UnitPool::tick");
+    int num_units = size();
+
+    //
+    // state housekeeping
+    //
+    update_states(num_units, state.data(), iscript_ind.data());
+
+    //
+    // nudge our position if we're on a conveyor
+    //
+    for (int i = 0; i < num_units; ++i)
+        scroll_active[i] = state[i] != PlayerState::DEAD;
+    if (is_fixed_point) {
+        world_map->apply_scroll_fixed(num_units, fx_pos_x.data(), fx_pos_y.data(), fx_radius.data(), scroll_active.data(), scrolled.data());
+        for (int i = 0; i < num_units; ++i) {
+            if (scrolled[i])
+                set_fixed_position(i, {fx_pos_x[i], fx_pos_y[i]});
+        }
+    }
+    else
+        world_map->apply_scroll(num_units, pos_x.data(), pos_y.data(), radius.data(), scroll_active.data(), scrolled.data());
+    // if we're moving, also update our angle
+    for (int i = 0; i < num_units; ++i) {
+        if (scrolled[i] && state[i] == PlayerState::MOVING && !order_empty(i))
+            set_turns(i, order_front(i).goal_coordinates, order_front(i).clicked_coordinates);
+    }
+
+    //
+    // orders, pathfinding, turning
+    //
+    std::fill(move_pending.begin(), move_pending.end(), 0);
+    for (int i = 0; i < num_units; ++i) {
+        if (incoming_count[i] > 0 || !order_empty(i))
+            tick_orders(i, world_map);
+    }
+    // everybody's paths at once
+    if (!path_units.empty()) {
+        double start_time = get_precise_time();
+        world_map->resolve_paths();
+        double end_time = get_precise_time() - start_time;
+        printf("pathfinding (%zu paths) completed in %f seconds\n", path_units.size(), end_time);
+        for (size_t k = 0; k < path_units.size(); ++k) {
+            const vec2<int>* waypoints;
+            int num_waypoints = world_map->get_path(path_requests[k], waypoints);
+            apply_path(path_units[k], waypoints, num_waypoints);
+        }
+        path_units.clear();
+        path_requests.clear();
+    }
+
+    //
+    // movement
+    //
+    if (is_fixed_point)
+        tick_movement_fixed(world_map);
+    else
+        tick_movement(world_map);
+}
+
+// step every unit towards its goal at once, then resolve the moving ones against walls
+void UnitPool::tick_movement(WorldMap* world_map) {
+    int num_units = size();
+    step_towards_goals(num_units, pos_x.data(), pos_y.data(), move_goal_x.data(), move_goal_y.data(), move_speed.data(),
+                       move_step_x.data(), move_step_y.data(), move_arrives.data());
+    for (int i = 0; i < num_units; ++i) {
+        if (!move_pending[i])
+            continue;
+        vec2<float> player_position = get_position(i);
+        if (move_arrives[i]) {
+            set_position(i, world_map->get_move_pos(player_position, {move_goal_x[i], move_goal_y[i]}, radius[i]));
+            order_pop(i);
+            state[i] = PlayerState::ARRIVED;
+        }
+        else {
+            vec2<float> scaled_goal_position = {move_step_x[i], move_step_y[i]};
+            vec2<float> bounded_position = world_map->get_move_pos(player_position, scaled_goal_position, radius[i]);
+            set_position(i, bounded_position);
+            // if bounded_position is not where we wanted to go, that means we hit a wall and need to stop
+            vec2<float> dv2 = scaled_goal_position - bounded_position;
+            if (std::abs(dv2.x) > EPSILON || std::abs(dv2.y) > EPSILON)
+                state[i] = PlayerState::ARRIVED;
+        }
+        iscript_ind[i] = (iscript_ind[i] + 1) % MOVE_CYCLE.size();
+    }
+}
+
+// same as tick_movement, in 24.8 with integer math only
+void UnitPool::tick_movement_fixed(WorldMap* world_map) {
+    for (int i = 0; i < size(); ++i) {
+        if (!move_pending[i])
+            continue;
+        vec2<fixed_t> player_position = {fx_pos_x[i], fx_pos_y[i]};
+        vec2<fixed_t> goal_position = {fx_move_goal_x[i], fx_move_goal_y[i]};
+        int64_t dx = goal_position.x - player_position.x;
+        int64_t dy = goal_position.y - player_position.y;
+        int64_t dv_length = isqrt(static_cast<uint64_t>(dx * dx + dy * dy));
+        if (dv_length <= fx_move_speed[i]) {
+            set_fixed_position(i, world_map->get_move_pos_fixed(player_position, goal_position, fx_radius[i]));
+            order_pop(i);
+            state[i] = PlayerState::ARRIVED;
+        }
+        else {
+            vec2<fixed_t> scaled_goal_position = {static_cast<fixed_t>(player_position.x + dx * fx_move_speed[i] / dv_length),
+                                                  static_cast<fixed_t>(player_position.y + dy * fx_move_speed[i] / dv_length)};
+            vec2<fixed_t> bounded_position = world_map->get_move_pos_fixed(player_position, scaled_goal_position, fx_radius[i]);
+            set_fixed_position(i, bounded_position);
+            // hit a wall
+            if (bounded_position != scaled_goal_position)
+                state[i] = PlayerState::ARRIVED;
+        }
+        iscript_ind[i] = (iscript_ind[i] + 1) % MOVE_CYCLE.size();
+    }
+}
+
+bool UnitPool::get_fixed_point() const {
+    return is_fixed_point;
+}
+
+// fnv-1a over the raw bytes (every target we build for is little endian)
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t num_bytes) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t k = 0; k < num_bytes; ++k) {
+        hash ^= bytes[k];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+template <typename T>
+static uint64_t hash_vector(uint64_t hash, const std::vector<T>& values) {
+    return hash_bytes(hash, values.data(), values.size() * sizeof(T));
+}
+
+uint64_t UnitPool::get_state_hash() const {
+    uint64_t hash = 14695981039346656037ull;
+    if (is_fixed_point) {
+        hash = hash_vector(hash, fx_pos_x);
+        hash = hash_vector(hash, fx_pos_y);
+    }
+    else {
+        hash = hash_vector(hash, pos_x);
+        hash = hash_vector(hash, pos_y);
+    }
+    hash = hash_vector(hash, direction);
+    hash = hash_vector(hash, state);
+    hash = hash_vector(hash, iscript_ind);
+    hash = hash_vector(hash, selected);
+    for (int i = 0; i < size(); ++i) {
+        for (int j = 0; j < order_count[i]; ++j) {
+            const AcceptedOrder& order = order_ring[i * ORDER_RING_CAPACITY + ((order_head[i] + j) & (ORDER_RING_CAPACITY - 1))];
+            int fields[3] = {order.goal_coordinates.x, order.goal_coordinates.y, order.accept_delay};
+            hash = hash_bytes(hash, fields, sizeof(fields));
+        }
+        int counts[3] = {order_count[i], incoming_count[i], turns[i].count - turns[i].done};
+        hash = hash_bytes(hash, counts, sizeof(counts));
+    }
+    return hash;
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "fixed_point.h"
+#include "geometry.h"
+#include "globals.h"
+#include "Vec2.h"
+#include "WorldMap.h"
+
+static const std::array<float,7> MOVE_CYCLE = {2.0f, 8.0f, 9.0f, 5.0f, 6.0f, 7.0f, 2.0f};
+static const int TURN_SPEED = 28; // directions per tick (of NUM_DIRECTIONS, ~39.4 degrees)
+
+//
+// pathing / click delay stuff
+//
+static const int MOVE_DELAY             = 4;    // OpenBound "turnrate"
+static const int QUEUE_DELAY            = 1;
+static const int MAX_ORDERS_IN_QUEUE    = 32;   // incoming orders per unit, power of two (it's a ring as well)
+static const int MAX_PATH_WAYPOINTS     = 32;   // longer paths are walked in pieces, see splice_path_orders
+static const int CLICK_DEADZONE         = 4;
+
+static const vec2<float> DEADZONE_VEC2 = {4.0f, 4.0f};
+
+// accepted orders live in a fixed number of slots per unit (power of two so we can mask instead of mod), enough
+// for a full queue of shift-clicks plus the waypoints of the path being walked
+static const int ORDER_RING_CAPACITY = 64;
+static_assert(ORDER_RING_CAPACITY >= MAX_ORDERS_IN_QUEUE + MAX_PATH_WAYPOINTS, "order ring can't hold a queue and a path");
+static_assert((ORDER_RING_CAPACITY & (ORDER_RING_CAPACITY - 1)) == 0, "ORDER_RING_CAPACITY must be a power of two");
+static_assert((MAX_ORDERS_IN_QUEUE & (MAX_ORDERS_IN_QUEUE - 1)) == 0, "MAX_ORDERS_IN_QUEUE must be a power of two");
+
+struct PlayerState {
+    static const int IDLE    = 0;     // idle
+    static const int DELAY   = 1;     // received orders, but we're waiting before we accept them (to emulate click delay)
+    static const int TURNING = 2;     // turning
+    static const int MOVING  = 3;     // moving
+    static const int ARRIVED = 4;     // destination reached, next frame we will process our next order if we have one
+    static const int DELAY_Q = 5;     // we have an order in queue, but are waiting to accept it (to emulate shift-click delay)
+    static const int DEAD    = 6;     // out of lives, do not revive
+};
+
+struct PlayerOrder {
+    vec2<int> coordinates;
+    int current_delay;
+    bool is_queue;
+};
+
+struct AcceptedOrder {
+    vec2<int> goal_coordinates;
+    int accept_delay;
+    bool request_new_paths;
+    vec2<int> clicked_coordinates;
+};
+
+static const vec2<int> NO_CLICKPOS = {-999, -999};
+
+// one unit's order ring (head and count are its order_head/order_count): replaces the front order with the path
+// to it, see UnitPool.cpp. returns how many of the waypoints went in
+int splice_path_orders(AcceptedOrder* ring, int& head, int& count, const vec2<int>* waypoints, int num_waypoints);
+
+// the turns a unit still has to make, one per tick: turn k (1 based) faces start + k * step while k < count,
+// the last one faces goal
+struct TurnSequence {
+    int start;
+    int step;
+    int count;
+    int goal;
+    int done;  // turns already made
+};
+
+//
+// struct-of-arrays storage for every unit in the game. per-unit state is spread across contiguous arrays
+// (indexed by unit id) so that the parts of the tick that touch every unit are plain loops over arrays.
+//
+// headings are one of NUM_DIRECTIONS directions (see fixed_point.h), angle is the same thing in degrees for
+// drawing. in fixed point mode positions are fx_pos_x/fx_pos_y (24.8), stepped with integer math only so every
+// build produces the same ticks, and pos_x/pos_y are exact copies for everything else to read.
+//
+class UnitPool {
+private:
+    // hot state
+    std::vector<float> pos_x;
+    std::vector<float> pos_y;
+    std::vector<int> direction;
+    std::vector<float> angle;
+    std::vector<float> radius;
+    std::vector<int> state;
+    std::vector<int> iscript_ind;
+    std::vector<uint8_t> selected;
+
+    // order ring: slots [i * ORDER_RING_CAPACITY, (i+1) * ORDER_RING_CAPACITY) belong to unit i
+    std::vector<AcceptedOrder> order_ring;
+    std::vector<int> order_head;
+    std::vector<int> order_count;
+
+    // incoming (not yet accepted) orders, the same way with MAX_ORDERS_IN_QUEUE slots per unit. they all count
+    // down together, so the ones that are ready are always at the front
+    std::vector<PlayerOrder> incoming_ring;
+    std::vector<int> incoming_head;
+    std::vector<int> incoming_count;
+
+    // fixed point mode only
+    bool is_fixed_point;
+    std::vector<fixed_t> move_cycle_fixed; // MOVE_CYCLE in 24.8
+    std::vector<fixed_t> fx_pos_x;
+    std::vector<fixed_t> fx_pos_y;
+    std::vector<fixed_t> fx_radius;  // radius, rounded to 24.8 once when the unit is added
+
+    // cold state
+    std::vector<TurnSequence> turns;
+
+    // scratch for the batched movement step
+    std::vector<uint8_t> move_pending;
+    std::vector<float> move_goal_x;
+    std::vector<float> move_goal_y;
+    std::vector<float> move_speed;
+    std::vector<float> move_step_x;
+    std::vector<float> move_step_y;
+    std::vector<uint8_t> move_arrives;
+    std::vector<fixed_t> fx_move_goal_x;
+    std::vector<fixed_t> fx_move_goal_y;
+    std::vector<fixed_t> fx_move_speed;
+    std::vector<uint8_t> scroll_active;
+    std::vector<uint8_t> scrolled;
+    // units waiting on the path they requested this tick, and the requests
+    std::vector<int> path_units;
+    std::vector<int> path_requests;
+
+    bool order_empty(int i) const;
+    AcceptedOrder& order_front(int i);
+    void order_pop(int i);
+    void order_push_back(int i, const AcceptedOrder& order);
+    void order_splice_path(int i, const vec2<int>* waypoints, int num_waypoints);
+    void order_clear(int i);
+    PlayerOrder& incoming_at(int i, int j);
+    void incoming_pop(int i);
+
+    TurnSequence get_turn_sequence(int i, const vec2<int64_t>& goal_delta, const vec2<int64_t>& click_delta) const;
+    void set_turns(int i, const vec2<int>& goal_position, const vec2<int> clickpos = NO_CLICKPOS);
+    bool has_turns(int i) const;
+    bool apply_next_turn(int i);
+    void set_fixed_position(int i, const vec2<fixed_t>& pos);
+    void set_direction(int i, int new_direction);
+    void tick_orders(int i, WorldMap* world_map);
+    void apply_path(int i, const vec2<int>* waypoints, int num_waypoints);
+    void tick_turns(int i);
+    void tick_movement(WorldMap* world_map);
+    void tick_movement_fixed(WorldMap* world_map);
+
+public:
+    explicit UnitPool(bool fixed_point = false);
+    int add_unit(const vec2<float>& pos, float unit_radius = PLAYER_RADIUS);
+    int size() const;
+    vec2<float> get_position(int i) const;
+    float get_angle(int i) const;
+    float get_radius(int i) const;
+    int get_state(int i) const;
+    bool get_selected(int i) const;
+    void set_position(int i, const vec2<float>& pos);
+    void set_angle(int i, float new_angle);
+    void set_selected(int i, bool is_selected);
+    void revive_unit(int i, const vec2<float>& pos);
+    void kill_unit(int i);
+    bool issue_new_order(int i, const vec2<int>& order_coordinates, bool shift_pressed);
+    void tick(WorldMap* world_map);
+    bool get_fixed_point() const;
+    uint64_t get_state_hash() const; // of everything the tick reads, for checking that two runs match
+};
@@ -0,0 +1,100 @@
+#include "WallBits.h"
+
+#include <algorithm>
+
+WallBits::WallBits() :
+    grid_width(0),
+    grid_height(0),
+    words_per_row(0) {}
+
+void WallBits::init(int width, int height) {
+    grid_width = width;
+    grid_height = height;
+    words_per_row = (width + 63) / 64;
+    block_ids.assign(static_cast<size_t>(words_per_row) * ((height + WALL_BLOCK_ROWS - 1) / WALL_BLOCK_ROWS), 0);
+    words.clear();
+    is_shared.clear();
+}
+
+void WallBits::add_block(int bx, int by, const uint64_t* rows, std::unordered_map<uint64_t, uint32_t>& uniform_blocks) {
+    bool is_uniform = std::all_of(rows, rows + WALL_BLOCK_ROWS, [rows](uint64_t row) { return row == rows[0]; });
+    uint32_t& block = block_ids[by * words_per_row + bx];
+    if (is_uniform) {
+        auto found = uniform_blocks.find(rows[0]);
+        if (found != uniform_blocks.end()) {
+            block = found->second;
+            return;
+        }
+    }
+    block = is_shared.size();
+    words.insert(words.end(), rows, rows + WALL_BLOCK_ROWS);
+    is_shared.push_back(is_uniform);
+    if (is_uniform)
+        uniform_blocks[rows[0]] = block;
+}
+
+int WallBits::width() const {
+    return grid_width;
+}
+
+int WallBits::height() const {
+    return grid_height;
+}
+
+int WallBits::get_words_per_row() const {
+    return words_per_row;
+}
+
+uint64_t WallBits::word(int w, int y) const {
+    return words[block_ids[(y / WALL_BLOCK_ROWS) * words_per_row + w] * WALL_BLOCK_ROWS + y % WALL_BLOCK_ROWS];
+}
+
+void WallBits::get_row(int y, uint64_t* out) const {
+    const uint32_t* row_blocks = &block_ids[(y / WALL_BLOCK_ROWS) * words_per_row];
+    for (int w = 0; w < words_per_row; ++w)
+        out[w] = words[row_blocks[w] * WALL_BLOCK_ROWS + y % WALL_BLOCK_ROWS];
+}
+
+void WallBits::set(int x, int y, bool is_wall) {
+    if (get(x, y) == is_wall)
+        return;
+    uint32_t& block = block_ids[(y / WALL_BLOCK_ROWS) * words_per_row + x / 64];
+    if (is_shared[block]) {
+        uint32_t copy = is_shared.size();
+        words.resize(words.size() + WALL_BLOCK_ROWS);
+        std::copy(words.begin() + block * WALL_BLOCK_ROWS, words.begin() + (block + 1) * WALL_BLOCK_ROWS, words.begin() + copy * WALL_BLOCK_ROWS);
+        is_shared.push_back(0);
+        block = copy;
+    }
+    words[block * WALL_BLOCK_ROWS + y % WALL_BLOCK_ROWS] ^= uint64_t(1) << (x % 64);
+}
+
+int WallBits::next_open(int x, int y) const {
+    if (x >= grid_width)
+        return grid_width;
+    int w = x / 64;
+    uint64_t open = ~word(w, y) & (~uint64_t(0) << (x % 64));
+    while (open == 0) {
+        if (++w == words_per_row)
+            return grid_width;
+        open = ~word(w, y);
+    }
+    return w * 64 + __builtin_ctzll(open);
+}
+
+int WallBits::next_wall(int x, int y) const {
+    if (x >= grid_width)
+        return grid_width;
+    int w = x / 64;
+    uint64_t wall = word(w, y) & (~uint64_t(0) << (x % 64));
+    while (wall == 0) {
+        if (++w == words_per_row)
+            return grid_width;
+        wall = word(w, y);
+    }
+    return std::min(w * 64 + __builtin_ctzll(wall), grid_width);
+}
+
+size_t WallBits::get_bytes() const {
+    return block_ids.capacity() * sizeof(uint32_t) + words.capacity() * sizeof(uint64_t) + is_shared.capacity();
+}
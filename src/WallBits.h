@@ -0,0 +1,99 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Array2D.h"
+
+static const int WALL_BLOCK_ROWS = 64;  // a block is one word (64 tiles) wide and this many rows tall
+
+//
+// the wall grid packed one bit per tile (1 = wall), rows along x in 64-bit words like ExplosionMask. the unused
+// bits past the end of every row are set, so anything scanning a row for open tiles stops at the map edge.
+//
+// the words are kept in 64x64 tile blocks. a block whose rows are all the same (solid wall, open floor, a
+// corridor running down it) is stored once and shared by every place it shows up, so big maps only pay for the
+// blocks that have detail in them. reads never change anything, so threads can share one. set() gives a shared
+// block its own copy before writing to it
+//
+class WallBits {
+private:
+    // wall_bits[x][y], so it can stand in for an Array2D<bool> in the map queries
+    class Column {
+    private:
+        const WallBits* bits;
+        int x;
+
+    public:
+        Column(const WallBits* bits, int x) : bits(bits), x(x) {}
+        bool operator[](int y) const {
+            return bits->get(x, y);
+        }
+    };
+
+    int grid_width;
+    int grid_height;
+    int words_per_row;
+    std::vector<uint32_t> block_ids;  // per block, x-major within a row of blocks: which block of words it uses
+    std::vector<uint64_t> words;      // WALL_BLOCK_ROWS per block
+    std::vector<uint8_t> is_shared;   // per block of words
+
+    void init(int width, int height);
+    // stores the block at (bx, by), sharing it if all its rows are the same
+    void add_block(int bx, int by, const uint64_t* rows, std::unordered_map<uint64_t, uint32_t>& uniform_blocks);
+
+public:
+    WallBits();
+    // is_wall(x, y) gets called for every tile, a 64x64 block at a time and column by column inside one, so a
+    // ChunkedGrid behind it only needs a couple of chunks resident
+    template <typename IsWall>
+    static WallBits generate(int width, int height, IsWall is_wall) {
+        WallBits bits;
+        bits.init(width, height);
+        std::unordered_map<uint64_t, uint32_t> uniform_blocks;
+        uint64_t rows[WALL_BLOCK_ROWS];
+        for (int by = 0; by * WALL_BLOCK_ROWS < height; ++by) {
+            int y0 = by * WALL_BLOCK_ROWS;
+            int num_rows = std::min(height - y0, WALL_BLOCK_ROWS);
+            for (int bx = 0; bx < bits.words_per_row; ++bx) {
+                int x0 = bx * 64;
+                int num_columns = std::min(width - x0, 64);
+                uint64_t padding = num_columns < 64 ? ~uint64_t(0) << num_columns : 0;
+                for (int r = 0; r < num_rows; ++r)
+                    rows[r] = padding;
+                for (int x = 0; x < num_columns; ++x) {
+                    for (int r = 0; r < num_rows; ++r) {
+                        if (is_wall(x0 + x, y0 + r))
+                            rows[r] |= uint64_t(1) << x;
+                    }
+                }
+                // rows past the bottom of the map are never read, repeating the last one keeps the block shareable
+                for (int r = num_rows; r < WALL_BLOCK_ROWS; ++r)
+                    rows[r] = rows[num_rows - 1];
+                bits.add_block(bx, by, rows, uniform_blocks);
+            }
+        }
+        return bits;
+    }
+    // from an Array2D<bool> or a ChunkedGrid<bool>
+    template <typename WallGrid>
+    explicit WallBits(const WallGrid& wall_dat) : WallBits(generate(wall_dat.width(), wall_dat.height(),
+                                                                    [&wall_dat](int x, int y) { return wall_dat[x][y]; })) {}
+    int width() const;
+    int height() const;
+    int get_words_per_row() const;
+    uint64_t word(int w, int y) const;  // tiles w * 64 up to w * 64 + 63 of row y
+    void get_row(int y, uint64_t* out) const;  // get_words_per_row() words
+    bool get(int x, int y) const {
+        unsigned ux = x, uy = y;  // unsigned so the divisions are shifts
+        return (words[block_ids[(uy / WALL_BLOCK_ROWS) * words_per_row + ux / 64] * WALL_BLOCK_ROWS + uy % WALL_BLOCK_ROWS] >> (ux % 64)) & 1;
+    }
+    Column operator[](int x) const {
+        return Column(this, x);
+    }
+    void set(int x, int y, bool is_wall);
+    int next_open(int x, int y) const;  // first open tile at or after x in row y, width() if none
+    int next_wall(int x, int y) const;  // first wall at or after x in row y, width() if none
+    size_t get_bytes() const;
+};
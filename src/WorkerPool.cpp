@@ -0,0 +1,68 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(int num_threads) {
+#ifndef __EMSCRIPTEN__
+    if (num_threads <= 0)
+        num_threads = std::min(static_cast<int>(std::thread::hardware_concurrency()), WORKER_POOL_MAX_THREADS);
+    for (int i = 1; i < num_threads; ++i)
+        workers.push_back(std::thread(&WorkerPool::worker_loop, this));
+#else
+    (void)num_threads;
+#endif
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        is_stopping = true;
+    }
+    work_cv.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+// takes the next block of the current run until there are none left
+void WorkerPool::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        work_cv.wait(lock, [this]() { return is_stopping || next_block < num_blocks; });
+        if (is_stopping)
+            return;
+        int block = next_block++;
+        BlockFunction block_function = run_block;
+        const void* block_work = work;
+        lock.unlock();
+        block_function(block_work, block);
+        lock.lock();
+        if (++blocks_done == num_blocks)
+            done_cv.notify_all();
+    }
+}
+
+void WorkerPool::run(int num_blocks, BlockFunction run_block, const void* work) {
+    if (num_blocks <= 0)
+        return;
+    std::unique_lock<std::mutex> lock(mutex);
+    this->run_block = run_block;
+    this->work = work;
+    this->num_blocks = num_blocks;
+    next_block = 0;
+    blocks_done = 0;
+    if (num_blocks > 1 && !workers.empty())
+        work_cv.notify_all();
+    // the caller takes blocks like any worker, then waits for the ones still running elsewhere
+    while (next_block < num_blocks) {
+        int block = next_block++;
+        lock.unlock();
+        run_block(work, block);
+        lock.lock();
+        ++blocks_done;
+    }
+    done_cv.wait(lock, [this]() { return blocks_done == this->num_blocks; });
+}
+
+int WorkerPool::get_num_threads() const {
+    return workers.size() + 1;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static const int WORKER_POOL_MAX_THREADS = 8;
+
+//
+// a fixed set of worker threads that sleep until run() hands them blocks of work, started once and kept for as
+// long as the pool lives (so nothing gets created or joined per call). the thread calling run() works on the
+// blocks too, and run() returns once every block is done. blocks get picked up in whatever order, so work(block)
+// has to write only to things that belong to its block. on wasm there are no workers, run() does it all
+//
+class WorkerPool {
+private:
+    typedef void (*BlockFunction)(const void* work, int block);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+    bool is_stopping = false;
+    // the current run, under mutex
+    BlockFunction run_block = nullptr;
+    const void* work = nullptr;
+    int num_blocks = 0;
+    int next_block = 0;
+    int blocks_done = 0;
+
+    void worker_loop();
+    void run(int num_blocks, BlockFunction run_block, const void* work);
+
+public:
+    explicit WorkerPool(int num_threads = 0);  // counting the caller's. 0: one per core, up to WORKER_POOL_MAX_THREADS
+    ~WorkerPool();
+    // work(block) for every block in [0, num_blocks), no allocations
+    template <typename Work>
+    void run(int num_blocks, const Work& work) {
+        run(num_blocks, [](const void* w, int block) { (*static_cast<const Work*>(w))(block); }, &work);
+    }
+    int get_num_threads() const;  // workers + the caller
+};
@@ -1,21 +1,44 @@
 #include "WorldMap.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <fstream>
 #include <stdexcept>
 #include <vector>
 
 #include <nlohmann/json.hpp>
 
-#include "Array2D.h"
+#include "ChunkedGrid.h"
 #include "geometry.h"
 #include "globals.h"
 #include "misc_gfx.h"
 #include "pathfinding.h"
+#include "Profiler.h"
+#include "tile_rle.h"
+#include "UnitPool.h"
 #include "Vec2.h"
 
 using json = nlohmann::json;
 
+// hands out a map's tiles in x + y * width order, from either tile_dat or tile_dat_rle
+struct MapTileReader {
+    const json& tile_array;
+    TileRunDecoder decoder;
+    bool is_rle;
+    size_t next_index;
+    int num_tile_types;
+
+    int operator()() {
+        int tile = is_rle ? decoder.next() : tile_array[next_index++].get<int>();
+        if (tile < 0 || tile >= num_tile_types)
+            throw std::invalid_argument("Map has invalid tiles");
+        return tile;
+    }
+};
+
 WorldMap::WorldMap(const std::string& map_filename) {
+    PROFILE_ZONE("WorldMap load");
 
     std::ifstream input_file(map_filename);
     json loaded_data;
@@ -38,30 +61,44 @@ WorldMap::WorldMap(const std::string& map_filename) {
 
     std::string tileset_json = loaded_data["tileset"];
     tile_manager = new TileManager(tileset_json);
-    std::vector<int> map_tile_vector = loaded_data["tile_dat"].get<std::vector<int>>();
-    int max_tile_index = *std::max_element(map_tile_vector.begin(), map_tile_vector.end());
-    if (max_tile_index >= tile_manager->get_number_of_loaded_tiles())
-        throw std::invalid_argument("Map has invalid tiles");
-
-    tile_dat = Array2D<int>(map_width, map_height, map_tile_vector);
-    wall_dat = Array2D<bool>(tile_dat.width(), tile_dat.height(), false);
-    for (int i = 0; i < tile_dat.width(); ++i) {
-        for (int j = 0; j < tile_dat.height(); ++j) {
-            wall_dat[i][j] = tile_manager->get_tile_iswall(tile_dat[i][j]);
-        }
-    }
+    // tile_dat or tile_dat_rle, streamed straight into the chunks (once for the tiles, once for the walls)
+    const json& tile_array = loaded_data["tile_dat"];
+    bool is_rle = loaded_data.contains("tile_dat_rle");
+    static const std::string no_rle;
+    const std::string& rle_text = is_rle ? loaded_data["tile_dat_rle"].get_ref<const std::string&>() : no_rle;
+    if (!is_rle && (!tile_array.is_array() || tile_array.size() != static_cast<size_t>(map_width) * map_height))
+        throw std::invalid_argument("Map tile_dat size does not match its dimensions");
+    MapTileReader tile_reader = {tile_array, TileRunDecoder(rle_text), is_rle, 0, tile_manager->get_number_of_loaded_tiles()};
+    MapTileReader wall_reader = tile_reader;
+    auto next_wall = [this, &wall_reader]() { return tile_manager->get_tile_iswall(wall_reader()); };
+
+    // only the chunks around units and the camera are kept decoded, see ChunkedGrid
+    resident_chunks = loaded_data.value("resident_chunks", MAP_RESIDENT_CHUNKS);
+    tile_dat = ChunkedGrid<int>::generate(map_width, map_height, tile_reader, resident_chunks);
+    wall_dat = ChunkedGrid<bool>::generate(map_width, map_height, next_wall, resident_chunks);
+    if (is_rle && !wall_reader.decoder.at_end())
+        throw std::invalid_argument("tile_dat_rle has more tiles than the map");
+    drawn_tile_dat = tile_dat;
+    tile_changes = std::make_shared<const std::vector<TileChange>>();
     std::vector<int> start_pos = loaded_data["start_pos"].get<std::vector<int>>();
     if (start_pos.size() != 2 || start_pos[0] < 0 || start_pos[1] < 0)
         throw std::invalid_argument("Map has invalid start_pos");
     player_start = {start_pos[0], start_pos[1]};
+    init_lives = loaded_data["init_lives"];
 
     printf("map_name: %s (%ix%i)\n", map_name.c_str(), tile_dat.width(), tile_dat.height());
     printf("player_start: (%i,%i)\n", player_start.x, player_start.y);
 
-    double start_time = SDL_GetTicks() / 1000.0;
-    pf_data = get_pathfinding_data(wall_dat);
-    double end_time = SDL_GetTicks() / 1000.0 - start_time;
+    unit_radii.push_back(PLAYER_RADIUS);
+    double start_time = get_precise_time();
+    pf_data = get_pathfinding_data(WallBits(wall_dat), unit_radii, resident_chunks);
+    update_pathfinding_debug();
+    load_flow_vectors();
+    build_flow_field();
+    double end_time = get_precise_time() - start_time;
     printf("map processed in %f seconds\n", end_time);
+    ChunkStats chunk_stats = get_chunk_stats();
+    printf("map chunks: %i, %zu bytes stored (%zu decoded)\n", chunk_stats.num_chunks, chunk_stats.stored_bytes, chunk_stats.full_bytes);
 
     //
     // parse obstacles
@@ -112,7 +149,7 @@ WorldMap::WorldMap(const std::string& map_filename) {
                 std::vector<int> loc_list = exp[0].get<std::vector<int>>();
                 std::vector<std::string> unit_list = exp[1].get<std::vector<std::string>>();
                 int delay = exp[2];
-                explosions.push_back({loc_list, unit_list, delay});
+                explosions.push_back({loc_list, unit_list, delay, {}});
                 current_exp_num += 1;
             }
             //
@@ -131,6 +168,11 @@ WorldMap::WorldMap(const std::string& map_filename) {
         }
         current_ob_num += 1;
     }
+
+    // compile obstacle locations into tile masks for kill detection
+    explosion_mask = ExplosionMask(map_width, map_height);
+    for (const Obstacle& ob : obstacles)
+        explosion_mask.add_obstacle(ob.get_locations());
 }
 
 WorldMap::~WorldMap() {
@@ -146,97 +188,427 @@ vec2<int> WorldMap::get_start_pos() {
     return GRIDSIZE * player_start + vec2<int>({GRIDSIZE/2, GRIDSIZE/2});
 }
 
-vec2<float> WorldMap::get_move_pos(const vec2<float>& position, const vec2<float>& goal_position) {
+int WorldMap::get_init_lives() {
+    return init_lives;
+}
+
+vec2<int> WorldMap::get_revive_pos(int ob_num) {
+    int num_obs = obstacles.size();
+    if (ob_num < 1 || ob_num > num_obs)
+        return get_start_pos();
+    return obstacles[ob_num - 1].get_revive_pos();
+}
+
+// interned "obnum-locnum", both 1-indexed. -1 if there's no such location
+int WorldMap::get_location_id(int ob_num, int loc_num) {
+    int num_obs = obstacles.size();
+    if (ob_num < 1 || ob_num > num_obs)
+        return -1;
+    int num_locs = obstacles[ob_num - 1].get_locations().size();
+    if (loc_num < 1 || loc_num > num_locs)
+        return -1;
+    return obstacles[ob_num - 1].get_location_id(loc_num);
+}
+
+bool WorldMap::is_valid_position(const vec2<float>& position, float radius) {
+    return valid_player_position(position, wall_dat, radius);
+}
+
+vec2<float> WorldMap::get_move_pos(const vec2<float>& position, const vec2<float>& goal_position, float radius) {
     vec2<float> dv = goal_position - position;
     for (float scale_factor = 1.00f; scale_factor > EPSILON; scale_factor -= 0.05f) {
         vec2<float> test_pos = (scale_factor * dv) + position;
-        if (valid_player_position(test_pos, wall_dat))
+        if (valid_player_position(test_pos, wall_dat, radius))
             return test_pos;
     }
     return position;
 }
 
-vec2<float> WorldMap::get_scrolled_pos(const vec2<float>& position) {
-    vec2<float> map_position = {position.x / GRIDSIZE, position.y / GRIDSIZE};
-    vec2<float> scroll_xy = tile_manager->get_tile_scroll(tile_dat[static_cast<int>(map_position.x)][static_cast<int>(map_position.y)]);
-    // deal with floating point
-    if (std::abs(scroll_xy.x) < EPSILON)
-        scroll_xy.x = 0.0f;
-    if (std::abs(scroll_xy.y) < EPSILON)
-        scroll_xy.y = 0.0f;
-    if (std::abs(scroll_xy.x) > EPSILON || std::abs(scroll_xy.y) > EPSILON) {
-        // nudge towards destination
-        vec2<float> out_pos = position;
-        for (float scale_factor = 0.05f; scale_factor <= 1.0f + EPSILON; scale_factor += 0.05f) {
-            vec2<float> test_pos = (scale_factor * scroll_xy) + position;
-            if (!valid_player_position(test_pos, wall_dat))
-                break;
-            out_pos = test_pos;
-        }
-        return out_pos;
+// get_move_pos for the fixed point sim mode. the same 20 steps, done in 24.8 and checked against the walls with
+// integers only
+vec2<fixed_t> WorldMap::get_move_pos_fixed(const vec2<fixed_t>& position, const vec2<fixed_t>& goal_position, fixed_t radius) {
+    int64_t dx = goal_position.x - position.x;
+    int64_t dy = goal_position.y - position.y;
+    for (int step = MOVE_POS_STEPS; step > 0; --step) {
+        vec2<fixed_t> test_pos = {static_cast<fixed_t>(position.x + dx * step / MOVE_POS_STEPS),
+                                  static_cast<fixed_t>(position.y + dy * step / MOVE_POS_STEPS)};
+        if (valid_player_position_fixed(test_pos, wall_dat, radius))
+            return test_pos;
     }
     return position;
 }
 
+//
+// conveyors
+//
+
+// every tile type that scrolls gets a flow (1..255), with its scroll in float and 24.8 and how many whole px it
+// can carry a unit along either axis
+void WorldMap::load_flow_vectors() {
+    tile_flows.clear();
+    flow_vectors.assign(1, {0.0f, 0.0f});
+    flow_vectors_fixed.assign(1, {0, 0});
+    flow_reach.assign(1, 0);
+    for (int tile = 0; tile < tile_manager->get_number_of_loaded_tiles(); ++tile) {
+        vec2<float> scroll = tile_manager->get_tile_scroll(tile);
+        // deal with floating point
+        if (std::abs(scroll.x) < EPSILON)
+            scroll.x = 0.0f;
+        if (std::abs(scroll.y) < EPSILON)
+            scroll.y = 0.0f;
+        if (scroll.x == 0.0f && scroll.y == 0.0f) {
+            tile_flows.push_back(0);
+            continue;
+        }
+        if (flow_vectors.size() > UINT8_MAX)
+            throw std::invalid_argument("Tileset has more than 255 conveyor tiles");
+        tile_flows.push_back(flow_vectors.size());
+        flow_vectors.push_back(scroll);
+        flow_vectors_fixed.push_back({float_to_fixed(scroll.x), float_to_fixed(scroll.y)});
+        flow_reach.push_back(static_cast<int>(std::ceil(std::max(std::abs(scroll.x), std::abs(scroll.y)))));
+    }
+}
+
+// a unit anywhere on tile (x, y) whose radius plus scroll reach fits in safe_distance stays inside the tile's open
+// clearance square, so (that square being convex) every step of its scroll is valid and it can skip the wall checks.
+// only conveyor tiles get one, so the rest of the field stays a single run per chunk
+FlowTile WorldMap::get_flow_tile(int tile, int x, int y) const {
+    uint8_t flow = tile_flows[tile];
+    if (flow == 0)
+        return {0, 0};
+    int clearance = std::max(pf_data.clearance.get(x, y) - 1, 0);
+    return {flow, static_cast<uint8_t>(std::min(clearance * GRIDSIZE, UINT8_MAX))};
+}
+
+// needs pf_data's clearance to be up to date
+void WorldMap::build_flow_field() {
+    int x = 0;
+    int y = 0;
+    auto next_flow = [this, &x, &y]() {
+        FlowTile flow = get_flow_tile(tile_dat.get(x, y), x, y);
+        if (++x == tile_dat.width()) {
+            x = 0;
+            y += 1;
+        }
+        return flow;
+    };
+    flow_dat = ChunkedGrid<FlowTile>::generate(tile_dat.width(), tile_dat.height(), next_flow, resident_chunks);
+}
+
+// nudges every active unit along the conveyor it's standing on in one pass over the flow field, scrolled[i] says
+// whether unit i moved. units that can't reach a wall go the whole way at once, the rest step towards it
+// MOVE_POS_STEPS times and stop in front of the first wall
+void WorldMap::apply_scroll(int num_units, float* pos_x, float* pos_y, const float* radii, const uint8_t* active, uint8_t* scrolled) {
+    PROFILE_ZONE("WorldMap::apply_scroll");
+    for (int i = 0; i < num_units; ++i) {
+        scrolled[i] = 0;
+        if (!active[i])
+            continue;
+        FlowTile tile = flow_dat.get(static_cast<int>(pos_x[i] / F_GRIDSIZE), static_cast<int>(pos_y[i] / F_GRIDSIZE));
+        if (tile.flow == 0)
+            continue;
+        vec2<float> scroll = flow_vectors[tile.flow];
+        vec2<float> position = {pos_x[i], pos_y[i]};
+        vec2<float> out_pos = scroll + position;
+        if (flow_reach[tile.flow] + radii[i] > tile.safe_distance) {
+            out_pos = position;
+            for (int step = 1; step <= MOVE_POS_STEPS; ++step) {
+                vec2<float> test_pos = (static_cast<float>(step) / MOVE_POS_STEPS * scroll) + position;
+                if (!valid_player_position(test_pos, wall_dat, radii[i]))
+                    break;
+                out_pos = test_pos;
+            }
+        }
+        vec2<float> d_scroll = out_pos - position;
+        scrolled[i] = std::abs(d_scroll.x) > EPSILON || std::abs(d_scroll.y) > EPSILON;
+        pos_x[i] = out_pos.x;
+        pos_y[i] = out_pos.y;
+    }
+}
+
+// same as apply_scroll, in 24.8 (radii too, so the safe_distance test and the wall checks are integer only)
+void WorldMap::apply_scroll_fixed(int num_units, fixed_t* pos_x, fixed_t* pos_y, const fixed_t* radii, const uint8_t* active, uint8_t* scrolled) {
+    PROFILE_ZONE("WorldMap::apply_scroll_fixed");
+    for (int i = 0; i < num_units; ++i) {
+        scrolled[i] = 0;
+        if (!active[i])
+            continue;
+        FlowTile tile = flow_dat.get(fixed_to_int(pos_x[i]) / GRIDSIZE, fixed_to_int(pos_y[i]) / GRIDSIZE);
+        vec2<fixed_t> scroll = flow_vectors_fixed[tile.flow];
+        if (scroll.x == 0 && scroll.y == 0)
+            continue;
+        vec2<fixed_t> position = {pos_x[i], pos_y[i]};
+        vec2<fixed_t> out_pos = {position.x + scroll.x, position.y + scroll.y};
+        if (flow_reach[tile.flow] * FIXED_ONE + radii[i] > tile.safe_distance * FIXED_ONE) {
+            out_pos = position;
+            for (int step = 1; step <= MOVE_POS_STEPS; ++step) {
+                vec2<fixed_t> test_pos = {position.x + scroll.x * step / MOVE_POS_STEPS, position.y + scroll.y * step / MOVE_POS_STEPS};
+                if (!valid_player_position_fixed(test_pos, wall_dat, radii[i]))
+                    break;
+                out_pos = test_pos;
+            }
+        }
+        scrolled[i] = out_pos != position;
+        pos_x[i] = out_pos.x;
+        pos_y[i] = out_pos.y;
+    }
+}
+
+// build a pathfinding graph for a new unit size (no-op if we already have one). a whole map's worth of work, so
+// this belongs with the map load or unit setup, never in a tick
+void WorldMap::add_unit_radius(float radius) {
+    if (get_radius_class(pf_data, radius) >= 0)
+        return;
+    unit_radii.push_back(radius);
+    double start_time = get_precise_time();
+    pf_data.radius_classes.push_back(get_pathfinding_graph(radius, pf_data.clearance, pf_data.resident_chunks));
+    double end_time = get_precise_time() - start_time;
+    printf("radius class %.1f (inflation %i): %zu bytes, built in %f seconds\n", radius, pf_data.radius_classes.back().inflation,
+           get_pathfinding_graph_bytes(pf_data.radius_classes.back()), end_time);
+}
+
+// pages in the map around every living unit before they move, so the chunks they're about to query are
+// resident (and freshly used) rather than faulted in one at a time in the middle of the tick
+void WorldMap::prefetch_chunks(const UnitPool& units) {
+    PROFILE_ZONE("WorldMap::prefetch_chunks");
+    for (int i = 0; i < units.size(); ++i) {
+        if (units.get_state(i) == PlayerState::DEAD)
+            continue;
+        vec2<float> pos = units.get_position(i);
+        int margin = static_cast<int>(units.get_radius(i) / F_GRIDSIZE) + 1;
+        int x = static_cast<int>(pos.x / F_GRIDSIZE);
+        int y = static_cast<int>(pos.y / F_GRIDSIZE);
+        wall_dat.prefetch(x - margin, y - margin, x + margin, y + margin);
+        flow_dat.prefetch(x, y, x, y);
+    }
+}
+
+// sim thread grids only (the pathfinding ones included), the render thread's drawn_tile_dat isn't counted
+ChunkStats WorldMap::get_chunk_stats() const {
+    ChunkStats stats = tile_dat.get_stats();
+    stats.add(wall_dat.get_stats());
+    stats.add(flow_dat.get_stats());
+    stats.add(pf_data.clearance.get_stats());
+    for (const PathfindingGraph& pf_graph : pf_data.radius_classes)
+        stats.add(pf_graph.tile_2_region_id.get_stats());
+    return stats;
+}
+
+// staged until commit_tile_changes, so everything that reads the map in the meantime still sees it as it was
 void WorldMap::change_map_tiles(const std::vector<vec2<int>>& coord_list, const std::vector<int>& tileid_list) {
     if (coord_list.size() != tileid_list.size())
         throw std::invalid_argument("coord_list and tileid_list have different sizes");
-    bool any_wall_change = false;
     for (size_t i = 0; i < coord_list.size(); ++i) {
         vec2<int> coord = coord_list[i];
         if (coord.x > 0 && coord.x < wall_dat.width() && coord.y > 0 && coord.y < wall_dat.height()) {
-            tile_dat[coord.x][coord.y] = tileid_list[i];
-            bool previous_wall = wall_dat[coord.x][coord.y];
-            wall_dat[coord.x][coord.y] = tile_manager->get_tile_iswall(tile_dat[coord.x][coord.y]);
-            if (wall_dat[coord.x][coord.y] != previous_wall)
-                any_wall_change = true;
+            int tile_index = coord.x + coord.y * tile_dat.width();
+            auto it = staged_tile_lookup.find(tile_index);
+            if (it == staged_tile_lookup.end()) {
+                staged_tile_lookup[tile_index] = staged_tiles.size();
+                staged_tiles.push_back({tile_index, tileid_list[i]});
+            }
+            else
+                staged_tiles[it->second].tile = tileid_list[i];
         }
     }
-    if (any_wall_change) {
-        double start_time = SDL_GetTicks() / 1000.0;
-        pf_data = get_pathfinding_data(wall_dat);
-        double end_time = SDL_GetTicks() / 1000.0 - start_time;
-        printf("map tiles changed in %f seconds\n", end_time);
+}
+
+// applies everything change_map_tiles staged since the last commit at once: one pathfinding update for all the
+// walls that flipped, and one pass over the flow field covering every changed tile and the tiles whose
+// clearance those walls can have changed
+void WorldMap::commit_tile_changes() {
+    if (staged_tiles.empty())
+        return;
+    PROFILE_ZONE("WorldMap::commit_tile_changes");
+    double start_time = get_precise_time();
+    int width = tile_dat.width();
+    int height = tile_dat.height();
+    std::vector<vec2<int>> wall_changes;
+    // the dirty region, inclusive
+    int x0 = width;
+    int y0 = height;
+    int x1 = -1;
+    int y1 = -1;
+    auto grow = [&](int gx0, int gy0, int gx1, int gy1) {
+        x0 = std::max(std::min(x0, gx0), 0);
+        y0 = std::max(std::min(y0, gy0), 0);
+        x1 = std::min(std::max(x1, gx1), width - 1);
+        y1 = std::min(std::max(y1, gy1), height - 1);
+    };
+    for (const TileChange& change : staged_tiles) {
+        int x = change.tile_index % width;
+        int y = change.tile_index / width;
+        tile_dat.set(x, y, change.tile);
+        auto it = changed_tile_lookup.find(change.tile_index);
+        if (it == changed_tile_lookup.end()) {
+            changed_tile_lookup[change.tile_index] = changed_tiles.size();
+            changed_tiles.push_back(change);
+        }
+        else
+            changed_tiles[it->second].tile = change.tile;
+        bool previous_wall = wall_dat.get(x, y);
+        bool is_wall = tile_manager->get_tile_iswall(change.tile);
+        wall_dat.set(x, y, is_wall);
+        if (is_wall != previous_wall)
+            wall_changes.push_back({x, y});
+        grow(x, y, x, y);
+    }
+    if (!wall_changes.empty()) {
+        update_pathfinding_data(pf_data, wall_dat, wall_changes, unit_radii);
+        update_pathfinding_debug();
+        // a wall only changes the clearance of tiles it's nearer to than their nearest other wall, and every
+        // clearance past FLOW_CLEARANCE_CAP gives the same capped safe_distance, so nothing further out can change
+        for (const vec2<int>& coord : wall_changes)
+            grow(coord.x - FLOW_CLEARANCE_CAP, coord.y - FLOW_CLEARANCE_CAP, coord.x + FLOW_CLEARANCE_CAP, coord.y + FLOW_CLEARANCE_CAP);
+    }
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x)
+            flow_dat.set(x, y, get_flow_tile(tile_dat.get(x, y), x, y));
+    }
+    double end_time = get_precise_time() - start_time;
+    printf("map tiles changed (%zu tiles, %zu walls, dirty region (%i,%i)-(%i,%i)) in %f seconds\n", staged_tiles.size(),
+           wall_changes.size(), x0, y0, x1, y1, end_time);
+    staged_tiles.clear();
+    staged_tile_lookup.clear();
+    tile_changes = std::make_shared<const std::vector<TileChange>>(changed_tiles);
+}
+
+// pathfinding graph for the default unit size in map pixels, for the debug overlay
+void WorldMap::update_pathfinding_debug() {
+    const PathfindingGraph& pf_graph = pf_data.radius_classes[0];
+    std::vector<Line> edges;
+    vec2<int> pf_edge_adj = {GRIDSIZE/2, GRIDSIZE/2};
+    for (const RegionGraph& region_graph : pf_graph.regions) {
+        for (const Line& edge : get_region_edges(region_graph))
+            edges.push_back({GRIDSIZE*edge.start + pf_edge_adj, GRIDSIZE*edge.end + pf_edge_adj});
+    }
+    std::vector<vec2<int>> nodes;
+    vec2<int> pf_node_adj = {GRIDSIZE/2 - PF_NODE_RADIUS/2, GRIDSIZE/2 - PF_NODE_RADIUS/2};
+    for (const RegionGraph& region_graph : pf_graph.regions) {
+        for (const vec2<int>& node : region_graph.nodes)
+            nodes.push_back(GRIDSIZE*node + pf_node_adj);
     }
+    pf_debug_edges = std::make_shared<const std::vector<Line>>(std::move(edges));
+    pf_debug_nodes = std::make_shared<const std::vector<vec2<int>>>(std::move(nodes));
+}
+
+// obnum is 0-indexed. stops whatever else player was running, -1 just stops everything
+void WorldMap::set_current_obstacle(int obnum, int player) {
+    ob_scheduler.deactivate_all(player);
+    activate_obstacle(obnum, player);
 }
 
-void WorldMap::set_current_obstacle(int obnum) {
+void WorldMap::activate_obstacle(int obnum, int player) {
     int num_obs = obstacles.size();
-    currently_active_ob = obnum;
-    if (currently_active_ob >= 0 && currently_active_ob < num_obs)
-        obstacles[currently_active_ob].reset();
+    if (obnum >= 0 && obnum < num_obs)
+        ob_scheduler.activate(obnum, player);
 }
 
-std::vector<vec2<int>> WorldMap::pathfind(const vec2<int>& start_pos, const vec2<int>& end_pos) {
+void WorldMap::deactivate_obstacle(int obnum, int player) {
+    ob_scheduler.deactivate(obnum, player);
+}
+
+void WorldMap::reset_obstacle(int obnum, int player) {
+    ob_scheduler.reset(obnum, player);
+}
+
+void WorldMap::pause_obstacle(int obnum, int player) {
+    ob_scheduler.pause(obnum, player);
+}
+
+void WorldMap::resume_obstacle(int obnum, int player) {
+    ob_scheduler.resume(obnum, player);
+}
+
+int WorldMap::request_path(const vec2<int>& start_pos, const vec2<int>& end_pos, float radius) {
     vec2<int> map_size = get_map_size() - vec2<int>(1,1);
     vec2<int> start_pos_bounded = {value_clamp(start_pos.x, 0, map_size.x), value_clamp(start_pos.y, 0, map_size.y)};
     vec2<int> end_pos_bounded = {value_clamp(end_pos.x, 0, map_size.x), value_clamp(end_pos.y, 0, map_size.y)};
-    return get_pathfinding_waypoints(start_pos_bounded, end_pos_bounded, pf_data, wall_dat);
+    path_batch.requests.push_back({start_pos_bounded, end_pos_bounded, radius});
+    return path_batch.requests.size() - 1;
 }
 
-std::vector<Event> WorldMap::tick() {
-    std::vector<Event> out_events;
+void WorldMap::resolve_paths() {
+    PROFILE_ZONE("WorldMap::resolve_paths");
+    get_pathfinding_waypoints(path_batch, pf_data, wall_dat, &path_workers);
+    path_batch.requests.clear();
+}
+
+int WorldMap::get_path(int request, const vec2<int>*& waypoints) const {
+    waypoints = path_batch.waypoints.data() + path_batch.starts[request];
+    return path_batch.starts[request + 1] - path_batch.starts[request];
+}
+
+void WorldMap::tick(EventBus& events) {
+    PROFILE_ZONE("WorldMap::tick");
     tile_manager->tick();
-    int num_obs = obstacles.size();
-    if (currently_active_ob >= 0 && currently_active_ob < num_obs) {
-        std::vector<Event> ob_events = obstacles[currently_active_ob].tick();
-        for (auto event : ob_events)
-            out_events.push_back(event);
+    explosion_mask.clear();
+    ob_scheduler.tick(obstacles, fired_explosions);
+    for (const FiredExplosion& fired : fired_explosions) {
+        const Obstacle& ob = obstacles[fired.ob_index];
+        ob.explode(fired.count, events);
+        for (int loc_num : ob.get_explosion_locs(fired.count))
+            explosion_mask.explode(fired.ob_index, loc_num - 1);
     }
-    return out_events;
 }
 
-void WorldMap::draw(const vec2<int>& offset) {
+// units (that aren't already dead) with any part of their body in a location that exploded on the most recent tick
+void WorldMap::get_kill_events(const UnitPool& units, std::vector<KillEvent>& out_kills) {
+    out_kills.clear();
+    if (!explosion_mask.any_exploding())
+        return;
+    for (int i = 0; i < units.size(); ++i) {
+        if (units.get_state(i) == PlayerState::DEAD)
+            continue;
+        vec2<float> pos = units.get_position(i);
+        float radius = units.get_radius(i);
+        if (explosion_mask.is_exploding(pos, radius)) {
+            vec2<int> ob_loc = explosion_mask.get_exploding_location(pos, radius);
+            out_kills.push_back({i, ob_loc.x, ob_loc.y});
+        }
+    }
+}
+
+void WorldMap::fill_snapshot(RenderSnapshot& snapshot) const {
+    tile_manager->fill_snapshot(snapshot.tile_frames);
+    snapshot.active_obstacles.clear();
+    for (size_t i = 0; i < obstacles.size(); ++i) {
+        if (ob_scheduler.is_active(i))
+            snapshot.active_obstacles.push_back(i);
+    }
+    snapshot.tile_changes = tile_changes;
+    snapshot.map_chunks = get_chunk_stats();
+    snapshot.pf_debug_edges = pf_debug_edges;
+    snapshot.pf_debug_nodes = pf_debug_nodes;
+}
+
+// only reads the snapshot and render thread state (drawn_tile_dat, textures, obstacle geometry)
+void WorldMap::draw(const RenderSnapshot& snapshot, const vec2<int>& offset) {
+    // catch up on tile changes
+    if (snapshot.tile_changes && snapshot.tile_changes != drawn_tile_changes) {
+        for (const TileChange& change : *snapshot.tile_changes)
+            drawn_tile_dat.set(change.tile_index % drawn_tile_dat.width(), change.tile_index / drawn_tile_dat.width(), change.tile);
+        drawn_tile_changes = snapshot.tile_changes;
+    }
+
     // draw terrain
-    int start_x = offset.x / GRIDSIZE;
-    int start_y = offset.y / GRIDSIZE;
-    int end_x = (offset.x + RESOLUTION.x) / GRIDSIZE + 1;
-    int end_y = (offset.y + RESOLUTION.y) / GRIDSIZE + 1;
-    for (int i = start_x; i < end_x && i < tile_dat.width(); ++i) {
-        for (int j = start_y; j < end_y && j < tile_dat.height(); ++j) {
-            SDL_Rect rect = {GRIDSIZE * i - offset.x, GRIDSIZE * j - offset.y, GRIDSIZE, GRIDSIZE};
-            SDL_RenderCopy(renderer, tile_manager->get_tile_texture(tile_dat[i][j]), nullptr, &rect);
+    {
+        PROFILE_ZONE("draw terrain");
+        int start_x = offset.x / GRIDSIZE;
+        int start_y = offset.y / GRIDSIZE;
+        int end_x = (offset.x + RESOLUTION.x) / GRIDSIZE + 1;
+        int end_y = (offset.y + RESOLUTION.y) / GRIDSIZE + 1;
+        // a chunk of read-ahead on every side, so scrolling doesn't page in the middle of a frame
+        drawn_tile_dat.prefetch(start_x - MAP_CHUNK_SIZE, start_y - MAP_CHUNK_SIZE, end_x + MAP_CHUNK_SIZE, end_y + MAP_CHUNK_SIZE);
+        for (int i = start_x; i < end_x && i < drawn_tile_dat.width(); ++i) {
+            for (int j = start_y; j < end_y && j < drawn_tile_dat.height(); ++j) {
+                SDL_Rect rect = {GRIDSIZE * i - offset.x, GRIDSIZE * j - offset.y, GRIDSIZE, GRIDSIZE};
+                int tile = drawn_tile_dat[i][j];
+                unsigned int frame = static_cast<size_t>(tile) < snapshot.tile_frames.size() ? snapshot.tile_frames[tile] : 0;
+                tile_manager->queue_tile(tile, frame, rect);
+            }
         }
+        tile_manager->flush_tiles();
     }
 
     //// draw impassable tiles
@@ -250,28 +622,23 @@ void WorldMap::draw(const vec2<int>& offset) {
     //    }
     //}
 
-    // draw pathfinding edges
-    vec2<int> pf_edge_adj = {GRIDSIZE/2, GRIDSIZE/2};
-    for (size_t rid = 0; rid < pf_data.edges.size(); ++rid) {
-        for (size_t i = 0; i < pf_data.edges[rid].size(); ++i) {
-            Line my_line = {GRIDSIZE*pf_data.edges[rid][i].start + pf_edge_adj, GRIDSIZE*pf_data.edges[rid][i].end + pf_edge_adj};
-            my_line.start -= offset;
-            my_line.end -= offset;
-            draw_line(my_line, PATH_EDGE_COL);
+    {
+        PROFILE_ZONE("draw pathfinding debug");
+        // draw pathfinding edges (default unit size only)
+        if (snapshot.pf_debug_edges) {
+            for (const Line& edge : *snapshot.pf_debug_edges)
+                draw_line(Line{edge.start - offset, edge.end - offset}, PATH_EDGE_COL);
         }
-    }
 
-    // draw pathfinding nodes
-    vec2<int> pf_node_adj = {GRIDSIZE/2 - PF_NODE_RADIUS/2, GRIDSIZE/2 - PF_NODE_RADIUS/2};
-    for (size_t rid = 0; rid < pf_data.nodes.size(); ++rid) {
-        for (size_t i = 0; i < pf_data.nodes[rid].size(); ++i) {
-            Rect my_rect = {GRIDSIZE*pf_data.nodes[rid][i] + pf_node_adj, {PF_NODE_RADIUS, PF_NODE_RADIUS}};
-            my_rect.position -= offset;
-            draw_rect(my_rect, PATH_NODE_COL, true);
+        // draw pathfinding nodes
+        if (snapshot.pf_debug_nodes) {
+            for (const vec2<int>& node : *snapshot.pf_debug_nodes)
+                draw_rect(Rect{node - offset, {PF_NODE_RADIUS, PF_NODE_RADIUS}}, PATH_NODE_COL, true);
         }
     }
 
-    // draw current obstacle
-    if (currently_active_ob >= 0)
-        obstacles[currently_active_ob].draw(offset);
+    // draw running obstacles
+    PROFILE_ZONE("draw obstacles");
+    for (int i : snapshot.active_obstacles)
+        obstacles[i].draw(offset);
 }
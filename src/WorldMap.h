@@ -1,40 +1,117 @@
 #pragma once
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <SDL.h>
 
-#include "Array2D.h"
+#include "ChunkedGrid.h"
+#include "EventBus.h"
+#include "ExplosionMask.h"
+#include "fixed_point.h"
 #include "Obstacle.h"
+#include "ObstacleScheduler.h"
 #include "pathfinding.h"
+#include "RenderSnapshot.h"
 #include "TileManager.h"
 #include "Vec2.h"
 
 extern SDL_Renderer* renderer;
 
+class UnitPool;
+
 static const int PF_NODE_RADIUS = 4; // width of pathfinding nodes (for drawing)
+static const int FLOW_CLEARANCE_CAP = UINT8_MAX / GRIDSIZE + 1; // safe_distance stops growing once clearance passes this
+static const int MOVE_POS_STEPS = 20;  // get_move_pos_fixed and the conveyor nudge (when it can hit a wall) try 1/20th steps
+
+// one tile of the conveyor flow field. flow indexes WorldMap::flow_vectors (0 = not a conveyor), safe_distance is
+// how far (px) the open square around the tile reaches past the tile on every side, see build_flow_field
+struct FlowTile {
+    uint8_t flow;
+    uint8_t safe_distance;
+
+    bool operator==(const FlowTile& other) const {
+        return flow == other.flow && safe_distance == other.safe_distance;
+    }
+    bool operator!=(const FlowTile& other) const {
+        return !(*this == other);
+    }
+};
 
 class WorldMap {
 private:
     PathfindingData pf_data;
-    Array2D<int> tile_dat;
-    Array2D<bool> wall_dat;
+    std::vector<float> unit_radii;
+    PathBatch path_batch;  // the tick's path requests, then their results
+    WorkerPool path_workers;  // the batch's searches run on these, started with the map and kept until it goes
+    ChunkedGrid<int> tile_dat;
+    ChunkedGrid<bool> wall_dat;
+    int resident_chunks = MAP_RESIDENT_CHUNKS;
+    // conveyors: per tile flow, plus the scroll (and its reach in whole px) of every conveyor tile type
+    ChunkedGrid<FlowTile> flow_dat;
+    std::vector<uint8_t> tile_flows;  // tile type -> flow
+    std::vector<vec2<float>> flow_vectors;
+    std::vector<vec2<fixed_t>> flow_vectors_fixed;
+    std::vector<int> flow_reach;
     vec2<int> player_start;
+    int init_lives;
     std::string map_name;
     std::vector<Obstacle> obstacles;
-    int currently_active_ob = -1;
+    ObstacleScheduler ob_scheduler;
+    std::vector<FiredExplosion> fired_explosions;
+    ExplosionMask explosion_mask;
     TileManager* tile_manager = nullptr;
+    // published to the render thread through RenderSnapshot
+    std::vector<TileChange> changed_tiles;
+    std::unordered_map<int, size_t> changed_tile_lookup;
+    // change_map_tiles' edits waiting for commit_tile_changes
+    std::vector<TileChange> staged_tiles;
+    std::unordered_map<int, size_t> staged_tile_lookup;
+    std::shared_ptr<const std::vector<TileChange>> tile_changes;
+    std::shared_ptr<const std::vector<Line>> pf_debug_edges;
+    std::shared_ptr<const std::vector<vec2<int>>> pf_debug_nodes;
+    // render thread only: tile_dat as of the last snapshot drawn
+    ChunkedGrid<int> drawn_tile_dat;
+    std::shared_ptr<const std::vector<TileChange>> drawn_tile_changes;
+
+    void update_pathfinding_debug();
+    void load_flow_vectors();
+    FlowTile get_flow_tile(int tile, int x, int y) const;
+    void build_flow_field();
 
 public:
     WorldMap(const std::string& map_filename);
     ~WorldMap();
     vec2<int> get_map_size();
     vec2<int> get_start_pos();
-    vec2<float> get_move_pos(const vec2<float>& position, const vec2<float>& goal_position);
-    vec2<float> get_scrolled_pos(const vec2<float>& position);
+    int get_init_lives();
+    vec2<int> get_revive_pos(int ob_num);
+    int get_location_id(int ob_num, int loc_num);
+    bool is_valid_position(const vec2<float>& position, float radius = PLAYER_RADIUS);
+    vec2<float> get_move_pos(const vec2<float>& position, const vec2<float>& goal_position, float radius = PLAYER_RADIUS);
+    vec2<fixed_t> get_move_pos_fixed(const vec2<fixed_t>& position, const vec2<fixed_t>& goal_position, fixed_t radius);
+    void apply_scroll(int num_units, float* pos_x, float* pos_y, const float* radii, const uint8_t* active, uint8_t* scrolled);
+    void apply_scroll_fixed(int num_units, fixed_t* pos_x, fixed_t* pos_y, const fixed_t* radii, const uint8_t* active, uint8_t* scrolled);
+    void add_unit_radius(float radius);
+    void prefetch_chunks(const UnitPool& units);
+    ChunkStats get_chunk_stats() const;
     void change_map_tiles(const std::vector<vec2<int>>& coord_list, const std::vector<int>& tileid_list);
-    void set_current_obstacle(int obnum);
-    std::vector<vec2<int>> pathfind(const vec2<int>& start_pos, const vec2<int>& end_pos);
-    std::vector<Event> tick();
-    void draw(const vec2<int>& offset);
+    void commit_tile_changes(); // once per tick, after everything else
+    void set_current_obstacle(int obnum, int player = 0);
+    void activate_obstacle(int obnum, int player = 0);
+    void deactivate_obstacle(int obnum, int player = 0);
+    void reset_obstacle(int obnum, int player = 0);
+    void pause_obstacle(int obnum, int player = 0);
+    void resume_obstacle(int obnum, int player = 0);
+    // path requests are collected over a tick and resolved together. request_path returns the request's index,
+    // get_path hands back its waypoints after resolve_paths (valid until the next resolve_paths). radius has to
+    // have been through add_unit_radius already, nothing gets built here and a size without a graph gets no path
+    int request_path(const vec2<int>& start_pos, const vec2<int>& end_pos, float radius = PLAYER_RADIUS);
+    void resolve_paths();
+    int get_path(int request, const vec2<int>*& waypoints) const;
+    void tick(EventBus& events);
+    void get_kill_events(const UnitPool& units, std::vector<KillEvent>& out_kills);
+    void fill_snapshot(RenderSnapshot& snapshot) const;
+    void draw(const RenderSnapshot& snapshot, const vec2<int>& offset);
 };
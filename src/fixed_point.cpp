@@ -0,0 +1,119 @@
+#include "fixed_point.h"
+
+#include <cmath>
+
+// round(16384 * sin(2 pi k / 256)) for the first quadrant, baked in so it can't depend on the platform's libm
+static const int QUARTER_SINE[65] = {
+        0,   402,   804,  1205,  1606,  2006,  2404,  2801,
+     3196,  3590,  3981,  4370,  4756,  5139,  5520,  5897,
+     6270,  6639,  7005,  7366,  7723,  8076,  8423,  8765,
+     9102,  9434,  9760, 10080, 10394, 10702, 11003, 11297,
+    11585, 11866, 12140, 12406, 12665, 12916, 13160, 13395,
+    13623, 13842, 14053, 14256, 14449, 14635, 14811, 14978,
+    15137, 15286, 15426, 15557, 15679, 15791, 15893, 15986,
+    16069, 16143, 16207, 16261, 16305, 16340, 16364, 16379,
+    16384,
+};
+
+fixed_t float_to_fixed(float f) {
+    return static_cast<fixed_t>(std::lround(f * FIXED_ONE));
+}
+
+float fixed_to_float(fixed_t f) {
+    return static_cast<float>(f) / FIXED_ONE;
+}
+
+int fixed_to_int(fixed_t f) {
+    return f >= 0 ? f >> FIXED_SHIFT : -((-f + FIXED_ONE - 1) >> FIXED_SHIFT);
+}
+
+int direction_sin(int direction) {
+    direction &= NUM_DIRECTIONS - 1;
+    int quadrant = direction >> 6;
+    int k = direction & 63;
+    switch (quadrant) {
+        case 0: return QUARTER_SINE[k];
+        case 1: return QUARTER_SINE[64 - k];
+        case 2: return -QUARTER_SINE[k];
+        default: return -QUARTER_SINE[64 - k];
+    }
+}
+
+int direction_cos(int direction) {
+    return direction_sin(direction + 64);
+}
+
+// where the directions within an octant change over: round(65536 * tan((k + 0.5) * 2 pi / 256)), k = 0..31
+static const int OCTANT_TAN_BOUNDARIES[32] = {
+      804,  2414,  4026,  5644,  7268,  8901, 10545, 12202,
+    13874, 15564, 17273, 19005, 20762, 22546, 24360, 26208,
+    28093, 30018, 31986, 34002, 36071, 38196, 40382, 42636,
+    44963, 47369, 49863, 52451, 55144, 57950, 60880, 63947,
+};
+
+// direction (0..32) for every ratio minor / major = r / ATAN_TABLE_SIZE of the first octant, filled in once from
+// the boundaries above with integer math only
+struct AtanTable {
+    uint8_t directions[ATAN_TABLE_SIZE + 1];
+
+    AtanTable() {
+        int k = 0;
+        for (int r = 0; r <= ATAN_TABLE_SIZE; ++r) {
+            while (k < 32 && OCTANT_TAN_BOUNDARIES[k] < r * (65536 / ATAN_TABLE_SIZE))
+                k += 1;
+            directions[r] = k;
+        }
+    }
+};
+
+static const AtanTable ATAN_TABLE;
+
+// fold into the first octant, look the angle up, unfold
+int get_direction(int64_t dx, int64_t dy) {
+    int64_t ux = dx;
+    int64_t uy = -dy;
+    int64_t ax = ux < 0 ? -ux : ux;
+    int64_t ay = uy < 0 ? -uy : uy;
+    if (ax == 0 && ay == 0)
+        return 0;
+    int k; // angle of (ax, ay), 0..64
+    if (ax >= ay)
+        k = ATAN_TABLE.directions[(ay * ATAN_TABLE_SIZE + ax / 2) / ax];
+    else
+        k = 64 - ATAN_TABLE.directions[(ax * ATAN_TABLE_SIZE + ay / 2) / ay];
+    if (ux < 0)
+        k = 128 - k;
+    if (uy < 0)
+        k = -k;
+    return k & (NUM_DIRECTIONS - 1);
+}
+
+int direction_diff(int from, int to) {
+    int d = (to - from) & (NUM_DIRECTIONS - 1);
+    return d >= NUM_DIRECTIONS / 2 ? d - NUM_DIRECTIONS : d;
+}
+
+float direction_to_degrees(int direction) {
+    return (direction & (NUM_DIRECTIONS - 1)) * (360.0f / NUM_DIRECTIONS);
+}
+
+int degrees_to_direction(float degrees) {
+    return static_cast<int>(std::lround(degrees * (NUM_DIRECTIONS / 360.0f))) & (NUM_DIRECTIONS - 1);
+}
+
+uint32_t isqrt(uint64_t n) {
+    uint64_t root = 0;
+    uint64_t bit = uint64_t(1) << 62;
+    while (bit > n)
+        bit >>= 2;
+    while (bit != 0) {
+        if (n >= root + bit) {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+            root >>= 1;
+        bit >>= 2;
+    }
+    return static_cast<uint32_t>(root);
+}
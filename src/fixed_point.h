@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+
+//
+// integer math for the fixed point sim mode (UnitPool with fixed_point = true). everything in here is exact
+// integer arithmetic, so nothing depends on libm or on how the compiler rounds floats, unlike atan2/fmod.
+// positions are 24.8 (1/256 px), headings are one of 256 directions like the original engine: 0 = east,
+// 64 = north (up the screen), 128 = west, 192 = south.
+//
+typedef int32_t fixed_t;
+
+static const int FIXED_SHIFT = 8;
+static const fixed_t FIXED_ONE = 1 << FIXED_SHIFT;
+
+static const int NUM_DIRECTIONS = 256;
+static const int DIRECTION_SHIFT = 14; // direction_cos/direction_sin are scaled by 1 << 14
+static const int ATAN_TABLE_SIZE = 1024; // get_direction's table, per octant
+
+fixed_t float_to_fixed(float f);  // nearest
+float fixed_to_float(fixed_t f);  // exact for everything inside a 4096x4096 tile map
+int fixed_to_int(fixed_t f);      // floor
+int direction_cos(int direction);
+int direction_sin(int direction); // y up, like the angles elsewhere
+int get_direction(int64_t dx, int64_t dy); // direction of (dx, dy) in screen coordinates (y down), replaces atan2
+int direction_diff(int from, int to);      // signed, in [-128, 127]
+float direction_to_degrees(int direction);
+int degrees_to_direction(float degrees);
+uint32_t isqrt(uint64_t n);                // floor(sqrt(n))
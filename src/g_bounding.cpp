@@ -3,12 +3,19 @@
 
 #include "globals.h"
 #include "misc_gfx.h"
+#include "Profiler.h"
 #include "Vec2.h"
 
 G_Bounding::G_Bounding(Game* game, const std::string& map_filename) {
     world_map = new WorldMap(map_filename);
     vec2<int> mapsize = world_map->get_map_size();
-    player = new Mauzling(world_map->get_start_pos(), "assets/sq16.png");
+    units = new UnitPool(game->sim_options.fixed_point);
+    units->add_unit(world_map->get_start_pos(), PLAYER_RADIUS);
+    world_map->add_unit_radius(PLAYER_RADIUS);
+    unit_graphics = new MauzlingGraphics("assets/sq16.png", PLAYER_RADIUS);
+    unit_grid = new UnitGrid();
+    lives = world_map->get_init_lives();
+    unit_grid->rebuild(*units);
     //
     game->reset_camera_pos({0,0}); // change to start player coordinates?
     game->set_camera_bounds({0, mapsize.x}, {0, mapsize.y});
@@ -16,11 +23,13 @@ G_Bounding::G_Bounding(Game* game, const std::string& map_filename) {
 
 G_Bounding::~G_Bounding() {
     delete world_map;
-    delete player;
-    delete most_recent_order;
+    delete units;
+    delete unit_graphics;
+    delete unit_grid;
     world_map = nullptr;
-    player = nullptr;
-    most_recent_order = nullptr;
+    units = nullptr;
+    unit_graphics = nullptr;
+    unit_grid = nullptr;
 }
 
 void G_Bounding::update(Game* game, PlayerInputs* inputs) {
@@ -40,24 +49,68 @@ void G_Bounding::update(Game* game, PlayerInputs* inputs) {
             int boxsize = std::abs(selection_box.size.x) + std::abs(selection_box.size.y);
             vec2<int> release_pos = selection_box.position + selection_box.size;
             if (boxsize <= SELECTION_BOX_AS_CLICK)
-                player->check_selection_click(release_pos);
+                push_command({BoundingCommandType::SELECT_POINT, release_pos, release_pos, false});
             else
-                player->check_selection_box(selection_box.position, release_pos);
+                push_command({BoundingCommandType::SELECT_BOX, selection_box.position, release_pos, false});
         }
         drawing_box = false;
     }
     if (inputs->rightmouse_up)
         rightmouse_was_up = true;
     if (inputs->rightmouse_down && rightmouse_was_up) {
-        most_recent_order = new PlayerOrder();
-        most_recent_order->coordinates = mouse_pos;
-        most_recent_order->is_queue = inputs->key_shift;
+        push_command({BoundingCommandType::ORDER, mouse_pos, mouse_pos, inputs->key_shift});
         rightmouse_was_up = false;
     }
 }
 
-std::vector<Event> G_Bounding::tick(Game* game) {
-    std::vector<Event> out_events;
+void G_Bounding::push_command(const BoundingCommand& command) {
+    std::lock_guard<std::mutex> lock(command_mutex);
+    pending_commands.push_back(command);
+}
+
+void G_Bounding::run_command(Game* game, const BoundingCommand& command) {
+    switch (command.type) {
+        case BoundingCommandType::SELECT_POINT:
+            unit_grid->query_point(command.position, CLICKSELECTION_VEC2, query_results);
+            select_units(query_results);
+            break;
+        case BoundingCommandType::SELECT_BOX:
+            unit_grid->query_rect(command.position, command.position_2, query_results);
+            select_units(query_results);
+            break;
+        case BoundingCommandType::ORDER: {
+            bool animate_cursor = false;
+            for (int i : selected_units) {
+                if (Mauzling(units, i).issue_new_order(command.position, command.is_queue))
+                    animate_cursor = true;
+            }
+            if (animate_cursor)
+                game->cursor_click_animation(command.is_queue);
+            break;
+        }
+    }
+}
+
+// dead units keep whatever selection state they had, everyone else is selected iff they're in unit_ids
+void G_Bounding::select_units(const std::vector<int>& unit_ids) {
+    std::vector<int> still_selected;
+    for (int i : selected_units) {
+        if (units->get_state(i) == PlayerState::DEAD)
+            still_selected.push_back(i);
+        else
+            units->set_selected(i, false);
+    }
+    for (int i : unit_ids) {
+        if (units->get_state(i) != PlayerState::DEAD && !units->get_selected(i)) {
+            units->set_selected(i, true);
+            still_selected.push_back(i);
+        }
+    }
+    selected_units.swap(still_selected);
+}
+
+void G_Bounding::tick(Game* game, EventBus& events) {
+    PROFILE_ZONE("G_Bounding::tick");
     //
     // DEBUG / TESTING STUFF
     //
@@ -90,31 +143,70 @@ std::vector<Event> G_Bounding::tick(Game* game) {
         world_map->set_current_obstacle(-1);
     }
     //
-    std::vector<Event> worldmap_events = world_map->tick();
-    for (auto event : worldmap_events)
-        out_events.push_back(event);
+    world_map->tick(events);
+    //
+    // deaths: revive at the obstacle's revive point while we still have lives left
+    //
+    world_map->get_kill_events(*units, kill_events);
+    for (const KillEvent& kill : kill_events) {
+        events.push(EventType::UNIT_KILLED, kill.unit_id, world_map->get_location_id(kill.ob_num, kill.loc_num), units->get_position(kill.unit_id));
+        lives = std::max(lives - 1, 0);
+        if (lives > 0)
+            units->revive_unit(kill.unit_id, world_map->get_revive_pos(kill.ob_num));
+        else
+            units->kill_unit(kill.unit_id);
+        printf("unit %i killed by location %i-%i, %i lives left\n", kill.unit_id, kill.ob_num, kill.loc_num, lives);
+    }
+    //
+    // selections and orders from the render thread
     //
-    // issue order
+    {
+        std::lock_guard<std::mutex> lock(command_mutex);
+        commands_to_run.swap(pending_commands);
+    }
+    for (const BoundingCommand& command : commands_to_run)
+        run_command(game, command);
+    commands_to_run.clear();
     //
-    if (most_recent_order != nullptr) {
-        bool animate_cursor = player->issue_new_order(most_recent_order->coordinates, most_recent_order->is_queue);
-        if (animate_cursor)
-            game->cursor_click_animation(most_recent_order->is_queue);
-        delete most_recent_order;
-        most_recent_order = nullptr;
+    prev_positions.resize(units->size());
+    for (int i = 0; i < units->size(); ++i)
+        prev_positions[i] = units->get_position(i);
+    world_map->prefetch_chunks(*units);
+    units->tick(world_map);
+    {
+        PROFILE_ZONE("UnitGrid::rebuild");
+        unit_grid->rebuild(*units);
     }
-    player->tick(world_map);
+    // this tick's tile changes, all at once now that nothing else reads the map until the next one
+    world_map->commit_tile_changes();
     //
+    if (game->sim_options.log_hashes)
+        printf("tick %i lives %i hash %016llx\n", ingame_ticks, lives, static_cast<unsigned long long>(units->get_state_hash()));
     ingame_ticks += 1;
+}
 
-    return out_events;
+void G_Bounding::fill_snapshot(Game*, RenderSnapshot& snapshot) {
+    world_map->fill_snapshot(snapshot);
+    snapshot.units.resize(units->size());
+    for (int i = 0; i < units->size(); ++i) {
+        vec2<float> position = units->get_position(i);
+        vec2<float> prev_position = i < static_cast<int>(prev_positions.size()) ? prev_positions[i] : position;
+        snapshot.units[i] = {prev_position, position, units->get_angle(i), units->get_radius(i), units->get_selected(i)};
+    }
 }
 
-void G_Bounding::draw(Game* game) {
+void G_Bounding::draw(Game* game, const RenderSnapshot& snapshot, float alpha) {
     vec2<int> camera_pos = game->get_camera_pos();
-    world_map->draw(camera_pos);
-    player->draw(camera_pos);
-    game->animation_manager.draw(camera_pos); // draw sprites on top of player, but not on top of selection box
+    world_map->draw(snapshot, camera_pos);
+    {
+        PROFILE_ZONE("draw units");
+        for (const UnitSnapshot& unit : snapshot.units)
+            unit_graphics->draw(unit, alpha, camera_pos);
+    }
+    {
+        PROFILE_ZONE("draw animations");
+        game->animation_manager.draw(snapshot.animations, camera_pos); // draw sprites on top of player, but not on top of selection box
+    }
     if (drawing_box) {
         Rect offset_box = {selection_box.position - camera_pos, selection_box.size};
         //draw_rect(offset_box, SELECTION_BOX_COL);
@@ -1,28 +1,63 @@
 #pragma once
+#include <mutex>
+#include <vector>
 
 #include "g_gamestate.h"
 
 #include "geometry.h"
 #include "Mauzling.h"
+#include "UnitGrid.h"
+#include "UnitPool.h"
 #include "WorldMap.h"
 
 // if size of selection box is smaller than this, interpret it as a single click
 static const int SELECTION_BOX_AS_CLICK = 16;
 
+struct BoundingCommandType {
+    static const int SELECT_POINT = 0;
+    static const int SELECT_BOX = 1;
+    static const int ORDER = 2;
+};
+
+// queued up by update (render thread) and carried out in order at the start of the next tick (sim thread)
+struct BoundingCommand {
+    int type;
+    vec2<int> position;
+    vec2<int> position_2; // other corner of the selection box
+    bool is_queue;
+};
+
 class G_Bounding : public GameState {
 private:
+    // sim thread
     WorldMap* world_map = nullptr;
-    Mauzling* player = nullptr;
+    UnitPool* units = nullptr;
+    UnitGrid* unit_grid = nullptr;
+    std::vector<int> selected_units;
+    std::vector<int> query_results;
+    std::vector<KillEvent> kill_events;
+    std::vector<vec2<float>> prev_positions;
+    std::vector<BoundingCommand> commands_to_run;
+    int lives = 0;
+    int ingame_ticks = 0;
+    // shared
+    std::mutex command_mutex;
+    std::vector<BoundingCommand> pending_commands;
+    // render thread
+    MauzlingGraphics* unit_graphics = nullptr;
     bool drawing_box = false;
     Rect selection_box = {{0,0}, {0,0}};
     bool rightmouse_was_up = true;
-    PlayerOrder* most_recent_order = nullptr;
-    int ingame_ticks = 0;
+
+    void push_command(const BoundingCommand& command);
+    void run_command(Game* game, const BoundingCommand& command);
 
 public:
     G_Bounding(Game* game, const std::string& map_filename);
     ~G_Bounding() override;
     void update(Game* game, PlayerInputs* inputs) override;
-    std::vector<Event> tick(Game* game) override;
-    void draw(Game* game) override;
+    void tick(Game* game, EventBus& events) override;
+    void select_units(const std::vector<int>& unit_ids);
+    void fill_snapshot(Game* game, RenderSnapshot& snapshot) override;
+    void draw(Game* game, const RenderSnapshot& snapshot, float alpha) override;
 };
@@ -3,19 +3,25 @@
 #include "g_mainmenu.h"
 #include "g_bounding.h"
 
+#include <algorithm>
+
+#include "geometry.h"
 #include "globals.h"
+#include "Profiler.h"
 
-Game::Game() : current_state(new G_MainMenu()) {
+Game::Game(AssetLoader& loader) : current_state(new G_MainMenu()), animation_manager(texture_atlas) {
     camera = new Camera();
     camera->set_bounds({0, RESOLUTION.x}, {0, RESOLUTION.y});
-    cursor = new Cursor({"assets/cursor_0.png",
+    int explosion = loader.load_spritesheet("assets/M484explosionset1.png", {34,34});
+    cursor = new Cursor(loader,
+                        {"assets/cursor_0.png",
                          "assets/cursor_1.png",
                          "assets/cursor_2.png",
                          "assets/cursor_3.png",
                          "assets/cursor_4.png"},
                          "assets/cursor_click.png",
                          "assets/cursor_shiftclick.png");
-    animation_manager.add_animation("small_blue", "assets/M484explosionset1.png", {34,34});
+    animation_manager.add_animation("small_blue", loader.take(explosion));
 }
 
 Game::~Game() {
@@ -25,34 +31,88 @@ Game::~Game() {
     cursor = nullptr;
 }
 
+// takes effect at the end of the current update (states usually call this from their own update)
 void Game::change_state(std::unique_ptr<GameState> new_state) {
-    current_state = std::move(new_state);
+    pending_state = std::move(new_state);
 }
 
 void Game::update(PlayerInputs* inputs, double frame_time) {
+    PROFILE_ZONE("Game::update");
     camera->nudge_target(inputs->move_up, inputs->move_down, inputs->move_left, inputs->move_right, frame_time);
     camera->update(frame_time);
     cursor->update({inputs->mouse_x, inputs->mouse_y});
     current_state->update(this, inputs);
+    if (pending_state) {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        current_state = std::move(pending_state);
+        state_serial += 1;
+    }
 }
 
+// one simulation tick, then publish what it looks like for the render thread
 void Game::tick(){
-    cursor->tick();
-    std::vector<Event> state_events = current_state->tick(this);
-    for (auto event : state_events){
-        //printf("RAWR %s \n", event.type.c_str());
-        if (event.type == "start_animation") {
-            animation_manager.start_new_animation(event.data_str , event.data_str_2, event.data_vec, false, true);
+    std::lock_guard<std::mutex> lock(state_mutex);
+    double start_time = get_precise_time();
+    {
+        PROFILE_ZONE("Game::tick");
+        event_bus.clear();
+        current_state->tick(this, event_bus);
+        for (size_t i = 0; i < event_bus.size(); ++i) {
+            const Event& event = event_bus[i];
+            switch (event.type) {
+                case EventType::START_ANIMATION:
+                    animation_manager.start_new_animation(event.data_id, event.data_id_2, event.data_vec, false, true);
+                    break;
+                default:
+                    break;
+            }
         }
+        animation_manager.tick();
+        current_tick += 1;
     }
-    animation_manager.tick();
+    PROFILE_ZONE("Game::fill_snapshot");
+    RenderSnapshot& snapshot = snapshots.get_write_buffer();
+    snapshot.tick = current_tick;
+    snapshot.state_serial = state_serial;
+    snapshot.num_cursor_clicks = num_cursor_clicks;
+    snapshot.last_click_is_queue = last_click_is_queue;
+    animation_manager.fill_snapshot(snapshot.animations);
+    snapshot.units.clear();
+    snapshot.active_obstacles.clear();
+    snapshot.tile_changes.reset();
+    snapshot.pf_debug_edges.reset();
+    snapshot.pf_debug_nodes.reset();
+    current_state->fill_snapshot(this, snapshot);
+    snapshot.tick_time = get_precise_time();
+    snapshot.tick_ms = 1000.0 * (snapshot.tick_time - start_time);
+    snapshots.publish();
 }
 
+// draws the latest published tick, with units interpolated from where they were on the tick before
 void Game::draw() {
-    current_state->draw(this);
+    snapshots.update_read_buffer();
+    const RenderSnapshot& snapshot = snapshots.get_read_buffer();
+    // cursor animations run at the tick rate, so catch up on however many ticks happened since the last frame
+    int new_ticks = std::min(snapshot.tick - last_drawn_tick, MAX_UPDATE_FRAMES);
+    for (int i = 0; i < new_ticks; ++i)
+        cursor->tick();
+    last_drawn_tick = snapshot.tick;
+    if (snapshot.num_cursor_clicks != seen_cursor_clicks) {
+        cursor->start_click_animation(snapshot.last_click_is_queue);
+        seen_cursor_clicks = snapshot.num_cursor_clicks;
+    }
+    //
+    float alpha = value_clamp(static_cast<float>((get_precise_time() - snapshot.tick_time) / DT), 0.0f, 1.0f);
+    if (snapshot.state_serial == state_serial)
+        current_state->draw(this, snapshot, alpha);
+    PROFILE_ZONE("draw cursor");
     cursor->draw();
 }
 
+const RenderSnapshot& Game::get_drawn_snapshot() {
+    return snapshots.get_read_buffer();
+}
+
 vec2<int> Game::get_camera_pos() {
     if (camera != nullptr)
         return camera->get_pos();
@@ -71,9 +131,10 @@ vec2<int> Game::get_cursor_pos() {
     return {0,0};
 }
 
+// called from the sim thread, the render thread starts the animation when it sees the next snapshot
 void Game::cursor_click_animation(bool is_queue) {
-    if (cursor != nullptr)
-        cursor->start_click_animation(is_queue);
+    num_cursor_clicks += 1;
+    last_click_is_queue = is_queue;
 }
 
 void Game::reset_camera_pos(const vec2<float>& target_pos) {
@@ -1,29 +1,59 @@
 #pragma once
 #include <memory>
+#include <mutex>
 
 #include "AnimationManager.h"
+#include "AssetLoader.h"
 #include "Camera.h"
 #include "Cursor.h"
+#include "EventBus.h"
 #include "inputs.h"
+#include "RenderSnapshot.h"
+#include "TripleBuffer.h"
 #include "Vec2.h"
 
 class GameState;
 
+// picked on the command line, read by the game states when they set up their sim
+struct SimOptions {
+    bool fixed_point = false; // deterministic integer sim (see UnitPool), --fixed-point
+    bool log_hashes = false;  // print a state hash every tick, --sim-hashes
+};
+
+//
+// update/draw are called from the render thread and tick from the sim thread (or all of them from the one
+// thread on wasm). camera and cursor belong to the render thread, the sim hands everything else over in
+// RenderSnapshots.
+//
 class Game {
 private:
     std::unique_ptr<GameState> current_state;
+    std::unique_ptr<GameState> pending_state;
+    std::mutex state_mutex;             // held for a whole tick, and while swapping in pending_state
+    int state_serial = 0;
     Camera* camera = nullptr;
     Cursor* cursor = nullptr;
+    EventBus event_bus;
+    TripleBuffer<RenderSnapshot> snapshots;
+    // sim thread
+    int current_tick = 0;
+    int num_cursor_clicks = 0;
+    bool last_click_is_queue = false;
+    // render thread
+    int last_drawn_tick = 0;
+    int seen_cursor_clicks = 0;
 
 public:
     AnimationManager animation_manager;
-    
-    Game();
+    SimOptions sim_options;
+
+    explicit Game(AssetLoader& loader);
     ~Game();
     void change_state(std::unique_ptr<GameState> new_state);
     void update(PlayerInputs* inputs, double frame_time);
     void tick();
     void draw();
+    const RenderSnapshot& get_drawn_snapshot();
     vec2<int> get_camera_pos();
     vec2<int> get_camera_target();
     vec2<int> get_cursor_pos();
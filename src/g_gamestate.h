@@ -1,15 +1,22 @@
 #pragma once
 #include <vector>
 
+#include "EventBus.h"
 #include "globals.h"
 #include "inputs.h"
+#include "RenderSnapshot.h"
 
 class Game;
 
+//
+// update and draw run on the render thread, tick and fill_snapshot on the sim thread. the two sides only talk
+// through the RenderSnapshot (sim -> render) and whatever commands update queues up for the next tick.
+//
 class GameState {
 public:
     virtual void update(Game* game, PlayerInputs* inputs) = 0;
-    virtual std::vector<Event> tick(Game* game) = 0;
-    virtual void draw(Game* game) = 0;
+    virtual void tick(Game* game, EventBus& events) = 0;
+    virtual void fill_snapshot(Game* game, RenderSnapshot& snapshot) = 0;
+    virtual void draw(Game* game, const RenderSnapshot& snapshot, float alpha) = 0;
     virtual ~GameState() = default;
 };
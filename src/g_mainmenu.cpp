@@ -24,11 +24,14 @@ void G_MainMenu::update(Game* game, PlayerInputs* inputs) {
     }
 }
 
-std::vector<Event> G_MainMenu::tick(Game* game) {
-    std::vector<Event> out_events;
-    return out_events;
+void G_MainMenu::tick(Game* game, EventBus& events) {
+    //
+}
+
+void G_MainMenu::fill_snapshot(Game* game, RenderSnapshot& snapshot) {
+    //
 }
 
-void G_MainMenu::draw(Game* game) {
+void G_MainMenu::draw(Game* game, const RenderSnapshot& snapshot, float alpha) {
     //
 }
@@ -13,6 +13,7 @@ public:
     G_MainMenu();
     ~G_MainMenu() override;
     void update(Game* game, PlayerInputs* inputs) override;
-    std::vector<Event> tick(Game* game) override;
-    void draw(Game* game) override;
+    void tick(Game* game, EventBus& events) override;
+    void fill_snapshot(Game* game, RenderSnapshot& snapshot) override;
+    void draw(Game* game, const RenderSnapshot& snapshot, float alpha) override;
 };
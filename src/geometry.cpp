@@ -1,9 +1,17 @@
 #include "geometry.h"
 
-std::vector<vec2<int>> dda_grid_traversal(float x1, float y1, float x2, float y2) {
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "ChunkedGrid.h"
+
+// walks the tiles from (x1,y1) to (x2,y2) (not counting the first), calling visit(voxel) on each until it returns false.
+// returns false if visit did
+template <typename Visit>
+static bool walk_grid_traversal(float x1, float y1, float x2, float y2, Visit visit) {
     float tMaxX, tMaxY, tDeltaX, tDeltaY;
     vec2<int> voxel;
-    std::vector<vec2<int>> out_voxels;
 
     int dx = SIGN(x2 - x1);
     if (dx != 0)
@@ -28,7 +36,7 @@ std::vector<vec2<int>> dda_grid_traversal(float x1, float y1, float x2, float y2
     voxel.y = static_cast<int>(y1);
 
     // uncomment this to apply checks to starting tile
-    //out_voxels.push_back(voxel);
+    //if (!visit(voxel)) return false;
 
     while (true) {
         if (tMaxX < tMaxY) {
@@ -41,18 +49,154 @@ std::vector<vec2<int>> dda_grid_traversal(float x1, float y1, float x2, float y2
         }
         if (tMaxX > 1 && tMaxY > 1)
             break;
-        out_voxels.push_back(voxel);
+        if (!visit(voxel))
+            return false;
     }
+    return true;
+}
+
+std::vector<vec2<int>> dda_grid_traversal(float x1, float y1, float x2, float y2) {
+    std::vector<vec2<int>> out_voxels;
+    walk_grid_traversal(x1, y1, x2, y2, [&out_voxels](const vec2<int>& voxel) {
+        out_voxels.push_back(voxel);
+        return true;
+    });
     return out_voxels;
 }
 
-bool points_are_visible_to_eachother(const vec2<float>& p1, const vec2<float>& p2, const Array2D<bool>& wall_dat) {
-    std::vector<vec2<int>> voxels = dda_grid_traversal(p1.x, p1.y, p2.x, p2.y);
-    for (size_t i = 0; i < voxels.size(); ++i) {
-        if (wall_dat[voxels[i].x][voxels[i].y])
-            return false;
+// walks the dda in place, nothing gets allocated per ray
+template <typename WallGrid>
+bool points_are_visible_to_eachother(const vec2<float>& p1, const vec2<float>& p2, const WallGrid& wall_dat) {
+    return walk_grid_traversal(p1.x, p1.y, p2.x, p2.y, [&wall_dat](const vec2<int>& voxel) {
+        return !wall_dat[voxel.x][voxel.y];
+    });
+}
+
+template bool points_are_visible_to_eachother(const vec2<float>&, const vec2<float>&, const Array2D<bool>&);
+template bool points_are_visible_to_eachother(const vec2<float>&, const vec2<float>&, const ChunkedGrid<bool>&);
+template bool points_are_visible_to_eachother(const vec2<float>&, const vec2<float>&, const WallBits&);
+
+//
+// batched line of sight: LOS_BATCH copies of the dda above, one per lane, all starting from the same tile. every
+// step moves each active lane one tile with exactly the float ops dda_grid_traversal does (so the same tiles come
+// up), then reads the wall bit under every lane. a lane stops when it hits a wall or passes its target, and then
+// starts over on the next target that hasn't had a lane yet
+//
+
+struct RayLanes {
+    alignas(16) float tmax_x[LOS_BATCH];
+    alignas(16) float tmax_y[LOS_BATCH];
+    alignas(16) float tdelta_x[LOS_BATCH];
+    alignas(16) float tdelta_y[LOS_BATCH];
+    alignas(16) int32_t dx[LOS_BATCH];
+    alignas(16) int32_t dy[LOS_BATCH];
+    alignas(16) int32_t voxel_x[LOS_BATCH];
+    alignas(16) int32_t voxel_y[LOS_BATCH];
+    alignas(16) int32_t active[LOS_BATCH];  // -1 while the lane is still stepping, 0 after
+};
+
+// one dda step for every active lane, then drops the lanes that went past their target
+static void step_rays(RayLanes& r) {
+    int l = 0;
+#ifdef __SSE2__
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (; l + 4 <= LOS_BATCH; l += 4) {
+        __m128 tmax_x = _mm_load_ps(r.tmax_x + l);
+        __m128 tmax_y = _mm_load_ps(r.tmax_y + l);
+        __m128i active = _mm_load_si128(reinterpret_cast<const __m128i*>(r.active + l));
+        __m128i x_first = _mm_castps_si128(_mm_cmplt_ps(tmax_x, tmax_y));
+        __m128i step_x = _mm_and_si128(x_first, active);
+        __m128i step_y = _mm_andnot_si128(x_first, active);
+        tmax_x = _mm_add_ps(tmax_x, _mm_and_ps(_mm_castsi128_ps(step_x), _mm_load_ps(r.tdelta_x + l)));
+        tmax_y = _mm_add_ps(tmax_y, _mm_and_ps(_mm_castsi128_ps(step_y), _mm_load_ps(r.tdelta_y + l)));
+        __m128i voxel_x = _mm_add_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(r.voxel_x + l)),
+                                        _mm_and_si128(step_x, _mm_load_si128(reinterpret_cast<const __m128i*>(r.dx + l))));
+        __m128i voxel_y = _mm_add_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(r.voxel_y + l)),
+                                        _mm_and_si128(step_y, _mm_load_si128(reinterpret_cast<const __m128i*>(r.dy + l))));
+        __m128 past_target = _mm_and_ps(_mm_cmpgt_ps(tmax_x, one), _mm_cmpgt_ps(tmax_y, one));
+        active = _mm_andnot_si128(_mm_castps_si128(past_target), active);
+        _mm_store_ps(r.tmax_x + l, tmax_x);
+        _mm_store_ps(r.tmax_y + l, tmax_y);
+        _mm_store_si128(reinterpret_cast<__m128i*>(r.voxel_x + l), voxel_x);
+        _mm_store_si128(reinterpret_cast<__m128i*>(r.voxel_y + l), voxel_y);
+        _mm_store_si128(reinterpret_cast<__m128i*>(r.active + l), active);
+    }
+#endif
+    // everything without sse2 (wasm)
+    for (; l < LOS_BATCH; ++l) {
+        int32_t x_first = r.tmax_x[l] < r.tmax_y[l] ? -1 : 0;
+        int32_t step_x = x_first & r.active[l];
+        int32_t step_y = ~x_first & r.active[l];
+        r.tmax_x[l] += step_x ? r.tdelta_x[l] : 0.0f;
+        r.tmax_y[l] += step_y ? r.tdelta_y[l] : 0.0f;
+        r.voxel_x[l] += step_x & r.dx[l];
+        r.voxel_y[l] += step_y & r.dy[l];
+        if (r.tmax_x[l] > 1 && r.tmax_y[l] > 1)
+            r.active[l] = 0;
+    }
+}
+
+void visible_from(const vec2<float>& origin, const vec2<float>* targets, int num_targets, const WallBits& walls, uint8_t* out_mask) {
+    if (num_targets <= 0)
+        return;
+    // the parts of dda_grid_traversal's setup that only depend on the origin
+    float frac0_x = FRAC0(origin.x);
+    float frac1_x = FRAC1(origin.x);
+    float frac0_y = FRAC0(origin.y);
+    float frac1_y = FRAC1(origin.y);
+    int32_t origin_x = static_cast<int>(origin.x);
+    int32_t origin_y = static_cast<int>(origin.y);
+
+    RayLanes r;
+    int lane_target[LOS_BATCH];
+    int next_target = 0;
+    int num_active = 0;
+    // a lane that's done takes the next target right away, so no lane idles waiting on a longer ray
+    auto load_lane = [&](int l) {
+        if (next_target == num_targets) {
+            lane_target[l] = -1;
+            r.active[l] = 0;
+            r.voxel_x[l] = origin_x;
+            r.voxel_y[l] = origin_y;
+            num_active -= 1;
+            return;
+        }
+        vec2<float> target = targets[next_target];
+        lane_target[l] = next_target++;
+        int dx = SIGN(target.x - origin.x);
+        r.tdelta_x[l] = dx != 0 ? fmin(dx / (target.x - origin.x), 10000000.0f) : 10000000.0f;
+        r.tmax_x[l] = r.tdelta_x[l] * (dx > 0 ? frac1_x : frac0_x);
+        int dy = SIGN(target.y - origin.y);
+        r.tdelta_y[l] = dy != 0 ? fmin(dy / (target.y - origin.y), 10000000.0f) : 10000000.0f;
+        r.tmax_y[l] = r.tdelta_y[l] * (dy > 0 ? frac1_y : frac0_y);
+        r.dx[l] = dx;
+        r.dy[l] = dy;
+        r.voxel_x[l] = origin_x;
+        r.voxel_y[l] = origin_y;
+        r.active[l] = -1;
+    };
+    num_active = LOS_BATCH;
+    for (int l = 0; l < LOS_BATCH; ++l) {
+        r.tdelta_x[l] = r.tdelta_y[l] = r.tmax_x[l] = r.tmax_y[l] = 0.0f;
+        r.dx[l] = r.dy[l] = 0;
+        load_lane(l);
+    }
+    while (num_active > 0) {
+        step_rays(r);
+        for (int l = 0; l < LOS_BATCH; ++l) {
+            if (lane_target[l] < 0)
+                continue;
+            // passed its target without meeting a wall
+            if (!r.active[l]) {
+                out_mask[lane_target[l]] = 1;
+                load_lane(l);
+            }
+            else if (walls.get(r.voxel_x[l], r.voxel_y[l])) {
+                out_mask[lane_target[l]] = 0;
+                load_lane(l);
+            }
+        }
     }
-    return true;
 }
 
 int cross(const vec2<int>& a, const vec2<int>& b) {
@@ -1,8 +1,10 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 
 #include "Array2D.h"
 #include "Vec2.h"
+#include "WallBits.h"
 
 struct Line {
     vec2<int> start;
@@ -25,9 +27,14 @@ struct FRect {
 };
 
 const vec2<int> NULL_VEC = {-99999, -99999};
+static const int LOS_BATCH = 8;
 
 std::vector<vec2<int>> dda_grid_traversal(float x1, float y1, float x2, float y2);
-bool points_are_visible_to_eachother(const vec2<float>& p1, const vec2<float>& p2, const Array2D<bool>& wall_dat);
+template <typename WallGrid> // Array2D<bool>, ChunkedGrid<bool> or WallBits
+bool points_are_visible_to_eachother(const vec2<float>& p1, const vec2<float>& p2, const WallGrid& wall_dat);
+// points_are_visible_to_eachother from one origin to num_targets targets, LOS_BATCH rays stepped in lockstep,
+// a finished lane takes the next target. out_mask[i] = 1 if targets[i] is visible
+void visible_from(const vec2<float>& origin, const vec2<float>* targets, int num_targets, const WallBits& walls, uint8_t* out_mask);
 int cross(const vec2<int>& a, const vec2<int>& b);
 bool points_are_collinear(const vec2<int>& a, const vec2<int>& b, const vec2<int>& c);
 bool point_is_on_line_segment(const vec2<int>& p, const Line& line);
@@ -1,15 +1,21 @@
 #pragma once
+#include <cstdint>
 #include <string>
 
 #include <SDL.h>
 
 #include "Vec2.h"
 
-// general purpose struct for event messages
+enum class EventType : uint8_t {
+    START_ANIMATION,  // data_id: animation name, data_id_2: location, data_vec: centered position
+    UNIT_KILLED       // data_id: unit, data_id_2: location, data_vec: where it died
+};
+
+// general purpose struct for event messages. names are interned (see EventBus.h) so this stays POD
 struct Event {
-    std::string type;
-    std::string data_str;
-    std::string data_str_2;
+    EventType type;
+    int data_id;
+    int data_id_2;
     vec2<int> data_vec;
 };
 
@@ -17,6 +23,7 @@ const double TICRATE = 23.8095;
 const int MAX_UPDATE_FRAMES = 8;
 const double DT = 1.0 / TICRATE;
 const double MAX_ACCUM = MAX_UPDATE_FRAMES / TICRATE;
+const double DEFAULT_TARGET_FPS = 144.0; // native frame limiter, override with --fps (0 = unlimited)
 
 const vec2<int> RESOLUTION = {960, 540};
 const int GRIDSIZE = 16;
@@ -51,3 +58,8 @@ const SDL_Color OB_STARTBOX_COL = {100, 250, 100, 127};
 const SDL_Color OB_ENDBOX_COL   = {250, 100, 100, 127};
 const SDL_Color OB_REVIVE_COL   = {220, 220, 220, 255};
 const SDL_Color OB_LOC_COL      = {150, 150, 150, 127};
+
+const SDL_Color PROFILER_BG_COL       = {  0,   0,   0, 160};
+const SDL_Color PROFILER_FRAME_COL    = {120, 120, 120, 255};
+const SDL_Color PROFILER_TICK_COL     = {227, 172,  91, 255};
+const SDL_Color PROFILER_TICKRATE_COL = {200,  60,  60, 255};
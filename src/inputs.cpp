@@ -82,6 +82,9 @@ void get_inputs(PlayerInputs* inputs) {
                 case SDLK_ESCAPE:
                     inputs->key_escape = true;
                     break;
+                case SDLK_F9:
+                    inputs->key_f9 = true;
+                    break;
             }
         }
         else if (e.type == SDL_KEYUP) {
@@ -117,6 +120,9 @@ void get_inputs(PlayerInputs* inputs) {
                 case SDLK_ESCAPE:
                     inputs->key_escape = false;
                     break;
+                case SDLK_F9:
+                    inputs->key_f9 = false;
+                    break;
             }
         }
     }
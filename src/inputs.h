@@ -22,6 +22,7 @@ struct PlayerInputs {
     bool key_space;
     bool key_shift;
     bool key_escape;
+    bool key_f9;
     bool quit;
 
     // default constructor
@@ -46,6 +47,7 @@ struct PlayerInputs {
         key_space(other.key_space),
         key_shift(other.key_shift),
         key_escape(other.key_escape),
+        key_f9(other.key_f9),
         quit(other.quit) {}
 };
 
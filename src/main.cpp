@@ -2,23 +2,34 @@
 #include <emscripten.h>
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <memory>
 #include <string>
+#include <thread>
 #include <unordered_map>
 
 #include <fmt/format.h>
 #include <SDL.h>
 
+#include "AssetLoader.h"
 #include "Font.h"
+#include "FramePacer.h"
 #include "globals.h"
 #include "g_game.h"
 #include "inputs.h"
 #include "misc_gfx.h"
+#include "Profiler.h"
+#include "TextureAtlas.h"
 #include "Vec2.h"
 
 SDL_Window* window = nullptr;
 SDL_Renderer* renderer = nullptr;
 PlayerInputs* inputs = nullptr;
+TextureAtlas* texture_atlas = nullptr;
+FramePacer* frame_pacer = nullptr; // native only, the browser paces wasm frames
 std::unique_ptr<Game> game;
 bool quit = false;
 
@@ -30,23 +41,42 @@ Uint32 prev_time = 0;
 float fps = 0.0f;
 double current_time = 0.0;
 double accumulator = 0.0;
-double previous_update_time = 0.0;
-int current_tic = 0;
+bool profile_key_was_down = false;
+bool threaded_sim = false;          // native: ticks run on sim_thread, wasm: inline in main_loop
+SimOptions sim_options;
+#ifndef __EMSCRIPTEN__
+std::atomic<bool> sim_running(false);
+std::thread sim_thread;
+#endif
 
+// fonts get queued before Game starts taking its own assets, so everything decodes at the same time
 void set_game_globals() {
-    game = std::unique_ptr<Game>(new Game());
+    texture_atlas = new TextureAtlas();
+    AssetLoader loader;
+    int font_tiny_white  = Font::load(loader, "assets/small_font.png", {255, 255, 255, 255}, 1);
+    int font_small_white = Font::load(loader, "assets/small_font.png", {255, 255, 255, 255}, 2);
+    int font_tiny_black  = Font::load(loader, "assets/small_font.png", {  0,   0,   0, 255}, 1);
+    int font_small_black = Font::load(loader, "assets/small_font.png", {  0,   0,   0, 255}, 2);
+    game = std::unique_ptr<Game>(new Game(loader));
+    game->sim_options = sim_options;
     inputs = new PlayerInputs;
     inputs->key_space = false;
     inputs->key_enter = false;
     inputs->key_shift = false;
     inputs->key_escape = false;
-    fonts["tiny_white"]  = new Font("assets/small_font.png", {255, 255, 255, 255}, 1);
-    fonts["small_white"] = new Font("assets/small_font.png", {255, 255, 255, 255}, 2);
-    fonts["tiny_black"]  = new Font("assets/small_font.png", {  0,   0,   0, 255}, 1);
-    fonts["small_black"] = new Font("assets/small_font.png", {  0,   0,   0, 255}, 2);
+    inputs->key_f9 = false;
+    fonts["tiny_white"]  = new Font(loader, font_tiny_white, 1);
+    fonts["small_white"] = new Font(loader, font_small_white, 2);
+    fonts["tiny_black"]  = new Font(loader, font_tiny_black, 1);
+    fonts["small_black"] = new Font(loader, font_small_black, 2);
+    printf("startup assets:\n");
+    loader.print_report();
+    texture_atlas->build();
+    printf("texture atlas: %i pages\n", texture_atlas->get_num_pages());
 }
 
 void clear_game_globals() {
+    game.reset();
     delete inputs;
     inputs = nullptr;
     for (auto& pair : fonts) {
@@ -54,6 +84,8 @@ void clear_game_globals() {
         pair.second = nullptr;
     }
     fonts.clear();
+    delete texture_atlas;
+    texture_atlas = nullptr;
 }
 
 void update_fps() {
@@ -66,58 +98,126 @@ void update_fps() {
     }
 }
 
+#ifndef __EMSCRIPTEN__
+// fixed TICRATE ticks, independent of how long frames take
+void sim_loop() {
+    double next_tick_time = get_precise_time();
+    while (sim_running) {
+        double now = get_precise_time();
+        if (now < next_tick_time) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(std::min(next_tick_time - now, 0.001)));
+            continue;
+        }
+        game->tick();
+        next_tick_time += DT;
+        // don't try to catch up on more than MAX_UPDATE_FRAMES ticks (e.g. after sitting on a breakpoint)
+        if (now - next_tick_time > MAX_ACCUM)
+            next_tick_time = now;
+    }
+}
+
+void start_sim_thread() {
+    threaded_sim = true;
+    sim_running = true;
+    sim_thread = std::thread(sim_loop);
+}
+
+void stop_sim_thread() {
+    if (!threaded_sim)
+        return;
+    sim_running = false;
+    sim_thread.join();
+    threaded_sim = false;
+}
+#endif
+
 void main_loop() {
-    double new_time = SDL_GetTicks() / 1000.0;
+    PROFILE_ZONE("frame");
+    if (frame_pacer)
+        frame_pacer->begin_frame();
+    double new_time = get_precise_time();
     double frame_time = new_time - current_time;
     current_time = new_time;
-    accumulator = std::min(accumulator + frame_time, MAX_ACCUM);
 
     // updates that occur every frame (camera, mouse cursors)
     update_fps();
-    get_inputs(inputs);
+    {
+        PROFILE_ZONE("input");
+        get_inputs(inputs);
+    }
     game->update(inputs, frame_time);
     quit = inputs->quit;
+    // F9 dumps the profiler's ring buffers (open in chrome://tracing or ui.perfetto.dev)
+    if (inputs->key_f9 && !profile_key_was_down)
+        profiler_dump_chrome_trace("profile.json");
+    profile_key_was_down = inputs->key_f9;
     //
     vec2<int> camera_pos = game->get_camera_pos();
     vec2<int> camera_tgt = game->get_camera_target();
 
-    // updates that occur every game tick
-    while (accumulator >= DT) {
-        //
-        game->tick();
-        //
-        previous_update_time = current_time;
-        accumulator -= DT;
-        current_tic++;
-        //
-        // DEBUGGING STUFF
-        ////if (current_tic == 100) {
-        ////    game->animation_manager.add_animation("test", "assets/M484explosionset1.png", {34,34});
-        ////    game->animation_manager.start_new_animation("test", "anim_id_1", {128,384}, true);
-        ////}
+    // updates that occur every game tick (unless the sim thread is doing them)
+    if (!threaded_sim) {
+        accumulator = std::min(accumulator + frame_time, MAX_ACCUM);
+        while (accumulator >= DT) {
+            game->tick();
+            accumulator -= DT;
+        }
     }
 
     // drawing
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
     SDL_RenderClear(renderer);
     //
-    draw_background_grid(camera_pos);
+    {
+        PROFILE_ZONE("draw background");
+        draw_background_grid(camera_pos);
+    }
     //
     game->draw();
+    const RenderSnapshot& snapshot = game->get_drawn_snapshot();
     //
-    fonts["small_white"]->draw_text(fmt::format("FPS: {:.2f}", fps), {10, 10});
-    fonts["small_white"]->draw_text(fmt::format("{},{} ({},{})", inputs->mouse_x, inputs->mouse_y, inputs->mouse_x / GRIDSIZE, inputs->mouse_y / GRIDSIZE), {10, 30});
-    fonts["small_white"]->draw_text(fmt::format("{}", current_tic), {10, 50});
-    fonts["small_white"]->draw_text(fmt::format("{},{} {},{}", camera_pos.x, camera_pos.y, camera_tgt.x, camera_tgt.y), {10, 70});
+    {
+        PROFILE_ZONE("draw HUD");
+        profiler_add_frame_sample(1000.0f * frame_time, snapshot.tick_ms);
+        draw_profiler_graph({10, RESOLUTION.y - 110});
+        fonts["small_white"]->draw_text(fmt::format("FPS: {:.2f}", fps), {10, 10});
+        fonts["small_white"]->draw_text(fmt::format("{},{} ({},{})", inputs->mouse_x, inputs->mouse_y, inputs->mouse_x / GRIDSIZE, inputs->mouse_y / GRIDSIZE), {10, 30});
+        fonts["small_white"]->draw_text(fmt::format("{}", snapshot.tick), {10, 50});
+        fonts["small_white"]->draw_text(fmt::format("{},{} {},{}", camera_pos.x, camera_pos.y, camera_tgt.x, camera_tgt.y), {10, 70});
+        if (frame_pacer)
+            fonts["small_white"]->draw_text(fmt::format("limit {:.0f}  jitter {:.2f} ms (max {:.1f})  busy {:.0f}%  cpu {:.0f}%",
+                                                        frame_pacer->get_target_fps(), frame_pacer->get_jitter_ms(), frame_pacer->get_max_interval_ms(),
+                                                        100.0f * frame_pacer->get_busy_fraction(), 100.0f * frame_pacer->get_cpu_usage()), {10, 90});
+        const ChunkStats& chunks = snapshot.map_chunks;
+        if (chunks.num_chunks > 0)
+            fonts["small_white"]->draw_text(fmt::format("chunks {}/{}  {} KB decoded + {} KB rle (full {} KB)  page-ins {} (avg {:.3f} ms, max {:.3f})",
+                                                        chunks.resident_chunks, chunks.num_chunks, chunks.resident_bytes / 1024, chunks.stored_bytes / 1024,
+                                                        chunks.full_bytes / 1024, chunks.page_ins, chunks.page_ins > 0 ? chunks.page_in_ms / chunks.page_ins : 0.0,
+                                                        chunks.max_page_in_ms), {10, 110});
+    }
     //
-    SDL_RenderPresent(renderer);
+    {
+        PROFILE_ZONE("present");
+        SDL_RenderPresent(renderer);
+    }
+    // sleep until the next frame is due (or the next tick, if we're ticking on this thread)
+    if (frame_pacer)
+        frame_pacer->end_frame(threaded_sim ? 0.0 : current_time + DT - accumulator);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     SDL_Init(SDL_INIT_VIDEO);
 
     bool vsync = false;
 
+    // wasm gets these from Module.arguments
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--fixed-point")
+            sim_options.fixed_point = true;
+        if (std::string(argv[i]) == "--sim-hashes")
+            sim_options.log_hashes = true;
+    }
+
     ///////////////////////////////////
     #ifdef __EMSCRIPTEN__ /////////////
     ///////////////////////////////////
@@ -127,15 +227,26 @@ int main() {
     //
     #else /////////////////////////////
     //
+    double target_fps = DEFAULT_TARGET_FPS;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--fps")
+            target_fps = std::atof(argv[i + 1]);
+    }
+    //
     window = SDL_CreateWindow("OpenBound v0.1", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, RESOLUTION.x, RESOLUTION.y, 0);
     if (vsync)
         renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
     else
         renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
     set_game_globals();
+    frame_pacer = new FramePacer(vsync ? 0.0 : target_fps);
+    start_sim_thread();
     while (!quit) {
         main_loop();
     }
+    stop_sim_thread();
+    delete frame_pacer;
+    frame_pacer = nullptr;
     ///////////////////////////////////
     #endif ////////////////////////////
     ///////////////////////////////////
@@ -21,6 +21,13 @@ SDL_Surface* load_image(const std::string& image_filename, bool colorkey) {
 
 std::vector<SDL_Surface*> load_spritesheet(const std::string& image_filename, const vec2<int>& sprite_dimensions) {
     SDL_Surface* full_img = load_image(image_filename);
+    std::vector<SDL_Surface*> out_vector = slice_spritesheet(full_img, sprite_dimensions);
+    SDL_FreeSurface(full_img);
+    return out_vector;
+}
+
+// sprites are read left to right, top to bottom. full_img isn't freed
+std::vector<SDL_Surface*> slice_spritesheet(SDL_Surface* full_img, const vec2<int>& sprite_dimensions) {
     if (full_img->w % sprite_dimensions.x > 0 || full_img->h % sprite_dimensions.y > 0)
         throw std::invalid_argument("invalid spritesheet size");
     int num_cols = full_img->w / sprite_dimensions.x;
@@ -38,11 +45,34 @@ std::vector<SDL_Surface*> load_spritesheet(const std::string& image_filename, co
             out_vector.push_back(sprite_surface);
         }
     }
-    SDL_FreeSurface(full_img);
-
     return out_vector;
 }
 
+// new RGBA32 copy of surface, with its colorkeyed pixels (if it has a colorkey) fully transparent. doesn't touch
+// the renderer, so it's fine to call off the main thread
+SDL_Surface* colorkey_to_alpha(SDL_Surface* surface) {
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+    if (converted == nullptr)
+        return nullptr;
+    Uint32 colorkey;
+    if (SDL_GetColorKey(surface, &colorkey) == 0) {
+        Uint8 key_r, key_g, key_b;
+        SDL_GetRGB(colorkey, surface->format, &key_r, &key_g, &key_b);
+        SDL_LockSurface(converted);
+        for (int y = 0; y < converted->h; ++y) {
+            Uint32* row = reinterpret_cast<Uint32*>(static_cast<Uint8*>(converted->pixels) + y * converted->pitch);
+            for (int x = 0; x < converted->w; ++x) {
+                Uint8 r, g, b, a;
+                SDL_GetRGBA(row[x], converted->format, &r, &g, &b, &a);
+                if (r == key_r && g == key_g && b == key_b)
+                    row[x] = 0;
+            }
+        }
+        SDL_UnlockSurface(converted);
+    }
+    return converted;
+}
+
 SDL_Surface* rescale_surface(SDL_Surface* src, int new_width, int new_height) {
     if (!src)
         return nullptr;
@@ -11,6 +11,8 @@ extern SDL_Renderer* renderer;
 
 SDL_Surface* load_image(const std::string& image_filename, bool colorkey = true);
 std::vector<SDL_Surface*> load_spritesheet(const std::string& image_filename, const vec2<int>& sprite_dimensions);
+std::vector<SDL_Surface*> slice_spritesheet(SDL_Surface* full_img, const vec2<int>& sprite_dimensions);
+SDL_Surface* colorkey_to_alpha(SDL_Surface* surface);
 SDL_Surface* rescale_surface(SDL_Surface* src, int new_width, int new_height);
 void draw_line(const Line& line, SDL_Color color);
 void draw_thick_line(SDL_Renderer* renderer, const Line& line, SDL_Color color, int thickness);
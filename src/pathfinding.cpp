@@ -1,24 +1,114 @@
 #include "pathfinding.h"
 
 #include <algorithm>
-#include <queue>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <tuple>
 
-bool line_of_sight_unit(const vec2<float>& v1, const vec2<float>& v2, const Array2D<bool>& wall_dat) {
-    for (const auto& adj : ADJ_LOS_UNIT) {
-        if (!points_are_visible_to_eachother({v1.x + adj.x, v1.y + adj.y}, {v2.x + adj.x, v2.y + adj.y}, wall_dat))
-            return false;
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "Profiler.h"
+#include "regions.h"
+#include "WallBits.h"
+
+// visit(offset) for every point line_of_sight_unit casts a ray from, around the unit's center, until one returns
+// false: the corners of its bounding box, and on a box wider than a tile evenly spaced points along the sides too
+// (no more than a tile apart, so a wall tile can't slip between two rays)
+template <typename Visit>
+static bool all_ray_offsets(float half_size, const Visit& visit) {
+    float a = std::max(half_size - EPSILON, 0.0f);
+    int n = std::max(static_cast<int>(std::ceil(2.0f * a)) + 1, 2);  // points per side
+    float step = 2.0f * a / static_cast<float>(n - 1);
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            if (i != 0 && i != n - 1 && j != 0 && j != n - 1)
+                continue;
+            if (!visit(vec2<float>(-a + static_cast<float>(i) * step, -a + static_cast<float>(j) * step)))
+                return false;
+        }
     }
     return true;
 }
 
-bool valid_player_position(const vec2<int>& position, const Array2D<bool>& wall_dat) {
-    for (const auto& adj : ADJ_VALIDPOS) {
-        vec2<float> v_adj = {static_cast<float>(position.x) + adj.x, static_cast<float>(position.y) + adj.y};
-        vec2<int> v_map = {static_cast<int>(v_adj.x / F_GRIDSIZE), static_cast<int>(v_adj.y / F_GRIDSIZE)};
-        if (v_map.x < 0 || v_map.x >= wall_dat.width() ||
-            v_map.y < 0 || v_map.y >= wall_dat.height() || 
-            wall_dat[v_map.x][v_map.y])
-            return false;
+template <typename WallGrid>
+bool line_of_sight_unit(const vec2<float>& v1, const vec2<float>& v2, const WallGrid& wall_dat, float half_size) {
+    return all_ray_offsets(half_size, [&](const vec2<float>& adj) {
+        return points_are_visible_to_eachother({v1.x + adj.x, v1.y + adj.y}, {v2.x + adj.x, v2.y + adj.y}, wall_dat);
+    });
+}
+
+// line_of_sight_unit from v1 to every target, a ray offset at a time with visible_from. each offset only casts
+// the rays that all the ones before it let through
+void line_of_sight_unit(const vec2<float>& v1, const std::vector<vec2<float>>& targets, const WallBits& walls, float half_size,
+                        LosScratch& scratch, std::vector<uint8_t>& out_visible) {
+    out_visible.assign(targets.size(), 1);
+    std::vector<int>& remaining = scratch.remaining;
+    remaining.resize(targets.size());
+    for (size_t i = 0; i < targets.size(); ++i)
+        remaining[i] = i;
+    all_ray_offsets(half_size, [&](const vec2<float>& adj) {
+        scratch.ray_targets.clear();
+        for (int i : remaining)
+            scratch.ray_targets.push_back({targets[i].x + adj.x, targets[i].y + adj.y});
+        scratch.ray_visible.resize(scratch.ray_targets.size());
+        visible_from({v1.x + adj.x, v1.y + adj.y}, scratch.ray_targets.data(), scratch.ray_targets.size(), walls,
+                     scratch.ray_visible.data());
+        size_t num_remaining = 0;
+        for (size_t k = 0; k < remaining.size(); ++k) {
+            if (scratch.ray_visible[k])
+                remaining[num_remaining++] = remaining[k];
+            else
+                out_visible[remaining[k]] = 0;
+        }
+        remaining.resize(num_remaining);
+        return num_remaining > 0;
+    });
+}
+
+template <typename WallGrid>
+bool valid_player_position(const vec2<int>& position, const WallGrid& wall_dat, float radius) {
+    // sample the unit's bounding box at <= 1 tile spacing so that no wall tile can fit between samples
+    // (for the default radius this is just the four corners)
+    float adj = radius - EPSILON;
+    int num_samples = static_cast<int>(std::ceil(2.0f * radius / F_GRIDSIZE)) + 1;
+    float step = 2.0f * adj / static_cast<float>(num_samples - 1);
+    for (int i = 0; i < num_samples; ++i) {
+        for (int j = 0; j < num_samples; ++j) {
+            vec2<float> v_adj = {static_cast<float>(position.x) - adj + i * step, static_cast<float>(position.y) - adj + j * step};
+            vec2<int> v_map = {static_cast<int>(v_adj.x / F_GRIDSIZE), static_cast<int>(v_adj.y / F_GRIDSIZE)};
+            if (v_map.x < 0 || v_map.x >= wall_dat.width() ||
+                v_map.y < 0 || v_map.y >= wall_dat.height() ||
+                wall_dat[v_map.x][v_map.y])
+                return false;
+        }
+    }
+    return true;
+}
+
+// valid_player_position for the fixed point sim mode, in 24.8 and integers only: every tile the open box
+// (position - radius, position + radius) overlaps has to be on the map and open
+template <typename WallGrid>
+bool valid_player_position_fixed(const vec2<fixed_t>& position, const WallGrid& wall_dat, fixed_t radius) {
+    const int64_t tile_size = GRIDSIZE * FIXED_ONE;
+    int64_t left = static_cast<int64_t>(position.x) - radius;
+    int64_t top = static_cast<int64_t>(position.y) - radius;
+    int64_t right = static_cast<int64_t>(position.x) + radius;
+    int64_t bottom = static_cast<int64_t>(position.y) + radius;
+    if (left < 0 || top < 0 || right <= left || bottom <= top)
+        return false;
+    int64_t x1 = (right - 1) / tile_size;
+    int64_t y1 = (bottom - 1) / tile_size;
+    if (x1 >= wall_dat.width() || y1 >= wall_dat.height())
+        return false;
+    for (int x = static_cast<int>(left / tile_size); x <= x1; ++x) {
+        for (int y = static_cast<int>(top / tile_size); y <= y1; ++y) {
+            if (wall_dat[x][y])
+                return false;
+        }
     }
     return true;
 }
@@ -64,58 +154,220 @@ bool edge_never_turns_towards_wall(const vec2<int>& v1, const vec2<int>& v2, int
     return true;
 }
 
-PathfindingData get_pathfinding_data(const Array2D<bool>& wall_dat) {
+// two-pass chessboard distance transform, capped at MAX_CLEARANCE. tiles outside the map count as walls. a pass only
+// ever needs the row it's on and the one before, so the first goes straight into the chunks and the second back
+// over them
+ChunkedGrid<uint8_t> get_clearance_map(const WallBits& walls, int resident_chunks) {
+    PROFILE_ZONE("get_clearance_map");
+    int width = walls.width();
+    int height = walls.height();
+    // tile x of a row is at x + 1, the map edge either side stays 0
+    std::vector<uint8_t> previous(width + 2, 0);
+    std::vector<uint8_t> current(width + 2, 0);
+    int x = 0;
+    int y = 0;
+    auto next_dist = [&]() {
+        uint8_t dist = 0;
+        if (!walls.get(x, y)) {
+            int d = std::min(std::min(current[x], previous[x]), std::min(previous[x + 1], previous[x + 2]));
+            dist = std::min(d + 1, MAX_CLEARANCE);
+        }
+        current[x + 1] = dist;
+        if (++x == width) {
+            x = 0;
+            y += 1;
+            std::swap(previous, current);
+        }
+        return dist;
+    };
+    ChunkedGrid<uint8_t> clearance = ChunkedGrid<uint8_t>::generate(width, height, next_dist, resident_chunks);
+    std::fill(previous.begin(), previous.end(), 0);
+    for (y = height - 1; y >= 0; --y) {
+        for (x = width - 1; x >= 0; --x) {
+            uint8_t dist = clearance.get(x, y);
+            if (dist != 0) {
+                int d = std::min(std::min(current[x + 2], previous[x + 2]), std::min(previous[x + 1], previous[x]));
+                if (d + 1 < dist) {
+                    dist = d + 1;
+                    clearance.set(x, y, dist);
+                }
+            }
+            current[x + 1] = dist;
+        }
+        std::swap(previous, current);
+    }
+    return clearance;
+}
 
-    //
-    // PARSE MAP, GET DISCONNECTED REGIONS
-    //
+// get_clearance_map for the tiles of window only, into out (x-major rows of the window, like the chunks). tiles
+// past the window count as MAX_CLEARANCE, so a tile's clearance comes out right as long as every wall within
+// MAX_CLEARANCE of it is inside the window
+static void get_clearance_window(const WallBits& walls, const Rect& window, std::vector<uint8_t>& out) {
+    int x0 = window.position.x;
+    int y0 = window.position.y;
+    int w = window.size.x;
+    int h = window.size.y;
+    out.resize(w * h);
+    auto at = [&](int x, int y) -> int {
+        if (x < 0 || x >= walls.width() || y < 0 || y >= walls.height())
+            return 0;
+        if (x < x0 || x >= x0 + w || y < y0 || y >= y0 + h)
+            return MAX_CLEARANCE;
+        return out[(x - x0) + (y - y0) * w];
+    };
+    for (int y = y0; y < y0 + h; ++y) {
+        for (int x = x0; x < x0 + w; ++x) {
+            int dist = 0;
+            if (!walls.get(x, y))
+                dist = std::min(std::min(std::min(at(x - 1, y), at(x - 1, y - 1)), std::min(at(x, y - 1), at(x + 1, y - 1))) + 1, MAX_CLEARANCE);
+            out[(x - x0) + (y - y0) * w] = dist;
+        }
+    }
+    for (int y = y0 + h - 1; y >= y0; --y) {
+        for (int x = x0 + w - 1; x >= x0; --x) {
+            uint8_t& dist = out[(x - x0) + (y - y0) * w];
+            if (dist != 0)
+                dist = std::min<int>(dist, std::min(std::min(at(x + 1, y), at(x + 1, y + 1)), std::min(at(x, y + 1), at(x - 1, y + 1))) + 1);
+        }
+    }
+}
 
-    int width = wall_dat.width();
-    int height = wall_dat.height();
-    
-    Array2D<int> tile_2_region_id(width, height, -1);
-    Array2D<bool> visited(width, height, false);
-    int num_regions = 0;
+//
+// corner nodes: every open tile (off the map border) where one of the diagonals is blocked but the two sides
+// next to it are open. get_corner_nodes does 64 tiles a word, from the packed walls: each row's open bits get
+// shifted by one tile either way, so all eight neighbours of a word's tiles are plain words and the four corner
+// tests are bitwise ops over whole rows (two words at a time with sse2). get_corner_nodes_scalar is the original
+// tile by tile scan, kept as the reference it has to match
+//
 
-    for (int x = 1; x < width - 1; ++x) {
-        for (int y = 1; y < height - 1; ++y) {
-            if (!visited[x][y] && !wall_dat[x][y]) {
-                visited[x][y] = true;
-                tile_2_region_id[x][y] = num_regions;
-                
-                std::queue<vec2<int>> queue;
-                queue.push({x,y});
-                while (!queue.empty()) {
-                    vec2<int> current = queue.front();
-                    queue.pop();
-                    for (const auto& dir : MOVE_DIR) {
-                        vec2<int> next = current + dir;
-                        if (next.x >= 0 && next.x < width && next.y >= 0 && next.y < height && !visited[next.x][next.y] && !wall_dat[next.x][next.y]) {
-                            visited[next.x][next.y] = true;
-                            tile_2_region_id[next.x][next.y] = num_regions;
-                            queue.push(next);
-                        }
-                    }
-                }
-                ++num_regions;
+// open bits of a row, and the same shifted so bit x holds tile x - 1 (left) or x + 1 (right)
+static void get_open_row(const uint64_t* __restrict walls, int num_words, uint64_t* __restrict open,
+                         uint64_t* __restrict left, uint64_t* __restrict right) {
+    for (int w = 0; w < num_words; ++w)
+        open[w] = ~walls[w];
+    for (int w = 0; w < num_words; ++w) {
+        left[w] = (open[w] << 1) | (w > 0 ? open[w - 1] >> 63 : 0);
+        right[w] = (open[w] >> 1) | (w + 1 < num_words ? open[w + 1] << 63 : 0);
+    }
+}
+
+// a b c
+// d . e    for the tiles of the middle row. above, middle and below each hold a row's open, left and right words
+// f g h    back to back, out gets the corner tiles, then which of the nw, ne, sw, se diagonals are walls
+static void get_corner_masks(int num_words, const uint64_t* __restrict above, const uint64_t* __restrict middle,
+                             const uint64_t* __restrict below, const uint64_t* __restrict interior, uint64_t* __restrict out) {
+    const uint64_t* b = above;
+    const uint64_t* a = above + num_words;
+    const uint64_t* c = above + 2 * num_words;
+    const uint64_t* center = middle;
+    const uint64_t* d = middle + num_words;
+    const uint64_t* e = middle + 2 * num_words;
+    const uint64_t* g = below;
+    const uint64_t* f = below + num_words;
+    const uint64_t* h = below + 2 * num_words;
+    uint64_t* out_nodes = out;
+    uint64_t* out_blocked_nw = out + num_words;
+    uint64_t* out_blocked_ne = out + 2 * num_words;
+    uint64_t* out_blocked_sw = out + 3 * num_words;
+    uint64_t* out_blocked_se = out + 4 * num_words;
+    int w = 0;
+#ifdef __SSE2__
+    for (; w + 2 <= num_words; w += 2) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + w));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + w));
+        __m128i vc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c + w));
+        __m128i vd = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d + w));
+        __m128i ve = _mm_loadu_si128(reinterpret_cast<const __m128i*>(e + w));
+        __m128i vf = _mm_loadu_si128(reinterpret_cast<const __m128i*>(f + w));
+        __m128i vg = _mm_loadu_si128(reinterpret_cast<const __m128i*>(g + w));
+        __m128i vh = _mm_loadu_si128(reinterpret_cast<const __m128i*>(h + w));
+        __m128i nw = _mm_andnot_si128(va, _mm_and_si128(vb, vd));
+        __m128i ne = _mm_andnot_si128(vc, _mm_and_si128(vb, ve));
+        __m128i sw = _mm_andnot_si128(vf, _mm_and_si128(vd, vg));
+        __m128i se = _mm_andnot_si128(vh, _mm_and_si128(vg, ve));
+        __m128i open = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(center + w)),
+                                     _mm_loadu_si128(reinterpret_cast<const __m128i*>(interior + w)));
+        __m128i nodes = _mm_and_si128(open, _mm_or_si128(_mm_or_si128(nw, ne), _mm_or_si128(sw, se)));
+        __m128i ones = _mm_set1_epi32(-1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out_nodes + w), nodes);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out_blocked_nw + w), _mm_xor_si128(va, ones));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out_blocked_ne + w), _mm_xor_si128(vc, ones));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out_blocked_sw + w), _mm_xor_si128(vf, ones));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out_blocked_se + w), _mm_xor_si128(vh, ones));
+    }
+#endif
+    // everything without sse2 (wasm), and the odd word at the end
+    for (; w < num_words; ++w) {
+        uint64_t nw = ~a[w] & b[w] & d[w];
+        uint64_t ne = ~c[w] & b[w] & e[w];
+        uint64_t sw = ~f[w] & d[w] & g[w];
+        uint64_t se = ~h[w] & g[w] & e[w];
+        out_nodes[w] = center[w] & interior[w] & (nw | ne | sw | se);
+        out_blocked_nw[w] = ~a[w];
+        out_blocked_ne[w] = ~c[w];
+        out_blocked_sw[w] = ~f[w];
+        out_blocked_se[w] = ~h[w];
+    }
+}
+
+std::vector<CornerNode> get_corner_nodes(const WallBits& walls) {
+    PROFILE_ZONE("get_corner_nodes");
+    int width = walls.width();
+    int height = walls.height();
+    int num_words = walls.get_words_per_row();
+    std::vector<CornerNode> found;
+    if (width < 3 || height < 3)
+        return found;
+
+    // tiles 1..width-2 (nothing past the end of a row is ever open)
+    std::vector<uint64_t> interior(num_words, ~uint64_t(0));
+    interior[0] &= ~uint64_t(1);
+    interior[(width - 1) / 64] &= ~(uint64_t(1) << ((width - 1) % 64));
+
+    // open/left/right words of three rows at a time, row y lives in block y % 3
+    std::vector<uint64_t> row_bits(9 * num_words);
+    std::vector<uint64_t> masks(5 * num_words);
+    std::vector<uint64_t> wall_row(num_words);
+    auto fill_row = [&](int y) {
+        uint64_t* block = &row_bits[3 * (y % 3) * num_words];
+        walls.get_row(y, wall_row.data());
+        get_open_row(wall_row.data(), num_words, block, block + num_words, block + 2 * num_words);
+    };
+    fill_row(0);
+    fill_row(1);
+    for (int y = 1; y < height - 1; ++y) {
+        fill_row(y + 1);
+        get_corner_masks(num_words, &row_bits[3 * ((y - 1) % 3) * num_words], &row_bits[3 * (y % 3) * num_words],
+                         &row_bits[3 * ((y + 1) % 3) * num_words], interior.data(), masks.data());
+        const uint64_t* nodes = masks.data();
+        for (int w = 0; w < num_words; ++w) {
+            for (uint64_t bits = nodes[w]; bits != 0; bits &= bits - 1) {
+                int bit = __builtin_ctzll(bits);
+                int blocked = ((nodes[num_words + w] >> bit) & 1) * BlockedDirections::NW +
+                              ((nodes[2 * num_words + w] >> bit) & 1) * BlockedDirections::NE +
+                              ((nodes[3 * num_words + w] >> bit) & 1) * BlockedDirections::SW +
+                              ((nodes[4 * num_words + w] >> bit) & 1) * BlockedDirections::SE;
+                found.push_back({{w * 64 + bit, y}, blocked});
             }
         }
     }
-    printf("num_regions: %i\n", num_regions);
 
-    //
-    // GET CANDIDATE PATHING NODES
-    //
-    
-    // nodes[region][i] = (x,y)
-    std::vector<std::vector<vec2<int>>> nodes(num_regions);
-    // blocked_corners[region][i] = val
-    // - val & 1 --> NW is blocked
-    // - val & 2 --> NE is blocked
-    // - val & 4 --> SW is blocked --- note that these last two are swapped compared to openbound
-    // - val & 8 --> SE is blocked ---
-    std::vector<std::vector<int>> blocked_corners(num_regions);
-    
+    // found row by row, hand them back column by column like the scalar scan
+    std::vector<int> column_starts(width + 1, 0);
+    for (const CornerNode& node : found)
+        column_starts[node.position.x + 1] += 1;
+    for (int x = 0; x < width; ++x)
+        column_starts[x + 1] += column_starts[x];
+    std::vector<CornerNode> out(found.size());
+    for (const CornerNode& node : found)
+        out[column_starts[node.position.x]++] = node;
+    return out;
+}
+
+std::vector<CornerNode> get_corner_nodes_scalar(const Array2D<bool>& wall_dat) {
+    int width = wall_dat.width();
+    int height = wall_dat.height();
+    std::vector<CornerNode> out;
     for (int x = 1; x < width - 1; ++x) {
         for (int y = 1; y < height - 1; ++y) {
             if (!wall_dat[x][y]) {
@@ -127,107 +379,457 @@ PathfindingData get_pathfinding_data(const Array2D<bool>& wall_dat) {
                 bool f = !wall_dat[x-1][y+1];
                 bool g = !wall_dat[x  ][y+1];
                 bool h = !wall_dat[x+1][y+1];
-
-                int my_region_id = tile_2_region_id[x][y];
                 if ((!a && b && d) || (!c && b && e) || (!f && d && g) || (!h && g && e)) {
-                    nodes[my_region_id].push_back({x, y});
-                    blocked_corners[my_region_id].push_back(0);
-                    int vec_ind = blocked_corners[my_region_id].size() - 1;
-                    if (!a) blocked_corners[my_region_id][vec_ind] += BlockedDirections::NW;
-                    if (!c) blocked_corners[my_region_id][vec_ind] += BlockedDirections::NE;
-                    if (!f) blocked_corners[my_region_id][vec_ind] += BlockedDirections::SW;
-                    if (!h) blocked_corners[my_region_id][vec_ind] += BlockedDirections::SE;
+                    int blocked = 0;
+                    if (!a) blocked += BlockedDirections::NW;
+                    if (!c) blocked += BlockedDirections::NE;
+                    if (!f) blocked += BlockedDirections::SW;
+                    if (!h) blocked += BlockedDirections::SE;
+                    out.push_back({{x, y}, blocked});
                 }
             }
         }
     }
-    for (int rid = 0; rid < num_regions; ++rid) {
-        printf("region: %i (%zu nodes)\n", rid, nodes[rid].size());
+    return out;
+}
+
+// the corner nodes of region rid, found tile by tile inside its bounds. same nodes in the same (x-major) order as
+// picking the region's out of get_corner_nodes
+static void get_region_corner_nodes(const WallBits& walls, const ChunkedGrid<int>& tile_2_region_id, int rid, const Rect& bounds,
+                                    std::vector<vec2<int>>& nodes, std::vector<int>& blocked_corners) {
+    nodes.clear();
+    blocked_corners.clear();
+    int x0 = std::max(bounds.position.x, 1);
+    int y0 = std::max(bounds.position.y, 1);
+    int x1 = std::min(bounds.position.x + bounds.size.x, walls.width() - 1);
+    int y1 = std::min(bounds.position.y + bounds.size.y, walls.height() - 1);
+    for (int x = x0; x < x1; ++x) {
+        for (int y = y0; y < y1; ++y) {
+            if (walls.get(x, y) || tile_2_region_id.get(x, y) != rid)
+                continue;
+            bool a = !walls.get(x-1, y-1);
+            bool b = !walls.get(x  , y-1);
+            bool c = !walls.get(x+1, y-1);
+            bool d = !walls.get(x-1, y  );
+            bool e = !walls.get(x+1, y  );
+            bool f = !walls.get(x-1, y+1);
+            bool g = !walls.get(x  , y+1);
+            bool h = !walls.get(x+1, y+1);
+            if ((!a && b && d) || (!c && b && e) || (!f && d && g) || (!h && g && e)) {
+                nodes.push_back({x, y});
+                blocked_corners.push_back((!a) * BlockedDirections::NW + (!c) * BlockedDirections::NE +
+                                          (!f) * BlockedDirections::SW + (!h) * BlockedDirections::SE);
+            }
+        }
+    }
+}
+
+// packs a region's edges (node pairs, in the order they were found) into a RegionGraph. each node's neighbours
+// keep that order, so a* visits them the same way it did the old per-node lists
+static RegionGraph get_region_graph(const std::vector<vec2<int>>& nodes, const std::vector<vec2<float>>& positions,
+                                    const std::vector<vec2<int>>& edge_ij, const std::vector<float>& edge_dists) {
+    RegionGraph region_graph;
+    region_graph.nodes = nodes;
+    region_graph.positions = positions;
+    region_graph.edge_starts.assign(nodes.size() + 1, 0);
+    for (const vec2<int>& ij : edge_ij) {
+        region_graph.edge_starts[ij.x + 1] += 1;
+        region_graph.edge_starts[ij.y + 1] += 1;
+    }
+    for (size_t i = 0; i < nodes.size(); ++i)
+        region_graph.edge_starts[i + 1] += region_graph.edge_starts[i];
+    region_graph.neighbours.resize(2 * edge_ij.size());
+    region_graph.dists.resize(2 * edge_ij.size());
+    std::vector<uint32_t> next(region_graph.edge_starts.begin(), region_graph.edge_starts.end() - 1);
+    for (size_t e = 0; e < edge_ij.size(); ++e) {
+        // rounded up, so a straight line to the goal is never longer than the stored path (keeps a* admissible)
+        uint16_t dist = static_cast<uint16_t>(std::min(std::ceil(edge_dists[e] * GRAPH_DIST_SCALE), 65535.0f));
+        int i = edge_ij[e].x;
+        int j = edge_ij[e].y;
+        region_graph.neighbours[next[i]] = j;
+        region_graph.dists[next[i]++] = dist;
+        region_graph.neighbours[next[j]] = i;
+        region_graph.dists[next[j]++] = dist;
+    }
+    return region_graph;
+}
+
+// where a unit with this residual half-size stands at a corner node: the middle of the tile, unless it's wider
+// than a tile, then pushed away from the blocked corners until its box just clears them. false if the box
+// doesn't fit there (the node is left out)
+static bool get_node_position(const WallBits& walls, const vec2<int>& node, int blocked_corners, float residual,
+                              vec2<float>& position) {
+    position = {static_cast<float>(node.x) + 0.5f, static_cast<float>(node.y) + 0.5f};
+    float offset = residual - 0.5f;
+    if (offset <= 0.0f)
+        return true;
+    auto is_blocked = [blocked_corners](int dir) { return (blocked_corners & dir) != 0 ? 1 : 0; };
+    int dx = is_blocked(BlockedDirections::NW) + is_blocked(BlockedDirections::SW) - is_blocked(BlockedDirections::NE) -
+             is_blocked(BlockedDirections::SE);
+    int dy = is_blocked(BlockedDirections::NW) + is_blocked(BlockedDirections::NE) - is_blocked(BlockedDirections::SW) -
+             is_blocked(BlockedDirections::SE);
+    position.x += offset * static_cast<float>((dx > 0) - (dx < 0));
+    position.y += offset * static_cast<float>((dy > 0) - (dy < 0));
+    float a = residual - EPSILON;
+    for (int x = static_cast<int>(std::floor(position.x - a)); x <= static_cast<int>(std::floor(position.x + a)); ++x) {
+        for (int y = static_cast<int>(std::floor(position.y - a)); y <= static_cast<int>(std::floor(position.y + a)); ++y) {
+            if (walls.get(x, y))
+                return false;
+        }
+    }
+    return true;
+}
+
+// the buffers build_region_graph uses, kept from one region to the next
+struct EdgeScratch {
+    std::vector<vec2<int>> nodes;
+    std::vector<vec2<float>> positions;
+    std::vector<int> blocked_corners;
+    std::vector<int> los_nodes;
+    std::vector<vec2<float>> los_targets;
+    std::vector<uint8_t> los_visible;
+    LosScratch los;
+};
+
+// region rid's corner graph from its corner nodes (x-major, like get_corner_nodes finds them), leaving out the
+// ones the unit doesn't fit at
+static RegionGraph build_region_graph(int rid, const std::vector<vec2<int>>& corner_nodes, const std::vector<int>& corner_blocked,
+                                      const WallBits& walls, float residual, EdgeScratch& scratch) {
+    std::vector<vec2<int>>& nodes = scratch.nodes;
+    std::vector<vec2<float>>& positions = scratch.positions;
+    std::vector<int>& blocked_corners = scratch.blocked_corners;
+    nodes.clear();
+    positions.clear();
+    blocked_corners.clear();
+    for (size_t i = 0; i < corner_nodes.size(); ++i) {
+        vec2<float> position;
+        if (get_node_position(walls, corner_nodes[i], corner_blocked[i], residual, position)) {
+            nodes.push_back(corner_nodes[i]);
+            positions.push_back(position);
+            blocked_corners.push_back(corner_blocked[i]);
+        }
     }
+    printf("region: %i (%zu nodes)\n", rid, nodes.size());
+    if (nodes.size() > static_cast<size_t>(MAX_REGION_NODES))
+        throw std::invalid_argument("region " + std::to_string(rid) + " has too many corner nodes for graph_node_t");
 
     //
     // EDGE PRUNING 
     //
 
-    std::vector<std::vector<Line>> edges;
-    std::vector<std::unordered_map<int, std::vector<GraphNode>>> graphs;
-    for (int rid = 0; rid < num_regions; ++rid) {
-        std::vector<Line> candidate_edges, filtered_edges;
-        std::vector<vec2<int>> node_ij;
-        std::vector<float> node_dists;
-        std::unordered_map<int, std::vector<GraphNode>> graph;
-        int num_nodes = nodes[rid].size();
-        int filtcount1 = 0;
-        int filtcount2 = 0;
-        int filtcount3 = 0;
-        int filtcount4 = 0;
-        for (int i = 0; i < num_nodes; ++i) {
-            for (int j = i+1; j < num_nodes; ++j) {
-                vec2<int> v1 = nodes[rid][i];
-                vec2<int> v2 = nodes[rid][j];
-                int corner1 = blocked_corners[rid][i];
-                int corner2 = blocked_corners[rid][j];
-                //
-                if (edge_has_good_incoming_angles(v1, v2, corner1, corner2)) {
-                    if (edge_never_turns_towards_wall(v1, v2, corner1, corner2)) {
-                        vec2<float> v1f = {static_cast<float>(v1.x) + 0.5f, static_cast<float>(v1.y) + 0.5f};
-                        vec2<float> v2f = {static_cast<float>(v2.x) + 0.5f, static_cast<float>(v2.y) + 0.5f};
-                        if (line_of_sight_unit(v1f, v2f, wall_dat)) {
-                            candidate_edges.push_back({v1, v2});
-                            node_ij.push_back({i, j});
-                            node_dists.push_back((v2f - v1f).length());
-                        } else
-                            filtcount3 += 1;
-                    } else
-                        filtcount2 += 1;
+    std::vector<Line> candidate_edges;
+    std::vector<vec2<int>> node_ij, filtered_ij;
+    std::vector<float> node_dists, filtered_dists;
+    int num_nodes = nodes.size();
+    int filtcount1 = 0;
+    int filtcount2 = 0;
+    int filtcount3 = 0;
+    int filtcount4 = 0;
+    std::vector<int>& los_nodes = scratch.los_nodes;
+    std::vector<vec2<float>>& los_targets = scratch.los_targets;
+    std::vector<uint8_t>& los_visible = scratch.los_visible;
+    for (int i = 0; i < num_nodes; ++i) {
+        vec2<int> v1 = nodes[i];
+        int corner1 = blocked_corners[i];
+        vec2<float> v1f = positions[i];
+        // the angle checks first, then one batched line of sight from v1 to everything that passed them
+        los_nodes.clear();
+        los_targets.clear();
+        for (int j = i+1; j < num_nodes; ++j) {
+            vec2<int> v2 = nodes[j];
+            int corner2 = blocked_corners[j];
+            //
+            if (edge_has_good_incoming_angles(v1, v2, corner1, corner2)) {
+                if (edge_never_turns_towards_wall(v1, v2, corner1, corner2)) {
+                    los_nodes.push_back(j);
+                    los_targets.push_back(positions[j]);
                 } else
-                    filtcount1 += 1;
+                    filtcount2 += 1;
+            } else
+                filtcount1 += 1;
+        }
+        line_of_sight_unit(v1f, los_targets, walls, residual, scratch.los, los_visible);
+        for (size_t k = 0; k < los_nodes.size(); ++k) {
+            if (los_visible[k]) {
+                candidate_edges.push_back({v1, nodes[los_nodes[k]]});
+                node_ij.push_back({i, los_nodes[k]});
+                node_dists.push_back((los_targets[k] - v1f).length());
+            } else
+                filtcount3 += 1;
+        }
+    }
+    for (size_t i = 0; i < candidate_edges.size(); ++i) {
+        bool edge_contains_another_edge = false;
+        for (size_t j = 0; j < candidate_edges.size(); ++j) {
+            if (i != j && line_contains_line(candidate_edges[i], candidate_edges[j])) {
+                edge_contains_another_edge = true;
+                break;
             }
         }
-        for (size_t i = 0; i < candidate_edges.size(); ++i) {
-            bool edge_contains_another_edge = false;
-            for (size_t j = 0; j < candidate_edges.size(); ++j) {
-                if (i != j && line_contains_line(candidate_edges[i], candidate_edges[j])) {
-                    edge_contains_another_edge = true;
-                    break;
+        if (!edge_contains_another_edge) {
+            filtered_ij.push_back(node_ij[i]);
+            filtered_dists.push_back(node_dists[i]);
+        }
+        else
+            filtcount4 += 1;
+    }
+    //
+    printf("region: %i (%zu edges, %i + %i + %i + %i filtered)\n", rid, filtered_ij.size(), filtcount1, filtcount2, filtcount3, filtcount4);
+    return get_region_graph(nodes, positions, filtered_ij, filtered_dists);
+}
+
+// radius (in tiles) = inflation + residual, with residual in [0, 1): the walls get dilated by every whole tile of
+// the radius, the rest is left to the node positions and the line of sight checks
+static int get_inflation(float radius) {
+    float radius_gridunits = radius / F_GRIDSIZE;
+    int inflation = std::max(0, static_cast<int>(std::floor(radius_gridunits + EPSILON)));
+    if (inflation >= MAX_CLEARANCE)
+        throw std::invalid_argument("unit radius " + std::to_string(radius) + " is too big for the clearance map");
+    return inflation;
+}
+
+// regions and corner nodes both come off the dilated walls, so every class has its own
+PathfindingGraph get_pathfinding_graph(float radius, const ChunkedGrid<uint8_t>& clearance, int resident_chunks) {
+    PROFILE_ZONE("get_pathfinding_graph");
+
+    //
+    // INFLATE WALLS FOR THIS UNIT SIZE
+    //
+
+    PathfindingGraph pf_graph;
+    pf_graph.radius = radius;
+    int inflation = get_inflation(radius);
+    pf_graph.inflation = inflation;
+    pf_graph.residual = std::max(radius / F_GRIDSIZE - static_cast<float>(inflation), 0.0f);
+    pf_graph.walls = WallBits::generate(clearance.width(), clearance.height(),
+                                        [&clearance, inflation](int x, int y) { return clearance.get(x, y) <= inflation; });
+    pf_graph.num_regions = label_regions(pf_graph.walls, pf_graph.tile_2_region_id, pf_graph.region_bounds, resident_chunks);
+    printf("radius %.1f: num_regions: %i\n", radius, pf_graph.num_regions);
+    int num_regions = pf_graph.num_regions;
+
+    //
+    // GET CANDIDATE PATHING NODES
+    //
+    
+    // nodes[region][i] = (x,y)
+    std::vector<std::vector<vec2<int>>> nodes(num_regions);
+    // blocked_corners[region][i] = val
+    // - val & 1 --> NW is blocked
+    // - val & 2 --> NE is blocked
+    // - val & 4 --> SW is blocked --- note that these last two are swapped compared to openbound
+    // - val & 8 --> SE is blocked ---
+    std::vector<std::vector<int>> blocked_corners(num_regions);
+    
+    for (const CornerNode& node : get_corner_nodes(pf_graph.walls)) {
+        int my_region_id = pf_graph.tile_2_region_id.get(node.position.x, node.position.y);
+        nodes[my_region_id].push_back(node.position);
+        blocked_corners[my_region_id].push_back(node.blocked_corners);
+    }
+
+    EdgeScratch scratch;
+    for (int rid = 0; rid < num_regions; ++rid)
+        pf_graph.regions.push_back(build_region_graph(rid, nodes[rid], blocked_corners[rid], pf_graph.walls, pf_graph.residual, scratch));
+
+    return pf_graph;
+}
+
+// one corner graph (and set of regions) per radius class, all sharing the clearance map
+static void add_radius_classes(PathfindingData& pf_data, const std::vector<float>& unit_radii) {
+    for (float radius : unit_radii) {
+        if (get_radius_class(pf_data, radius) >= 0)
+            continue;
+        double start_time = get_precise_time();
+        pf_data.radius_classes.push_back(get_pathfinding_graph(radius, pf_data.clearance, pf_data.resident_chunks));
+        double end_time = get_precise_time() - start_time;
+        const PathfindingGraph& pf_graph = pf_data.radius_classes.back();
+        printf("radius class %.1f (inflation %i): %zu bytes, built in %f seconds\n", radius, pf_graph.inflation, get_pathfinding_graph_bytes(pf_graph), end_time);
+    }
+}
+
+PathfindingData get_pathfinding_data(const WallBits& walls, const std::vector<float>& unit_radii, int resident_chunks) {
+    PROFILE_ZONE("get_pathfinding_data");
+    PathfindingData pf_data;
+    pf_data.walls = walls;
+    pf_data.clearance = get_clearance_map(walls, resident_chunks);
+    pf_data.resident_chunks = resident_chunks;
+    add_radius_classes(pf_data, unit_radii);
+    return pf_data;
+}
+
+// get_pathfinding_data for wall_dat after the tiles in changed_tiles flipped. the clearance map is redone around
+// the changed tiles (nothing further than MAX_CLEARANCE from one can change), then in every radius class only the
+// regions touched by its flipped inflated walls get relabelled, and only the graphs of the regions whose tiles or
+// inflated walls changed get rebuilt
+template <typename WallGrid>
+void update_pathfinding_data(PathfindingData& pf_data, const WallGrid& wall_dat, const std::vector<vec2<int>>& changed_tiles, const std::vector<float>& unit_radii) {
+    PROFILE_ZONE("update_pathfinding_data");
+    int width = pf_data.walls.width();
+    int height = pf_data.walls.height();
+    int x0 = width;
+    int y0 = height;
+    int x1 = -1;
+    int y1 = -1;
+    for (const vec2<int>& tile : changed_tiles) {
+        pf_data.walls.set(tile.x, tile.y, wall_dat[tile.x][tile.y]);
+        x0 = std::min(x0, tile.x);
+        y0 = std::min(y0, tile.y);
+        x1 = std::max(x1, tile.x);
+        y1 = std::max(y1, tile.y);
+    }
+    if (x1 < 0) {
+        add_radius_classes(pf_data, unit_radii);
+        return;
+    }
+
+    //
+    // clearance: every tile within MAX_CLEARANCE - 1 of the changed ones, from a window reaching MAX_CLEARANCE
+    // further so it sees every wall that could be their nearest
+    //
+    auto clip = [width, height](int cx0, int cy0, int cx1, int cy1) -> Rect {
+        cx0 = std::max(cx0, 0);
+        cy0 = std::max(cy0, 0);
+        cx1 = std::min(cx1, width - 1);
+        cy1 = std::min(cy1, height - 1);
+        return {{cx0, cy0}, {cx1 - cx0 + 1, cy1 - cy0 + 1}};
+    };
+    Rect area = clip(x0 - (MAX_CLEARANCE - 1), y0 - (MAX_CLEARANCE - 1), x1 + (MAX_CLEARANCE - 1), y1 + (MAX_CLEARANCE - 1));
+    Rect window = clip(x0 - (2 * MAX_CLEARANCE - 1), y0 - (2 * MAX_CLEARANCE - 1), x1 + (2 * MAX_CLEARANCE - 1), y1 + (2 * MAX_CLEARANCE - 1));
+    std::vector<uint8_t> window_clearance;
+    get_clearance_window(pf_data.walls, window, window_clearance);
+    // the tiles whose clearance changed, inclusive
+    int cx0 = width;
+    int cy0 = height;
+    int cx1 = -1;
+    int cy1 = -1;
+    for (int x = area.position.x; x < area.position.x + area.size.x; ++x) {
+        for (int y = area.position.y; y < area.position.y + area.size.y; ++y) {
+            uint8_t dist = window_clearance[(x - window.position.x) + (y - window.position.y) * window.size.x];
+            if (pf_data.clearance.get(x, y) != dist) {
+                pf_data.clearance.set(x, y, dist);
+                cx0 = std::min(cx0, x);
+                cy0 = std::min(cy0, y);
+                cx1 = std::max(cx1, x);
+                cy1 = std::max(cy1, y);
+            }
+        }
+    }
+
+    //
+    // per class, the regions are relabelled around the tiles whose inflated walls flipped. a region's graph only
+    // reads the inflated walls on and right next to its tiles (a line of sight stops at the first wall it meets),
+    // so it has to be redone if the relabelling touched it or a tile in or around it flipped
+    //
+    std::vector<vec2<int>> flipped_tiles;
+    std::vector<int> touched_ids;
+    std::vector<uint8_t> is_dirty;
+    std::vector<vec2<int>> nodes;
+    std::vector<int> blocked_corners;
+    EdgeScratch scratch;
+    for (PathfindingGraph& pf_graph : pf_data.radius_classes) {
+        double start_time = get_precise_time();
+        flipped_tiles.clear();
+        for (int x = cx0; x <= cx1; ++x) {
+            for (int y = cy0; y <= cy1; ++y) {
+                bool is_wall = pf_data.clearance.get(x, y) <= pf_graph.inflation;
+                if (pf_graph.walls.get(x, y) != is_wall) {
+                    pf_graph.walls.set(x, y, is_wall);
+                    flipped_tiles.push_back({x, y});
                 }
             }
-            if (!edge_contains_another_edge) {
-                filtered_edges.push_back(candidate_edges[i]);
-                graph[node_ij[i].x].push_back({node_ij[i].y, node_dists[i]});
-                graph[node_ij[i].y].push_back({node_ij[i].x, node_dists[i]});
+        }
+        if (flipped_tiles.empty())
+            continue;
+        pf_graph.num_regions = relabel_regions(pf_graph.walls, flipped_tiles, pf_graph.tile_2_region_id, pf_graph.region_bounds, touched_ids);
+        is_dirty.assign(pf_graph.num_regions, 0);
+        for (int id : touched_ids)
+            is_dirty[id] = 1;
+        for (const vec2<int>& tile : flipped_tiles) {
+            for (int nx = std::max(tile.x - 1, 0); nx <= std::min(tile.x + 1, width - 1); ++nx) {
+                for (int ny = std::max(tile.y - 1, 0); ny <= std::min(tile.y + 1, height - 1); ++ny) {
+                    int id = pf_graph.tile_2_region_id.get(nx, ny);
+                    if (id >= 0)
+                        is_dirty[id] = 1;
+                }
             }
-            else
-                filtcount4 += 1;
         }
-        edges.push_back(filtered_edges);
-        graphs.push_back(graph);
-        //
-        printf("region: %i (%zu edges, %i + %i + %i + %i filtered)\n", rid, filtered_edges.size(), filtcount1, filtcount2, filtcount3, filtcount4);
+        pf_graph.regions.resize(pf_graph.num_regions);
+        int num_rebuilt = 0;
+        for (int rid = 0; rid < pf_graph.num_regions; ++rid) {
+            if (!is_dirty[rid])
+                continue;
+            get_region_corner_nodes(pf_graph.walls, pf_graph.tile_2_region_id, rid, pf_graph.region_bounds[rid], nodes, blocked_corners);
+            pf_graph.regions[rid] = build_region_graph(rid, nodes, blocked_corners, pf_graph.walls, pf_graph.residual, scratch);
+            num_rebuilt += 1;
+        }
+        printf("radius class %.1f (inflation %i): %i of %i regions rebuilt in %f seconds\n", pf_graph.radius, pf_graph.inflation,
+               num_rebuilt, pf_graph.num_regions, get_precise_time() - start_time);
     }
+    add_radius_classes(pf_data, unit_radii);
+}
 
-    return {tile_2_region_id, num_regions, nodes, edges, graphs};
+int get_radius_class(const PathfindingData& pf_data, float radius) {
+    for (size_t i = 0; i < pf_data.radius_classes.size(); ++i) {
+        if (std::abs(pf_data.radius_classes[i].radius - radius) < EPSILON)
+            return i;
+    }
+    return -1;
+}
+
+size_t get_pathfinding_graph_bytes(const PathfindingGraph& pf_graph) {
+    size_t num_bytes = sizeof(PathfindingGraph);
+    num_bytes += pf_graph.walls.get_bytes();
+    for (const RegionGraph& region_graph : pf_graph.regions) {
+        num_bytes += sizeof(RegionGraph);
+        num_bytes += region_graph.nodes.capacity() * sizeof(vec2<int>);
+        num_bytes += region_graph.positions.capacity() * sizeof(vec2<float>);
+        num_bytes += region_graph.edge_starts.capacity() * sizeof(uint32_t);
+        num_bytes += region_graph.neighbours.capacity() * sizeof(graph_node_t);
+        num_bytes += region_graph.dists.capacity() * sizeof(uint16_t);
+    }
+    return num_bytes;
+}
+
+std::vector<Line> get_region_edges(const RegionGraph& region_graph) {
+    std::vector<Line> edges;
+    for (size_t i = 0; i < region_graph.nodes.size(); ++i) {
+        for (uint32_t k = region_graph.edge_starts[i]; k < region_graph.edge_starts[i + 1]; ++k) {
+            if (region_graph.neighbours[k] > i)
+                edges.push_back({region_graph.nodes[i], region_graph.nodes[region_graph.neighbours[k]]});
+        }
+    }
+    return edges;
 }
 
 //
-// big complicated function that does the actual pathfinding logic
+// big complicated function that does the actual pathfinding logic, in three parts for batching: prepare_path_query
+// (everything that reads the map), get_target_nodes (per destination) and find_path (per query, a*)
 //
 
-std::vector<vec2<int>> get_pathfinding_waypoints(const vec2<int>& start_pos,
-                                                 const vec2<int>& end_pos,
-                                                 const PathfindingData& pf_data,
-                                                 const Array2D<bool>& wall_dat) {
-    std::vector<vec2<int>> waypoints;
+// returns false if there's nothing to search: the query has no path, or a straight line to query.end_pos
+template <typename WallGrid>
+static bool prepare_path_query(const PathRequest& request, const PathfindingData& pf_data, const WallGrid& wall_dat,
+                               PathBatch& batch, PathQuery& query) {
+    const vec2<int>& start_pos = request.start_pos;
+    const vec2<int>& end_pos = request.end_pos;
+    float radius = request.radius;
+    query.radius_class = -1;
+    query.end_pos = NULL_VEC;
+
+    // no graph was built for this unit size
+    int radius_class = get_radius_class(pf_data, radius);
+    if (radius_class < 0)
+        return false;
+    const PathfindingGraph& pf_graph = pf_data.radius_classes[radius_class];
 
     // check if we clicked in our current region
     vec2<int> map_coords_start = {start_pos.x / GRIDSIZE, start_pos.y / GRIDSIZE}; // (ux,uy)
     vec2<int> map_coords_end = {end_pos.x / GRIDSIZE, end_pos.y / GRIDSIZE};       // (cx,cy)
-    int start_region = pf_data.tile_2_region_id[map_coords_start.x][map_coords_start.y];
-    int end_region = pf_data.tile_2_region_id[map_coords_end.x][map_coords_end.y];
+    int start_region = pf_graph.tile_2_region_id.get(map_coords_start.x, map_coords_start.y);
+    int end_region = pf_graph.tile_2_region_id.get(map_coords_end.x, map_coords_end.y);
 
     // if we're stuck in a wall we're not moving
     if (start_region < 0)
-        return waypoints;
+        return false;
 
     bool found_nearest_inbound_tile = false;
     if (start_region != end_region) {
@@ -235,164 +837,304 @@ std::vector<vec2<int>> get_pathfinding_waypoints(const vec2<int>& start_pos,
         //  - will modify map_coords_end if it finds a valid destination cel
         int width = wall_dat.width();
         int height = wall_dat.height();
-        Array2D<bool> visited(width, height, false);
+        // visited: bit x * height + y of bfs_visited
+        batch.bfs_visited.resize((static_cast<size_t>(width) * height + 63) / 64, 0);
+        std::vector<vec2<int>>& queue = batch.bfs_queue;
+        queue.clear();
         vec2<int> dv = end_pos - start_pos;
-        std::queue<vec2<int>> queue;
-        queue.push(map_coords_end);
+        queue.push_back(map_coords_end);
         vec2<int> found_tile = NULL_VEC;
-        while (!queue.empty()) {
-            vec2<int> current = queue.front();
-            queue.pop();
-            if (pf_data.tile_2_region_id[current.x][current.y] == start_region) {
+        for (size_t front = 0; front < queue.size(); ++front) {
+            vec2<int> current = queue[front];
+            if (pf_graph.tile_2_region_id.get(current.x, current.y) == start_region) {
                 found_tile = current;
                 break;
             }
             for (const auto& dir : MOVE_DIR) {
                 if (dir.x * dv.x <= 0 && dir.y * dv.y <= 0) {
                     vec2<int> next = current + dir;
-                    if (next.x >= 0 && next.x < width && next.y >= 0 && next.y < height && !visited[next.x][next.y]) {
-                        visited[next.x][next.y] = true;
-                        queue.push(next);
+                    size_t bit = static_cast<size_t>(next.x) * height + next.y;
+                    if (next.x >= 0 && next.x < width && next.y >= 0 && next.y < height &&
+                        !((batch.bfs_visited[bit / 64] >> (bit % 64)) & 1)) {
+                        batch.bfs_visited[bit / 64] |= uint64_t(1) << (bit % 64);
+                        queue.push_back(next);
                     }
                 }
             }
         }
+        for (const vec2<int>& tile : queue) {
+            size_t bit = static_cast<size_t>(tile.x) * height + tile.y;
+            batch.bfs_visited[bit / 64] &= ~(uint64_t(1) << (bit % 64));
+        }
         if (found_tile != NULL_VEC) {
             map_coords_end = found_tile;
             found_nearest_inbound_tile = true;
-            printf("clicked out of bounds, using nearest tile [bfs]: (%i,%i)\n", found_tile.x, found_tile.y);
         }
         // failed to find a valid destination so we're just not going to move, sorry!
         else
-            return waypoints;
+            return false;
     }
 
     //
     // nudge end coordinates to a valid position when clicking near a wall
     //
     vec2<int> nudged_end_pos = end_pos;
-    if (found_nearest_inbound_tile || !valid_player_position(end_pos, wall_dat)) {
+    if (found_nearest_inbound_tile || !valid_player_position(end_pos, wall_dat, radius)) {
         // starts with quantized pos --> nudges to desired pos
         vec2<int> nudged_pos = map_coords_end * GRIDSIZE + vec2<int>(GRIDSIZE/2, GRIDSIZE/2);
-        //
-        printf("nudging destination: (%i,%i) --> (%i,%i)", end_pos.x, end_pos.y, nudged_pos.x, nudged_pos.y);
         if (nudged_pos.x > end_pos.x) {
-            while (nudged_pos.x > end_pos.x && valid_player_position({nudged_pos.x - 1, nudged_pos.y}, wall_dat))
+            while (nudged_pos.x > end_pos.x && valid_player_position({nudged_pos.x - 1, nudged_pos.y}, wall_dat, radius))
                 nudged_pos.x--;
         }
         else if (nudged_pos.x < end_pos.x) {
-            while (nudged_pos.x < end_pos.x && valid_player_position({nudged_pos.x + 1, nudged_pos.y}, wall_dat))
+            while (nudged_pos.x < end_pos.x && valid_player_position({nudged_pos.x + 1, nudged_pos.y}, wall_dat, radius))
                 nudged_pos.x++;
         }
         if (nudged_pos.y > end_pos.y) {
-            while (nudged_pos.y > end_pos.y && valid_player_position({nudged_pos.x, nudged_pos.y - 1}, wall_dat))
+            while (nudged_pos.y > end_pos.y && valid_player_position({nudged_pos.x, nudged_pos.y - 1}, wall_dat, radius))
                 nudged_pos.y--;
         }
         else if (nudged_pos.y < end_pos.y) {
-            while (nudged_pos.y < end_pos.y && valid_player_position({nudged_pos.x, nudged_pos.y + 1}, wall_dat))
+            while (nudged_pos.y < end_pos.y && valid_player_position({nudged_pos.x, nudged_pos.y + 1}, wall_dat, radius))
                 nudged_pos.y++;
         }
         nudged_end_pos = nudged_pos;
-        printf(" --> (%i,%i)\n", nudged_end_pos.x, nudged_end_pos.y);
     }
+    query.end_pos = nudged_end_pos;
 
     //
     // check for a straight line between start and end
     //
-    vec2<float> fcoords_start = {static_cast<float>(start_pos.x) / F_GRIDSIZE,
-                                 static_cast<float>(start_pos.y) / F_GRIDSIZE};
-    vec2<float> fcoords_end = {static_cast<float>(nudged_end_pos.x) / F_GRIDSIZE,
-                               static_cast<float>(nudged_end_pos.y) / F_GRIDSIZE};
-    if (line_of_sight_unit(fcoords_start, fcoords_end, wall_dat)) {
-        waypoints.push_back(nudged_end_pos);
-        return waypoints;
-    }
+    query.fcoords_start = {static_cast<float>(start_pos.x) / F_GRIDSIZE,
+                           static_cast<float>(start_pos.y) / F_GRIDSIZE};
+    query.fcoords_end = {static_cast<float>(nudged_end_pos.x) / F_GRIDSIZE,
+                         static_cast<float>(nudged_end_pos.y) / F_GRIDSIZE};
+    if (line_of_sight_unit(query.fcoords_start, query.fcoords_end, pf_graph.walls, pf_graph.residual))
+        return false;
+    query.radius_class = radius_class;
+    query.region = start_region;
+    return true;
+}
 
-    //
-    // pathfinding
-    //
-    auto graph = pf_data.graphs[start_region]; // we need a copy because we're going to modify it
-    int num_nodes = pf_data.nodes[start_region].size();
+// which of the region's nodes can see the destination, and how far away they are (the a* heuristic)
+static void get_target_nodes(const PathfindingData& pf_data, PathTarget& target, LosScratch& los_scratch) {
+    const PathfindingGraph& pf_graph = pf_data.radius_classes[target.radius_class];
+    const RegionGraph& region_graph = pf_graph.regions[target.region];
+    int num_nodes = region_graph.nodes.size();
+    target.heuristic.resize(num_nodes);
+    for (int i = 0; i < num_nodes; ++i)
+        target.heuristic[i] = (region_graph.positions[i] - target.fcoords_end).length();
+    line_of_sight_unit(target.fcoords_end, region_graph.positions, pf_graph.walls, pf_graph.residual, los_scratch, target.visible);
+}
+
+// a* from the query's start to its target, appends the waypoints to scratch.waypoints
+static void find_path(const PathfindingData& pf_data, const PathQuery& query, const PathTarget& target, PathScratch& scratch) {
+    const PathfindingGraph& pf_graph = pf_data.radius_classes[query.radius_class];
+    const RegionGraph& region_graph = pf_graph.regions[query.region];
+    int num_nodes = region_graph.nodes.size();
     int starting_node = num_nodes;
     int ending_node = num_nodes+1;
 
-    // insert start and end positions into graph
-    // - also create astar heuristic since we're computing distances to the end node anyway
-    graph[starting_node] = std::vector<GraphNode>();
-    graph[ending_node] = std::vector<GraphNode>();
-    std::vector<float> heuristic;
-    for (int i = 0; i < num_nodes; ++i) {
-        vec2<float> fcoords_node = {static_cast<float>(pf_data.nodes[start_region][i].x) + 0.5f,
-                                    static_cast<float>(pf_data.nodes[start_region][i].y) + 0.5f};
-        if (line_of_sight_unit(fcoords_start, fcoords_node, wall_dat)) {
-            float dist_to_start_node = (fcoords_node - fcoords_start).length();
-            graph[starting_node].push_back({i, dist_to_start_node});
-            graph[i].push_back({starting_node, dist_to_start_node});
-        }
-        float dist_to_end_node = (fcoords_node - fcoords_end).length();
-        heuristic.push_back(dist_to_end_node);
-        if (line_of_sight_unit(fcoords_end, fcoords_node, wall_dat)) {
-            graph[ending_node].push_back({i, dist_to_end_node});
-            graph[i].push_back({ending_node, dist_to_end_node});
-        }
-    }
-    heuristic.push_back((fcoords_start - fcoords_end).length()); // starting_node
-    heuristic.push_back(0.0f);                                   // ending_node
+    // link the start to the nodes it can see (the region graph itself is read only, the end's links are the target's)
+    line_of_sight_unit(query.fcoords_start, region_graph.positions, pf_graph.walls, pf_graph.residual, scratch.los,
+                       scratch.visible_from_start);
+    scratch.start_dists.resize(num_nodes);
+    for (int i = 0; i < num_nodes; ++i)
+        scratch.start_dists[i] = (region_graph.positions[i] - query.fcoords_start).length();
 
-    //for (size_t i = 0; i < pf_data.nodes[start_region].size(); ++i)
-    //    printf("NODE %zu: (%i,%i)\n", i, pf_data.nodes[start_region][i].x, pf_data.nodes[start_region][i].y);
-    
     //
     // astar
     //
-    std::priority_queue<std::pair<int, float>, std::vector<std::pair<int, float>>, CompareNode> open_set;
-    std::unordered_map<int, int> came_from;
-    std::unordered_map<int, float> g_score;
-    std::unordered_map<int, float> f_score;
-
-    open_set.push({starting_node, 0});
-    g_score[starting_node] = 0;
-    f_score[starting_node] = heuristic[starting_node];
+    scratch.g_score.resize(num_nodes + 2);
+    scratch.came_from.resize(num_nodes + 2);
+    scratch.search_ids.resize(num_nodes + 2, 0);
+    if (++scratch.search_id == 0) {
+        std::fill(scratch.search_ids.begin(), scratch.search_ids.end(), 0);
+        scratch.search_id = 1;
+    }
+    std::vector<std::pair<int, float>>& open_set = scratch.open_set;  // a heap, like std::priority_queue keeps it
+    open_set.clear();
+    open_set.push_back({starting_node, 0});
+    scratch.search_ids[starting_node] = scratch.search_id;
+    scratch.g_score[starting_node] = 0;
 
-    std::vector<int> path;
+    std::vector<int>& path = scratch.path;
+    path.clear();
     while (!open_set.empty()) {
-        int current = open_set.top().first;
-        //printf("INSIDE ASTAR: %i %i \n", current, ending_node);
-        open_set.pop();
+        std::pop_heap(open_set.begin(), open_set.end(), CompareNode());
+        int current = open_set.back().first;
+        open_set.pop_back();
 
         if (current == ending_node) {
             while (current != starting_node) {
                 path.push_back(current);
-                current = came_from[current];
+                current = scratch.came_from[current];
             }
             path.push_back(starting_node);
             std::reverse(path.begin(), path.end());
             break;
         }
 
-        if (graph.find(current) == graph.end())
-            continue;
-
-        for (const auto& neighbor : graph.at(current)) {
-            float tentative_g_score = g_score[current] + neighbor.dist;
-            //printf("HELLO? %i g=%f\n", neighbor.node, tentative_g_score);
-            if (g_score.find(neighbor.node) == g_score.end() || tentative_g_score < g_score[neighbor.node]) {
-                came_from[neighbor.node] = current;
-                g_score[neighbor.node] = tentative_g_score;
-                f_score[neighbor.node] = g_score[neighbor.node] + heuristic[neighbor.node];
-                //printf("HELLO! %i g=%f h=%f f=%f\n", neighbor.node, g_score[neighbor.node], heuristic[neighbor.node], f_score[neighbor.node]);
-                open_set.push({neighbor.node, f_score[neighbor.node]});
+        auto visit = [&](int neighbor, float dist, float heuristic) {
+            float tentative_g_score = scratch.g_score[current] + dist;
+            if (scratch.search_ids[neighbor] != scratch.search_id || tentative_g_score < scratch.g_score[neighbor]) {
+                scratch.search_ids[neighbor] = scratch.search_id;
+                scratch.came_from[neighbor] = current;
+                scratch.g_score[neighbor] = tentative_g_score;
+                open_set.push_back({neighbor, tentative_g_score + heuristic});
+                std::push_heap(open_set.begin(), open_set.end(), CompareNode());
+            }
+        };
+        if (current == starting_node) {
+            for (int i = 0; i < num_nodes; ++i) {
+                if (scratch.visible_from_start[i])
+                    visit(i, scratch.start_dists[i], target.heuristic[i]);
             }
+            continue;
+        }
+        // the edge back to the start never helps, so a node's neighbours are its graph edges and maybe the end
+        for (uint32_t k = region_graph.edge_starts[current]; k < region_graph.edge_starts[current + 1]; ++k) {
+            int neighbor = region_graph.neighbours[k];
+            visit(neighbor, region_graph.dists[k] / GRAPH_DIST_SCALE, target.heuristic[neighbor]);
         }
+        if (target.visible[current])
+            visit(ending_node, target.heuristic[current], 0.0f);
     }
 
     for(size_t i = 0; i < path.size(); ++i){
         if (path[i] == ending_node)
-            waypoints.push_back(nudged_end_pos);
+            scratch.waypoints.push_back(query.end_pos);
         else if (path[i] != starting_node) {
-            waypoints.push_back(pf_data.nodes[start_region][path[i]] * GRIDSIZE + vec2<int>(GRIDSIZE / 2, GRIDSIZE / 2));
+            const vec2<float>& position = region_graph.positions[path[i]];
+            scratch.waypoints.push_back({static_cast<int>(std::lround(position.x * F_GRIDSIZE)),
+                                         static_cast<int>(std::lround(position.y * F_GRIDSIZE))});
         }
     }
+}
 
-    return waypoints;
+// work(begin, end, block) over [0, num_items) cut into num_blocks contiguous blocks, spread over the pool's
+// threads. without a pool everything runs here
+template <typename Work>
+static void run_blocks(WorkerPool* pool, int num_items, int num_blocks, const Work& work) {
+    auto run_block = [&](int block) {
+        work(num_items * block / num_blocks, num_items * (block + 1) / num_blocks, block);
+    };
+    if (pool != nullptr)
+        pool->run(num_blocks, run_block);
+    else {
+        for (int block = 0; block < num_blocks; ++block)
+            run_block(block);
+    }
 }
+
+static int get_num_blocks(int num_items, int num_threads) {
+    return std::max(1, std::min(num_threads, num_items / PATH_BATCH_MIN_QUERIES));
+}
+
+template <typename WallGrid>
+void get_pathfinding_waypoints(PathBatch& batch, const PathfindingData& pf_data, const WallGrid& wall_dat, WorkerPool* pool) {
+    PROFILE_ZONE("get_pathfinding_waypoints");
+    int num_threads = pool != nullptr ? pool->get_num_threads() : 1;
+    int num_requests = batch.requests.size();
+
+    //
+    // map reads, one request at a time (a ChunkedGrid pages on reads, so it can't be shared between threads).
+    // queries with the same graph, region and destination share a target
+    //
+    batch.queries.resize(num_requests);
+    int num_targets = 0;
+    std::map<std::tuple<int, int, int, int>, int> target_ids;
+    std::vector<int> searches;
+    for (int r = 0; r < num_requests; ++r) {
+        PathQuery& query = batch.queries[r];
+        query.num_waypoints = 0;
+        if (!prepare_path_query(batch.requests[r], pf_data, wall_dat, batch, query))
+            continue;
+        auto key = std::make_tuple(query.radius_class, query.region, query.end_pos.x, query.end_pos.y);
+        auto found = target_ids.find(key);
+        if (found == target_ids.end()) {
+            if (static_cast<int>(batch.targets.size()) <= num_targets)
+                batch.targets.resize(num_targets + 1);
+            PathTarget& target = batch.targets[num_targets];
+            target.radius_class = query.radius_class;
+            target.region = query.region;
+            target.fcoords_end = query.fcoords_end;
+            found = target_ids.insert({key, num_targets++}).first;
+        }
+        query.target = found->second;
+        searches.push_back(r);
+    }
+
+    //
+    // the targets' node visibility, then the searches
+    //
+    int num_searches = searches.size();
+    int num_target_blocks = get_num_blocks(num_targets, num_threads);
+    int num_blocks = get_num_blocks(num_searches, num_threads);
+    if (static_cast<int>(batch.workers.size()) < std::max(num_target_blocks, num_blocks))
+        batch.workers.resize(std::max(num_target_blocks, num_blocks));
+    run_blocks(pool, num_targets, num_target_blocks, [&](int begin, int end, int block) {
+        for (int t = begin; t < end; ++t)
+            get_target_nodes(pf_data, batch.targets[t], batch.workers[block].los);
+    });
+    run_blocks(pool, num_searches, num_blocks, [&](int begin, int end, int block) {
+        PathScratch& scratch = batch.workers[block];
+        scratch.waypoints.clear();
+        for (int s = begin; s < end; ++s) {
+            PathQuery& query = batch.queries[searches[s]];
+            query.block = block;
+            query.first_waypoint = scratch.waypoints.size();
+            find_path(pf_data, query, batch.targets[query.target], scratch);
+            query.num_waypoints = scratch.waypoints.size() - query.first_waypoint;
+        }
+    });
+
+    //
+    // results in request order
+    //
+    batch.waypoints.clear();
+    batch.starts.resize(num_requests + 1);
+    for (int r = 0; r < num_requests; ++r) {
+        const PathQuery& query = batch.queries[r];
+        batch.starts[r] = batch.waypoints.size();
+        if (query.radius_class < 0) {
+            // straight line
+            if (query.end_pos != NULL_VEC)
+                batch.waypoints.push_back(query.end_pos);
+        }
+        else {
+            const std::vector<vec2<int>>& block_waypoints = batch.workers[query.block].waypoints;
+            batch.waypoints.insert(batch.waypoints.end(), block_waypoints.begin() + query.first_waypoint,
+                                   block_waypoints.begin() + query.first_waypoint + query.num_waypoints);
+        }
+    }
+    batch.starts[num_requests] = batch.waypoints.size();
+    batch.num_searches = num_searches;
+    batch.num_targets = num_targets;
+}
+
+template <typename WallGrid>
+std::vector<vec2<int>> get_pathfinding_waypoints(const vec2<int>& start_pos,
+                                                 const vec2<int>& end_pos,
+                                                 const PathfindingData& pf_data,
+                                                 const WallGrid& wall_dat,
+                                                 float radius) {
+    PathBatch batch;
+    batch.requests.push_back({start_pos, end_pos, radius});
+    get_pathfinding_waypoints(batch, pf_data, wall_dat);
+    return batch.waypoints;
+}
+
+template bool line_of_sight_unit(const vec2<float>&, const vec2<float>&, const Array2D<bool>&, float);
+template bool line_of_sight_unit(const vec2<float>&, const vec2<float>&, const ChunkedGrid<bool>&, float);
+template bool line_of_sight_unit(const vec2<float>&, const vec2<float>&, const WallBits&, float);
+template bool valid_player_position(const vec2<int>&, const Array2D<bool>&, float);
+template bool valid_player_position(const vec2<int>&, const ChunkedGrid<bool>&, float);
+template bool valid_player_position_fixed(const vec2<fixed_t>&, const Array2D<bool>&, fixed_t);
+template bool valid_player_position_fixed(const vec2<fixed_t>&, const ChunkedGrid<bool>&, fixed_t);
+template std::vector<vec2<int>> get_pathfinding_waypoints(const vec2<int>&, const vec2<int>&, const PathfindingData&, const Array2D<bool>&, float);
+template std::vector<vec2<int>> get_pathfinding_waypoints(const vec2<int>&, const vec2<int>&, const PathfindingData&, const ChunkedGrid<bool>&, float);
+template void get_pathfinding_waypoints(PathBatch&, const PathfindingData&, const Array2D<bool>&, WorkerPool*);
+template void get_pathfinding_waypoints(PathBatch&, const PathfindingData&, const ChunkedGrid<bool>&, WorkerPool*);
+template void update_pathfinding_data(PathfindingData&, const Array2D<bool>&, const std::vector<vec2<int>>&, const std::vector<float>&);
+template void update_pathfinding_data(PathfindingData&, const ChunkedGrid<bool>&, const std::vector<vec2<int>>&, const std::vector<float>&);
@@ -1,23 +1,54 @@
 #pragma once
-#include <unordered_map>
+#include <cstdint>
+#include <utility>
 #include <vector>
 
 #include "Array2D.h"
+#include "ChunkedGrid.h"
+#include "fixed_point.h"
 #include "geometry.h"
 #include "globals.h"
 #include "Vec2.h"
+#include "WallBits.h"
+#include "WorkerPool.h"
 
-struct GraphNode {
-    int node;
-    float dist;
+typedef uint16_t graph_node_t;  // node id inside its region
+
+static const int MAX_REGION_NODES = 65536;
+static const int MAX_CLEARANCE = 64;  // clearance is stored capped at this, so no radius class can inflate by more
+static const float GRAPH_DIST_SCALE = 8.0f;  // graph edge lengths are stored in 1/8 tiles, rounded up
+
+// one region's corner graph, read only. the neighbours of node i are neighbours[edge_starts[i]] up to
+// neighbours[edge_starts[i+1]], with every edge stored once from each end (dists[k] goes with neighbours[k])
+struct RegionGraph {
+    std::vector<vec2<int>> nodes;          // corner tiles
+    std::vector<vec2<float>> positions;    // where the unit stands at each (grid units), see get_pathfinding_graph
+    std::vector<uint32_t> edge_starts;
+    std::vector<graph_node_t> neighbours;
+    std::vector<uint16_t> dists;
 };
 
+// corner graph for a single unit radius. walls are dilated by the whole tiles of the radius (read off the
+// clearance map), the fraction of a tile left over is kept as the residual half-size the line of sight checks
+// and node positions work with. regions are labelled on the dilated walls, so a corridor too narrow for this
+// size splits them
+struct PathfindingGraph {
+    float radius;         // unit radius (pixels)
+    int inflation;        // walls dilated by this many tiles
+    float residual;       // remaining unit half-size after inflation (grid units, < 1)
+    WallBits walls;       // the dilated walls
+    ChunkedGrid<int> tile_2_region_id;
+    int num_regions;      // region ids, some can be unused (left empty) after update_pathfinding_data
+    std::vector<Rect> region_bounds;
+    std::vector<RegionGraph> regions;
+};
+
+// everything here is either packed or chunked, nothing is kept a full map int (or bool) at a time
 struct PathfindingData {
-    Array2D<int> tile_2_region_id;
-    int num_regions;
-    std::vector<std::vector<vec2<int>>> nodes;
-    std::vector<std::vector<Line>> edges;
-    std::vector<std::unordered_map<int, std::vector<GraphNode>>> graphs;
+    WallBits walls;  // the map's
+    ChunkedGrid<uint8_t> clearance;  // clearance[x][y] = k --> (2k-1)x(2k-1) square centered on tile is open (0 = wall), up to MAX_CLEARANCE
+    int resident_chunks;             // decoded at a time, in each chunked grid
+    std::vector<PathfindingGraph> radius_classes;
 };
 
 struct BlockedDirections {
@@ -34,21 +65,113 @@ struct CompareNode {
     }
 };
 
-static const vec2<float> ADJ_LOS_UNIT[] = {{-(PLAYER_RADIUS_GRIDUNITS - EPSILON), -(PLAYER_RADIUS_GRIDUNITS - EPSILON)},
-                                           {-(PLAYER_RADIUS_GRIDUNITS - EPSILON),  (PLAYER_RADIUS_GRIDUNITS - EPSILON)},
-                                           { (PLAYER_RADIUS_GRIDUNITS - EPSILON), -(PLAYER_RADIUS_GRIDUNITS - EPSILON)},
-                                           { (PLAYER_RADIUS_GRIDUNITS - EPSILON),  (PLAYER_RADIUS_GRIDUNITS - EPSILON)}};
-
-static const vec2<float> ADJ_VALIDPOS[] = {{-(PLAYER_RADIUS - EPSILON), -(PLAYER_RADIUS - EPSILON)},
-                                           {-(PLAYER_RADIUS - EPSILON),  (PLAYER_RADIUS - EPSILON)},
-                                           { (PLAYER_RADIUS - EPSILON), -(PLAYER_RADIUS - EPSILON)},
-                                           { (PLAYER_RADIUS - EPSILON),  (PLAYER_RADIUS - EPSILON)}};
+// an open tile with a blocked diagonal neighbour between two open sides, see get_corner_nodes
+struct CornerNode {
+    vec2<int> position;
+    int blocked_corners;  // BlockedDirections
+};
 
 static const vec2<int> MOVE_DIR[] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
 
-bool line_of_sight_unit(const vec2<float>& v1, const vec2<float>& v2, const Array2D<bool>& wall_dat);
-bool valid_player_position(const vec2<int>& position, const Array2D<bool>& wall_dat);
+//
+// batched path queries: all requests of a tick go through get_pathfinding_waypoints(PathBatch&) together.
+// everything that reads the map runs first, one request after another. then the requests are grouped by
+// destination, and the nodes' visibility from it is found once per group. last, the start attachment and a*
+// run spread over a WorkerPool's threads. results come back in request order whatever the threads do
+//
+static const int PATH_BATCH_MIN_QUERIES = 8;  // per thread, fewer than this aren't worth handing one
+
+struct PathRequest {
+    vec2<int> start_pos;
+    vec2<int> end_pos;
+    float radius;
+};
+
+// a request after the map reads: which graph and region it searches, and where to
+struct PathQuery {
+    int radius_class;   // -1 when the result is already known (no path, or a straight line to end_pos)
+    int region;
+    vec2<int> end_pos;  // nudged off the walls
+    vec2<float> fcoords_start;
+    vec2<float> fcoords_end;
+    int target;         // into PathBatch::targets
+    int block;          // worker block the waypoints were written to, and where
+    int first_waypoint;
+    int num_waypoints;
+};
+
+// one destination in one region's graph, shared by every query headed there
+struct PathTarget {
+    int radius_class;
+    int region;
+    vec2<float> fcoords_end;
+    std::vector<uint8_t> visible;  // nodes that can see the destination
+    std::vector<float> heuristic;  // distance from each node to the destination
+};
+
+// the batched line_of_sight_unit's buffers, owned by the caller so a call doesn't allocate
+struct LosScratch {
+    std::vector<int> remaining;  // targets every ray so far could see
+    std::vector<vec2<float>> ray_targets;
+    std::vector<uint8_t> ray_visible;
+};
+
+// one worker's buffers, kept between batches
+struct PathScratch {
+    LosScratch los;
+    std::vector<uint8_t> visible_from_start;
+    std::vector<float> start_dists;
+    std::vector<float> g_score;
+    std::vector<int> came_from;
+    std::vector<uint32_t> search_ids;  // g_score/came_from only hold something where this is the current search
+    uint32_t search_id = 0;
+    std::vector<std::pair<int, float>> open_set;
+    std::vector<int> path;
+    std::vector<vec2<int>> waypoints;
+};
+
+struct PathBatch {
+    std::vector<PathRequest> requests;
+    // results: request r's waypoints are waypoints[starts[r]] up to waypoints[starts[r+1]], none if no path
+    std::vector<vec2<int>> waypoints;
+    std::vector<int> starts;
+    // the last batch's a* searches, and how many destination visibility sets (get_target_nodes) they shared
+    int num_searches = 0;
+    int num_targets = 0;
+    // scratch
+    std::vector<PathQuery> queries;
+    std::vector<PathTarget> targets;
+    std::vector<PathScratch> workers;
+    // the destination bfs: one visited bit per tile (cleared again after every search, from the queue), and the queue
+    std::vector<uint64_t> bfs_visited;
+    std::vector<vec2<int>> bfs_queue;
+};
+
+// the map queries take either an Array2D<bool> or a ChunkedGrid<bool> (instantiated for both in pathfinding.cpp,
+// line_of_sight_unit for WallBits too)
+template <typename WallGrid>
+bool line_of_sight_unit(const vec2<float>& v1, const vec2<float>& v2, const WallGrid& wall_dat, float half_size = PLAYER_RADIUS_GRIDUNITS);
+void line_of_sight_unit(const vec2<float>& v1, const std::vector<vec2<float>>& targets, const WallBits& walls, float half_size,
+                        LosScratch& scratch, std::vector<uint8_t>& out_visible);
+template <typename WallGrid>
+bool valid_player_position(const vec2<int>& position, const WallGrid& wall_dat, float radius = PLAYER_RADIUS);
+template <typename WallGrid>
+bool valid_player_position_fixed(const vec2<fixed_t>& position, const WallGrid& wall_dat, fixed_t radius);
 bool edge_has_good_incoming_angles(const vec2<int>& v1, const vec2<int>& v2, int corner1, int corner2);
 bool edge_never_turns_towards_wall(const vec2<int>& v1, const vec2<int>& v2, int corner1, int corner2);
-PathfindingData get_pathfinding_data(const Array2D<bool>& wall_dat);
-std::vector<vec2<int>> get_pathfinding_waypoints(const vec2<int>& start_pos, const vec2<int>& end_pos, const PathfindingData& pf_data, const Array2D<bool>& wall_dat);
+ChunkedGrid<uint8_t> get_clearance_map(const WallBits& walls, int resident_chunks = MAP_RESIDENT_CHUNKS);
+std::vector<CornerNode> get_corner_nodes(const WallBits& walls);
+std::vector<CornerNode> get_corner_nodes_scalar(const Array2D<bool>& wall_dat);
+PathfindingGraph get_pathfinding_graph(float radius, const ChunkedGrid<uint8_t>& clearance, int resident_chunks = MAP_RESIDENT_CHUNKS);
+PathfindingData get_pathfinding_data(const WallBits& walls, const std::vector<float>& unit_radii = {PLAYER_RADIUS}, int resident_chunks = MAP_RESIDENT_CHUNKS);
+// wall_dat only gets read at the changed tiles
+template <typename WallGrid>
+void update_pathfinding_data(PathfindingData& pf_data, const WallGrid& wall_dat, const std::vector<vec2<int>>& changed_tiles, const std::vector<float>& unit_radii = {PLAYER_RADIUS});
+int get_radius_class(const PathfindingData& pf_data, float radius);
+size_t get_pathfinding_graph_bytes(const PathfindingGraph& pf_graph);
+std::vector<Line> get_region_edges(const RegionGraph& region_graph);  // each edge once, in tiles (for drawing)
+template <typename WallGrid>
+std::vector<vec2<int>> get_pathfinding_waypoints(const vec2<int>& start_pos, const vec2<int>& end_pos, const PathfindingData& pf_data, const WallGrid& wall_dat, float radius = PLAYER_RADIUS);
+// resolves batch.requests into batch.waypoints/starts, spread over the pool's threads (all on this one without a pool)
+template <typename WallGrid>
+void get_pathfinding_waypoints(PathBatch& batch, const PathfindingData& pf_data, const WallGrid& wall_dat, WorkerPool* pool = nullptr);
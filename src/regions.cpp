@@ -0,0 +1,293 @@
+#include "regions.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "pathfinding.h"
+#include "Profiler.h"
+
+// open tiles x0..x1 of row y
+struct TileRun {
+    int y;
+    int x0;
+    int x1;
+};
+
+// one connected set of runs
+struct RunComponent {
+    int64_t key;  // x * height + y of its first tile off the border in x-major order, INT64_MAX if it has none
+    int x0, y0, x1, y1;
+    int min_old_id;
+    int id;
+};
+
+static int find_root(std::vector<int>& parent, int r) {
+    while (parent[r] != r) {
+        parent[r] = parent[parent[r]];
+        r = parent[r];
+    }
+    return r;
+}
+
+// the lower run (in scan order) stays the root
+static void unite(std::vector<int>& parent, int a, int b) {
+    a = find_root(parent, a);
+    b = find_root(parent, b);
+    if (a < b)
+        parent[b] = a;
+    else if (b < a)
+        parent[a] = b;
+}
+
+// runs come row by row (rows consecutive, runs sorted by x), row_starts[i] is where the i-th row's runs start
+// and row_starts.back() == runs.size(). returns each run's component index, components ordered by first run
+static std::vector<int> connect_runs(const std::vector<TileRun>& runs, const std::vector<int>& row_starts, int& num_components) {
+    std::vector<int> parent(runs.size());
+    for (size_t r = 0; r < runs.size(); ++r)
+        parent[r] = r;
+    for (size_t row = 1; row + 1 < row_starts.size(); ++row) {
+        int a = row_starts[row - 1];
+        int b = row_starts[row];
+        while (a < row_starts[row] && b < row_starts[row + 1]) {
+            if (runs[a].x1 >= runs[b].x0 && runs[b].x1 >= runs[a].x0)
+                unite(parent, a, b);
+            if (runs[a].x1 < runs[b].x1)
+                ++a;
+            else
+                ++b;
+        }
+    }
+    std::vector<int> component(runs.size());
+    num_components = 0;
+    for (size_t r = 0; r < runs.size(); ++r) {
+        int root = find_root(parent, r);
+        component[r] = root == static_cast<int>(r) ? num_components++ : component[root];
+    }
+    return component;
+}
+
+static std::vector<RunComponent> get_components(const std::vector<TileRun>& runs, const std::vector<int>& run_component,
+                                                int num_components, int width, int height) {
+    RunComponent empty = {INT64_MAX, width, height, -1, -1, INT32_MAX, -1};
+    std::vector<RunComponent> components(num_components, empty);
+    for (size_t r = 0; r < runs.size(); ++r) {
+        const TileRun& run = runs[r];
+        RunComponent& c = components[run_component[r]];
+        c.x0 = std::min(c.x0, run.x0);
+        c.y0 = std::min(c.y0, run.y);
+        c.x1 = std::max(c.x1, run.x1);
+        c.y1 = std::max(c.y1, run.y);
+        int ix0 = std::max(run.x0, 1);
+        if (run.y >= 1 && run.y <= height - 2 && ix0 <= std::min(run.x1, width - 2))
+            c.key = std::min(c.key, static_cast<int64_t>(ix0) * height + run.y);
+    }
+    return components;
+}
+
+// components that have a key, in key order
+static std::vector<int> get_region_order(const std::vector<RunComponent>& components) {
+    std::vector<int> order;
+    for (size_t c = 0; c < components.size(); ++c) {
+        if (components[c].key != INT64_MAX)
+            order.push_back(c);
+    }
+    std::sort(order.begin(), order.end(), [&components](int a, int b) { return components[a].key < components[b].key; });
+    return order;
+}
+
+static Rect get_bounds(const RunComponent& c) {
+    return {{c.x0, c.y0}, {c.x1 - c.x0 + 1, c.y1 - c.y0 + 1}};
+}
+
+int label_regions(const WallBits& walls, ChunkedGrid<int>& labels, std::vector<Rect>& bounds, int resident_chunks) {
+    PROFILE_ZONE("label_regions");
+    int width = walls.width();
+    int height = walls.height();
+    std::vector<TileRun> runs;
+    std::vector<int> row_starts;
+    for (int y = 0; y < height; ++y) {
+        row_starts.push_back(runs.size());
+        for (int x = walls.next_open(0, y); x < width; x = walls.next_open(x, y)) {
+            int end = walls.next_wall(x, y);
+            runs.push_back({y, x, end - 1});
+            x = end;
+        }
+    }
+    row_starts.push_back(runs.size());
+
+    int num_components = 0;
+    std::vector<int> run_component = connect_runs(runs, row_starts, num_components);
+    std::vector<RunComponent> components = get_components(runs, run_component, num_components, width, height);
+    std::vector<int> order = get_region_order(components);
+    bounds.clear();
+    for (int c : order) {
+        components[c].id = bounds.size();
+        bounds.push_back(get_bounds(components[c]));
+    }
+
+    // the runs are already in the x + y * width order the chunks get filled in
+    size_t r = 0;
+    int x = 0;
+    int y = 0;
+    auto next_label = [&]() {
+        while (r < runs.size() && (runs[r].y < y || (runs[r].y == y && runs[r].x1 < x)))
+            ++r;
+        int id = -1;
+        if (r < runs.size() && runs[r].y == y && runs[r].x0 <= x)
+            id = components[run_component[r]].id;
+        if (++x == width) {
+            x = 0;
+            y += 1;
+        }
+        return id;
+    };
+    labels = ChunkedGrid<int>::generate(width, height, next_label, resident_chunks);
+    return bounds.size();
+}
+
+int relabel_regions(const WallBits& walls, const std::vector<vec2<int>>& changed_tiles, ChunkedGrid<int>& labels, std::vector<Rect>& bounds,
+                    std::vector<int>& touched_ids) {
+    PROFILE_ZONE("relabel_regions");
+    touched_ids.clear();
+    int width = walls.width();
+    int height = walls.height();
+    int num_ids = bounds.size();
+
+    //
+    // which regions touched a changed tile, and the area they (and the changed tiles) cover
+    //
+    std::vector<uint8_t> is_affected(num_ids, 0);
+    int ax0 = width;
+    int ay0 = height;
+    int ax1 = -1;
+    int ay1 = -1;
+    auto grow = [&](int x0, int y0, int x1, int y1) {
+        ax0 = std::max(std::min(ax0, x0), 0);
+        ay0 = std::max(std::min(ay0, y0), 0);
+        ax1 = std::min(std::max(ax1, x1), width - 1);
+        ay1 = std::min(std::max(ay1, y1), height - 1);
+    };
+    auto affect = [&](int id) {
+        if (id < 0 || is_affected[id])
+            return;
+        is_affected[id] = 1;
+        const Rect& b = bounds[id];
+        grow(b.position.x, b.position.y, b.position.x + b.size.x - 1, b.position.y + b.size.y - 1);
+    };
+    // changed tiles are marked -2 while we work, so they can be told apart from pockets along the border
+    std::vector<vec2<int>> changed;
+    for (const vec2<int>& tile : changed_tiles) {
+        if (tile.x < 0 || tile.x >= width || tile.y < 0 || tile.y >= height || labels.get(tile.x, tile.y) == -2)
+            continue;
+        affect(labels.get(tile.x, tile.y));
+        labels.set(tile.x, tile.y, -2);
+        changed.push_back(tile);
+        grow(tile.x - 1, tile.y - 1, tile.x + 1, tile.y + 1);
+    }
+    if (changed.empty())
+        return num_ids;
+    bool has_pocket = false;
+    for (const vec2<int>& tile : changed) {
+        for (const vec2<int>& dir : MOVE_DIR) {
+            vec2<int> next = tile + dir;
+            if (next.x < 0 || next.x >= width || next.y < 0 || next.y >= height)
+                continue;
+            int id = labels.get(next.x, next.y);
+            affect(id);
+            if (id == -1 && !walls.get(next.x, next.y))
+                has_pocket = true;
+        }
+    }
+    // a pocket can run along the whole border, so joining one means looking at everything
+    if (has_pocket)
+        grow(0, 0, width - 1, height - 1);
+
+    //
+    // label the open tiles in there that belonged to an affected region, a pocket or nothing. a run of open tiles
+    // is connected, so either all of it is in (then it's connected to something that touched a changed tile) or
+    // none of it is, and looking at its first tile is enough
+    //
+    std::vector<TileRun> runs;
+    std::vector<int> row_starts;
+    for (int y = ay0; y <= ay1; ++y) {
+        row_starts.push_back(runs.size());
+        for (int x = walls.next_open(ax0, y); x <= ax1; x = walls.next_open(x, y)) {
+            int end = std::min(walls.next_wall(x, y), ax1 + 1);
+            int id = labels.get(x, y);
+            if (id < 0 || is_affected[id])
+                runs.push_back({y, x, end - 1});
+            x = end;
+        }
+    }
+    row_starts.push_back(runs.size());
+    int num_components = 0;
+    std::vector<int> run_component = connect_runs(runs, row_starts, num_components);
+    std::vector<RunComponent> components = get_components(runs, run_component, num_components, width, height);
+    // the old ids along a run only change at a changed tile, so the run starts and the tiles right after the
+    // changed ones are all the old ids there are
+    auto add_old_id = [&](int r, int x) {
+        int id = labels.get(x, runs[r].y);
+        if (id >= 0)
+            components[run_component[r]].min_old_id = std::min(components[run_component[r]].min_old_id, id);
+    };
+    for (size_t r = 0; r < runs.size(); ++r)
+        add_old_id(r, runs[r].x0);
+    for (const vec2<int>& tile : changed) {
+        if (tile.x + 1 > ax1)
+            continue;
+        int row = tile.y - ay0;
+        int r = std::upper_bound(runs.begin() + row_starts[row], runs.begin() + row_starts[row + 1], tile.x + 1,
+                                 [](int x, const TileRun& run) { return x < run.x0; }) - runs.begin() - 1;
+        if (r >= row_starts[row] && runs[r].x1 >= tile.x + 1)
+            add_old_id(r, tile.x + 1);
+    }
+
+    //
+    // hand out ids: every region keeps the lowest id it had if nobody earlier took it, the rest get ids that were
+    // given up (merged away) or new ones
+    //
+    std::vector<int> order = get_region_order(components);
+    std::vector<uint8_t> is_claimed(num_ids, 0);
+    for (int c : order) {
+        int id = components[c].min_old_id;
+        if (id != INT32_MAX && !is_claimed[id]) {
+            is_claimed[id] = 1;
+            components[c].id = id;
+        }
+    }
+    int next_free = 0;
+    for (int c : order) {
+        if (components[c].id >= 0)
+            continue;
+        while (next_free < num_ids && (!is_affected[next_free] || is_claimed[next_free]))
+            ++next_free;
+        if (next_free < num_ids) {
+            is_claimed[next_free] = 1;
+            components[c].id = next_free;
+        }
+        else {
+            components[c].id = bounds.size();
+            bounds.push_back(Rect());
+        }
+    }
+    for (int id = 0; id < num_ids; ++id) {
+        if (is_affected[id] && !is_claimed[id])
+            bounds[id] = {{0, 0}, {0, 0}};
+        if (is_affected[id])
+            touched_ids.push_back(id);
+    }
+    for (int c : order) {
+        bounds[components[c].id] = get_bounds(components[c]);
+        if (components[c].id >= num_ids || !is_affected[components[c].id])
+            touched_ids.push_back(components[c].id);
+    }
+
+    for (const vec2<int>& tile : changed)
+        labels.set(tile.x, tile.y, -1);
+    for (size_t r = 0; r < runs.size(); ++r) {
+        int id = components[run_component[r]].id;
+        for (int x = runs[r].x0; x <= runs[r].x1; ++x)
+            labels.set(x, runs[r].y, id);
+    }
+    return bounds.size();
+}
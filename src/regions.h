@@ -0,0 +1,24 @@
+#pragma once
+#include <vector>
+
+#include "ChunkedGrid.h"
+#include "geometry.h"
+#include "Vec2.h"
+#include "WallBits.h"
+
+//
+// region detection for pathfinding: 4-connected open tiles, found with a two pass scanline labeller (union-find
+// over each row's runs of open tiles, read straight off the packed walls). only a component with a tile off the
+// map border gets a region id, pockets along the border stay -1 like the walls. ids go in x-major order of each
+// region's first such tile, which is the order the old flood fill found them in.
+//
+// labels[x][y] is the region id (streamed into the chunks, resident_chunks of them decoded at a time), bounds[id]
+// the tiles it covers. returns the number of regions
+int label_regions(const WallBits& walls, ChunkedGrid<int>& labels, std::vector<Rect>& bounds, int resident_chunks = MAP_RESIDENT_CHUNKS);
+
+// after the tiles in changed_tiles flipped in walls: relabels only the regions that touched them (split ones get
+// extra ids, merged ones give theirs up and are left empty, so ids no longer have to be contiguous). touched_ids
+// gets every id whose tiles may have changed, those regions and the ids handed out. returns the new number of
+// region ids
+int relabel_regions(const WallBits& walls, const std::vector<vec2<int>>& changed_tiles, ChunkedGrid<int>& labels, std::vector<Rect>& bounds,
+                    std::vector<int>& touched_ids);
@@ -0,0 +1,66 @@
+#include "tile_rle.h"
+
+#include <stdexcept>
+
+std::string encode_tile_rle(const std::vector<int>& tiles) {
+    std::string out;
+    size_t i = 0;
+    while (i < tiles.size()) {
+        size_t run_end = i + 1;
+        while (run_end < tiles.size() && tiles[run_end] == tiles[i])
+            run_end += 1;
+        if (!out.empty())
+            out += ' ';
+        out += std::to_string(tiles[i]);
+        if (run_end - i > 1)
+            out += '*' + std::to_string(run_end - i);
+        i = run_end;
+    }
+    return out;
+}
+
+TileRunDecoder::TileRunDecoder(const std::string& text) : text(text) {}
+
+long long TileRunDecoder::parse_number() {
+    if (pos >= text.size() || text[pos] < '0' || text[pos] > '9')
+        throw std::invalid_argument("Invalid tile_dat_rle");
+    long long number = 0;
+    while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+        number = 10 * number + (text[pos] - '0');
+        if (number > 0x7fffffff)
+            throw std::invalid_argument("Invalid tile_dat_rle");
+        pos += 1;
+    }
+    return number;
+}
+
+int TileRunDecoder::next() {
+    if (remaining == 0) {
+        while (pos < text.size() && text[pos] == ' ')
+            pos += 1;
+        if (pos >= text.size())
+            throw std::invalid_argument("tile_dat_rle has fewer tiles than the map");
+        value = parse_number();
+        remaining = 1;
+        if (pos < text.size() && text[pos] == '*') {
+            pos += 1;
+            remaining = parse_number();
+            if (remaining == 0)
+                throw std::invalid_argument("Invalid tile_dat_rle");
+        }
+        if (pos < text.size() && text[pos] != ' ')
+            throw std::invalid_argument("Invalid tile_dat_rle");
+    }
+    remaining -= 1;
+    return value;
+}
+
+bool TileRunDecoder::at_end() const {
+    if (remaining > 0)
+        return false;
+    for (size_t i = pos; i < text.size(); ++i) {
+        if (text[i] != ' ')
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include <vector>
+
+//
+// run length encoded tile_dat for map json ("tile_dat_rle"). same x + y * width order as tile_dat, written as
+// space separated runs: "7" is a single tile 7, "1*50" is fifty 1s. no sdl in here, the map tools use it too.
+//
+std::string encode_tile_rle(const std::vector<int>& tiles);
+
+// hands out the tiles one at a time, so nothing has to hold the whole map decoded
+class TileRunDecoder {
+private:
+    const std::string& text;
+    size_t pos = 0;
+    int value = 0;
+    long long remaining = 0; // tiles left in the current run
+
+    long long parse_number();
+
+public:
+    explicit TileRunDecoder(const std::string& text);
+    int next();          // throws std::invalid_argument on bad syntax or when out of tiles
+    bool at_end() const; // every run used up
+};
@@ -0,0 +1,286 @@
+#include "map_generator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+
+#include "tile_rle.h"
+
+using json = nlohmann::json;
+
+// std::uniform_*_distribution differ between standard libraries, so roll our own on top of mt19937
+static int random_int(std::mt19937& rng, int n) {
+    return static_cast<int>(rng() % static_cast<uint32_t>(n));
+}
+
+static float random_float(std::mt19937& rng) {
+    return (rng() & 0xFFFFFF) / 16777216.0f;
+}
+
+//
+// the map is a grid of cells (corridor_width x corridor_width open tiles) separated by 1 tile walls. each
+// region gets a perfect maze carved by a depth-first search, then walls between cells of the same region are
+// knocked out with probability 1 - maze_density to add loops. walls between regions are never opened.
+//
+class MazeBuilder {
+private:
+    const MapGenParams& params;
+    std::mt19937& rng;
+    int pitch;
+    int cells_x;
+    int cells_y;
+    std::vector<int> cell_region;
+    std::vector<uint8_t> right_open;
+    std::vector<uint8_t> down_open;
+
+public:
+    GeneratedMap map;
+
+    MazeBuilder(const MapGenParams& params, std::mt19937& rng) :
+        params(params),
+        rng(rng),
+        pitch(params.corridor_width + 1),
+        cells_x((params.width - 1) / (params.corridor_width + 1)),
+        cells_y((params.height - 1) / (params.corridor_width + 1)) {
+        map.width = params.width;
+        map.height = params.height;
+        map.tile_dat.assign(static_cast<size_t>(params.width) * params.height, MAPGEN_TILE_WALL);
+        cell_region.resize(cells_x * cells_y);
+        right_open.assign(cells_x * cells_y, 0);
+        down_open.assign(cells_x * cells_y, 0);
+    }
+
+    int get_num_regions() const {
+        return std::min(params.num_regions, cells_x);
+    }
+
+    // top left tile of a cell
+    int get_cell_tile_x(int cell) const {
+        return 1 + (cell % cells_x) * pitch;
+    }
+
+    int get_cell_tile_y(int cell) const {
+        return 1 + (cell / cells_x) * pitch;
+    }
+
+    void set_tile(int x, int y, int tile) {
+        map.tile_dat[x + static_cast<size_t>(y) * map.width] = tile;
+    }
+
+    int get_tile(int x, int y) const {
+        return map.tile_dat[x + static_cast<size_t>(y) * map.width];
+    }
+
+    void open_cell(int cell) {
+        int x0 = get_cell_tile_x(cell);
+        int y0 = get_cell_tile_y(cell);
+        for (int x = x0; x < x0 + params.corridor_width; ++x) {
+            for (int y = y0; y < y0 + params.corridor_width; ++y)
+                set_tile(x, y, MAPGEN_TILE_BLANK);
+        }
+    }
+
+    // knock out the wall between cell and its right (dx = 1) or lower (dy = 1) neighbour
+    void open_wall(int cell, bool right) {
+        int x0 = get_cell_tile_x(cell);
+        int y0 = get_cell_tile_y(cell);
+        for (int k = 0; k < params.corridor_width; ++k) {
+            if (right)
+                set_tile(x0 + params.corridor_width, y0 + k, MAPGEN_TILE_BLANK);
+            else
+                set_tile(x0 + k, y0 + params.corridor_width, MAPGEN_TILE_BLANK);
+        }
+        if (right)
+            right_open[cell] = 1;
+        else
+            down_open[cell] = 1;
+    }
+
+    void carve() {
+        int num_regions = get_num_regions();
+        for (int cell = 0; cell < cells_x * cells_y; ++cell) {
+            cell_region[cell] = (cell % cells_x) * num_regions / cells_x;
+            open_cell(cell);
+        }
+        // iterative dfs, one maze per region
+        std::vector<uint8_t> visited(cells_x * cells_y, 0);
+        std::vector<int> stack;
+        for (int region = 0; region < num_regions; ++region) {
+            int col_start = (region * cells_x + num_regions - 1) / num_regions;
+            int col_end = ((region + 1) * cells_x + num_regions - 1) / num_regions;
+            int first_cell = random_int(rng, cells_y) * cells_x + col_start + random_int(rng, col_end - col_start);
+            visited[first_cell] = 1;
+            stack.push_back(first_cell);
+            while (!stack.empty()) {
+                int cell = stack.back();
+                int cx = cell % cells_x;
+                int cy = cell / cells_x;
+                int neighbours[4];
+                int num_neighbours = 0;
+                const int dirs[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+                for (const auto& d : dirs) {
+                    int nx = cx + d[0];
+                    int ny = cy + d[1];
+                    if (nx < 0 || nx >= cells_x || ny < 0 || ny >= cells_y)
+                        continue;
+                    int n = nx + ny * cells_x;
+                    if (!visited[n] && cell_region[n] == region)
+                        neighbours[num_neighbours++] = n;
+                }
+                if (num_neighbours == 0) {
+                    stack.pop_back();
+                    continue;
+                }
+                int n = neighbours[random_int(rng, num_neighbours)];
+                if (n == cell + 1)
+                    open_wall(cell, true);
+                else if (n == cell - 1)
+                    open_wall(n, true);
+                else if (n == cell + cells_x)
+                    open_wall(cell, false);
+                else
+                    open_wall(n, false);
+                visited[n] = 1;
+                stack.push_back(n);
+            }
+        }
+        // loops
+        float p_open = 1.0f - params.maze_density;
+        for (int cell = 0; cell < cells_x * cells_y; ++cell) {
+            int cx = cell % cells_x;
+            int cy = cell / cells_x;
+            if (cx + 1 < cells_x && !right_open[cell] && cell_region[cell + 1] == cell_region[cell] && random_float(rng) < p_open)
+                open_wall(cell, true);
+            if (cy + 1 < cells_y && !down_open[cell] && random_float(rng) < p_open)
+                open_wall(cell, false);
+        }
+    }
+
+    // short horizontal runs of conveyor over open tiles
+    void add_conveyors() {
+        const int run_length = 4;
+        float p_start = params.conveyor_fraction / run_length;
+        for (int y = 1; y < map.height - 1; ++y) {
+            for (int x = 1; x < map.width - 1; ++x) {
+                if (get_tile(x, y) != MAPGEN_TILE_BLANK || random_float(rng) >= p_start)
+                    continue;
+                for (int k = 0; k < run_length && x + k < map.width - 1 && get_tile(x + k, y) == MAPGEN_TILE_BLANK; ++k)
+                    set_tile(x + k, y, MAPGEN_TILE_CONVEYOR);
+            }
+        }
+    }
+
+    int get_random_cell(int region) {
+        while (true) {
+            int cell = random_int(rng, cells_x * cells_y);
+            if (cell_region[cell] == region)
+                return cell;
+        }
+    }
+
+    // pixel rect covering a cell: [left, top, width, height]
+    std::vector<int> get_cell_rect(int cell) const {
+        int size = params.corridor_width * MAPGEN_GRIDSIZE;
+        return {get_cell_tile_x(cell) * MAPGEN_GRIDSIZE, get_cell_tile_y(cell) * MAPGEN_GRIDSIZE, size, size};
+    }
+
+    void add_obstacles() {
+        map.obstacles = json::object();
+        int num_regions = get_num_regions();
+        for (int ob = 1; ob <= params.num_obstacles; ++ob) {
+            int region = (ob - 1) % num_regions;
+            json value;
+            std::vector<int> startbox = get_cell_rect(get_random_cell(region));
+            value["startbox"] = startbox;
+            value["endbox"] = get_cell_rect(get_random_cell(region));
+            value["revive"] = {startbox[0] + startbox[2] / 2, startbox[1] + startbox[3] / 2};
+            value["action_moveplayer"] = 0;
+            value["action_addlives"] = 0;
+            value["action_changemusic"] = "";
+            for (int loc = 1; loc <= params.locs_per_obstacle; ++loc)
+                value["loc_" + std::to_string(loc)] = get_cell_rect(get_random_cell(region));
+            for (int exp = 1; exp <= params.exps_per_obstacle && params.locs_per_obstacle > 0; ++exp) {
+                // a handful of distinct locs per explosion
+                std::vector<int> all_locs;
+                for (int loc = 1; loc <= params.locs_per_obstacle; ++loc)
+                    all_locs.push_back(loc);
+                int num_locs = 1 + random_int(rng, std::min(4, params.locs_per_obstacle));
+                std::vector<int> loc_list;
+                std::vector<std::string> unit_list;
+                for (int k = 0; k < num_locs; ++k) {
+                    int pick = k + random_int(rng, all_locs.size() - k);
+                    std::swap(all_locs[k], all_locs[pick]);
+                    loc_list.push_back(all_locs[k]);
+                    unit_list.push_back("small_blue");
+                }
+                std::sort(loc_list.begin(), loc_list.end());
+                int delay = 2 + random_int(rng, 20);
+                value["exp_" + std::to_string(exp)] = {loc_list, unit_list, delay};
+            }
+            map.obstacles["obstacle_" + std::to_string(ob)] = value;
+        }
+    }
+
+    void add_start_pos() {
+        int cell = get_random_cell(0);
+        map.start_pos = {get_cell_tile_x(cell) + params.corridor_width / 2, get_cell_tile_y(cell) + params.corridor_width / 2};
+        // never start on a conveyor
+        for (int x = get_cell_tile_x(cell); x < get_cell_tile_x(cell) + params.corridor_width; ++x) {
+            for (int y = get_cell_tile_y(cell); y < get_cell_tile_y(cell) + params.corridor_width; ++y)
+                set_tile(x, y, MAPGEN_TILE_BLANK);
+        }
+    }
+};
+
+GeneratedMap generate_map(const MapGenParams& params) {
+    if (params.width < 3 || params.height < 3 || params.width > MAPGEN_MAX_SIZE || params.height > MAPGEN_MAX_SIZE)
+        throw std::invalid_argument("map dimensions must be between 3 and " + std::to_string(MAPGEN_MAX_SIZE));
+    if (params.corridor_width < 1 || params.corridor_width + 2 > std::min(params.width, params.height))
+        throw std::invalid_argument("corridor_width does not fit in the map");
+    if (params.num_regions < 1)
+        throw std::invalid_argument("num_regions must be at least 1");
+    std::mt19937 rng(params.seed);
+    MazeBuilder builder(params, rng);
+    builder.carve();
+    builder.add_conveyors();
+    builder.add_start_pos();
+    builder.add_obstacles();
+    return builder.map;
+}
+
+// same layout as the hand made maps: header fields, tile_dat one row per line, then obstacles
+void write_map_json(const GeneratedMap& map, const MapGenParams& params, const std::string& filename, bool use_rle) {
+    std::ofstream out(filename);
+    if (!out)
+        throw std::invalid_argument("could not open " + filename + " for writing");
+    out << "{\n";
+    out << "    \"map_name\":   " << json(params.name).dump() << ",\n";
+    out << "    \"map_author\": \"mapgen\",\n";
+    out << "    \"map_notes\":  " << json("seed " + std::to_string(params.seed)).dump() << ",\n";
+    out << "    \"tileset\":    \"assets/tile_data.json\",\n";
+    out << "    \"difficulty\": 5,\n";
+    out << "    \"map_width\":  " << map.width << ",\n";
+    out << "    \"map_height\": " << map.height << ",\n";
+    out << "    \"init_lives\": 100,\n";
+    out << "    \"start_pos\":  [" << map.start_pos[0] << "," << map.start_pos[1] << "],\n";
+    if (use_rle)
+        out << "    \"tile_dat_rle\": \"" << encode_tile_rle(map.tile_dat) << "\"";
+    else {
+        out << "    \"tile_dat\":   [";
+        for (int y = 0; y < map.height; ++y) {
+            if (y > 0)
+                out << "                   ";
+            for (int x = 0; x < map.width; ++x) {
+                out << map.tile_dat[x + static_cast<size_t>(y) * map.width];
+                if (x < map.width - 1 || y < map.height - 1)
+                    out << ",";
+            }
+            out << (y < map.height - 1 ? "\n" : "]");
+        }
+    }
+    for (auto it = map.obstacles.begin(); it != map.obstacles.end(); ++it)
+        out << ",\n    \"" << it.key() << "\": " << it.value().dump();
+    out << "\n}\n";
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+static const int MAPGEN_MAX_SIZE = 4096;
+static const int MAPGEN_TILE_BLANK = 0;     // tile ids from assets/tile_data.json
+static const int MAPGEN_TILE_WALL = 1;
+static const int MAPGEN_TILE_CONVEYOR = 2;
+static const int MAPGEN_GRIDSIZE = 16;      // pixels per tile (locations and boxes are in pixels)
+
+struct MapGenParams {
+    std::string name = "generated";
+    int width = 256;
+    int height = 256;
+    unsigned int seed = 1;
+    int corridor_width = 2;          // tiles
+    float maze_density = 0.7f;       // 1 = perfect maze (no loops), 0 = every wall between cells knocked out
+    int num_regions = 1;             // disconnected vertical strips
+    float conveyor_fraction = 0.02f; // rough fraction of open tiles turned into conveyors
+    int num_obstacles = 4;
+    int locs_per_obstacle = 8;
+    int exps_per_obstacle = 6;
+};
+
+struct GeneratedMap {
+    int width;
+    int height;
+    std::vector<int> tile_dat;  // tile_dat[x + y * width], same layout as the map json
+    std::vector<int> start_pos; // tiles
+    nlohmann::json obstacles;   // {"obstacle_1": {...}, ...}
+};
+
+// same params + seed --> same map (only relies on std::mt19937's output, which the standard pins down)
+GeneratedMap generate_map(const MapGenParams& params);
+void write_map_json(const GeneratedMap& map, const MapGenParams& params, const std::string& filename, bool use_rle = false); // tile_dat_rle instead of tile_dat
@@ -0,0 +1,76 @@
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include "map_generator.h"
+
+static void print_usage() {
+    printf("usage: openbound_mapgen [options] output.json\n"
+           "  --name NAME            map_name (default generated)\n"
+           "  --size W H             map size in tiles, up to %i (default 256 256)\n"
+           "  --seed N               rng seed (default 1)\n"
+           "  --corridor N           corridor width in tiles (default 2)\n"
+           "  --density F            maze density, 1 = no loops, 0 = wide open (default 0.7)\n"
+           "  --regions N            number of disconnected regions (default 1)\n"
+           "  --conveyors F          fraction of open tiles that are conveyors (default 0.02)\n"
+           "  --obstacles N          number of obstacle_N blocks (default 4)\n"
+           "  --locs N               loc_ entries per obstacle (default 8)\n"
+           "  --exps N               exp_ entries per obstacle (default 6)\n"
+           "  --rle                  write tile_dat_rle instead of tile_dat\n", MAPGEN_MAX_SIZE);
+}
+
+int main(int argc, char* argv[]) {
+    MapGenParams params;
+    std::string output_filename;
+    bool use_rle = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        int args_left = argc - i - 1;
+        if (arg == "--name" && args_left >= 1)
+            params.name = argv[++i];
+        else if (arg == "--size" && args_left >= 2) {
+            params.width = std::atoi(argv[++i]);
+            params.height = std::atoi(argv[++i]);
+        }
+        else if (arg == "--seed" && args_left >= 1)
+            params.seed = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--corridor" && args_left >= 1)
+            params.corridor_width = std::atoi(argv[++i]);
+        else if (arg == "--density" && args_left >= 1)
+            params.maze_density = std::atof(argv[++i]);
+        else if (arg == "--regions" && args_left >= 1)
+            params.num_regions = std::atoi(argv[++i]);
+        else if (arg == "--conveyors" && args_left >= 1)
+            params.conveyor_fraction = std::atof(argv[++i]);
+        else if (arg == "--obstacles" && args_left >= 1)
+            params.num_obstacles = std::atoi(argv[++i]);
+        else if (arg == "--locs" && args_left >= 1)
+            params.locs_per_obstacle = std::atoi(argv[++i]);
+        else if (arg == "--exps" && args_left >= 1)
+            params.exps_per_obstacle = std::atoi(argv[++i]);
+        else if (arg == "--rle")
+            use_rle = true;
+        else if (arg.size() > 0 && arg[0] != '-' && output_filename.empty())
+            output_filename = arg;
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+    if (output_filename.empty()) {
+        print_usage();
+        return 1;
+    }
+
+    try {
+        GeneratedMap map = generate_map(params);
+        write_map_json(map, params, output_filename, use_rle);
+    }
+    catch (const std::invalid_argument& e) {
+        printf("error: %s\n", e.what());
+        return 1;
+    }
+    printf("wrote %s (%ix%i, seed %u)\n", output_filename.c_str(), params.width, params.height, params.seed);
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "tile_rle.h"
+
+// keeps the keys in file order, so a converted map diffs cleanly against the original
+using ordered_json = nlohmann::ordered_json;
+
+static void print_usage() {
+    printf("usage: openbound_maprle [--decode] input.json output.json\n"
+           "  converts tile_dat to tile_dat_rle (or back with --decode), everything else is copied as is\n");
+}
+
+// "key": padded so the values line up, like the hand made maps
+static void write_key(std::ostream& out, const std::string& indent, const std::string& key, size_t width) {
+    std::string quoted = "\"" + key + "\":";
+    out << indent << quoted << std::string(quoted.size() < width ? width - quoted.size() : 1, ' ');
+}
+
+static void write_tile_rows(std::ostream& out, const std::vector<int>& tiles, int width) {
+    out << "[";
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        if (i > 0 && i % width == 0)
+            out << "\n                   ";
+        out << tiles[i];
+        if (i + 1 < tiles.size())
+            out << ",";
+    }
+    out << "]";
+}
+
+static void write_map(std::ostream& out, const ordered_json& map) {
+    out << "{\n";
+    bool is_first = true;
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        if (!is_first)
+            out << ",\n";
+        is_first = false;
+        write_key(out, "    ", it.key(), 14);
+        if (it.key() == "tile_dat")
+            write_tile_rows(out, it.value().get<std::vector<int>>(), map.at("map_width").get<int>());
+        else if (it.value().is_object()) {
+            out << "{\n";
+            bool is_first_field = true;
+            for (auto field = it.value().begin(); field != it.value().end(); ++field) {
+                if (!is_first_field)
+                    out << ",\n";
+                is_first_field = false;
+                write_key(out, "        ", field.key(), 12);
+                out << field.value().dump();
+            }
+            out << "\n    }";
+        }
+        else
+            out << it.value().dump();
+    }
+    out << "\n}\n";
+}
+
+int main(int argc, char* argv[]) {
+    bool decode = false;
+    std::vector<std::string> filenames;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--decode")
+            decode = true;
+        else if (arg.size() > 0 && arg[0] != '-')
+            filenames.push_back(arg);
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+    if (filenames.size() != 2) {
+        print_usage();
+        return 1;
+    }
+
+    size_t tile_dat_bytes = 0;
+    size_t tile_dat_rle_bytes = 0;
+    try {
+        std::ifstream in(filenames[0]);
+        if (!in)
+            throw std::invalid_argument("could not open " + filenames[0]);
+        ordered_json map = ordered_json::parse(in);
+        int num_tiles = map.at("map_width").get<int>() * map.at("map_height").get<int>();
+
+        // rebuild the object so the converted field stays where the old one was
+        ordered_json converted = ordered_json::object();
+        for (auto it = map.begin(); it != map.end(); ++it) {
+            if (!decode && it.key() == "tile_dat") {
+                std::vector<int> tiles = it.value().get<std::vector<int>>();
+                if (static_cast<int>(tiles.size()) != num_tiles)
+                    throw std::invalid_argument("tile_dat has the wrong number of tiles");
+                converted["tile_dat_rle"] = encode_tile_rle(tiles);
+                tile_dat_bytes = it.value().dump().size();
+                tile_dat_rle_bytes = converted["tile_dat_rle"].get_ref<const std::string&>().size();
+            }
+            else if (decode && it.key() == "tile_dat_rle") {
+                const std::string& text = it.value().get_ref<const std::string&>();
+                TileRunDecoder decoder(text);
+                std::vector<int> tiles(num_tiles);
+                for (int& tile : tiles)
+                    tile = decoder.next();
+                if (!decoder.at_end())
+                    throw std::invalid_argument("tile_dat_rle has more tiles than map_width * map_height");
+                converted["tile_dat"] = tiles;
+                tile_dat_bytes = converted["tile_dat"].dump().size();
+                tile_dat_rle_bytes = text.size();
+            }
+            else
+                converted[it.key()] = it.value();
+        }
+        if (tile_dat_bytes == 0)
+            throw std::invalid_argument(filenames[0] + std::string(" has no ") + (decode ? "tile_dat_rle" : "tile_dat"));
+
+        std::ostringstream text;
+        write_map(text, converted);
+        std::ofstream out(filenames[1]);
+        if (!out)
+            throw std::invalid_argument("could not open " + filenames[1] + " for writing");
+        out << text.str();
+    }
+    catch (const std::exception& e) {
+        printf("error: %s\n", e.what());
+        return 1;
+    }
+    printf("wrote %s (tile_dat %zu bytes, tile_dat_rle %zu bytes)\n", filenames[1].c_str(), tile_dat_bytes,
+           tile_dat_rle_bytes);
+    return 0;
+}